@@ -0,0 +1,169 @@
+/**
+ * @file latency_histogram.hpp
+ * @brief Declares a histogram which records latencies with bounded relative error.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_BENCH_LATENCY_HISTOGRAM_HPP_INCLUDED
+#define PRB_BENCH_LATENCY_HISTOGRAM_HPP_INCLUDED
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace prb::bench
+{
+    /**
+     * A histogram of durations, using the same log-linear bucketing scheme as HdrHistogram.
+     * Values are recorded in nanoseconds. Each power-of-two range is divided into a fixed number
+     *  of linear sub-buckets, so the relative error of any reported value is below 1/64 (about
+     *  1.6%) across the whole 64-bit range, while the histogram has a fixed size of a few
+     *  thousand counters.
+     *
+     * Recording a value is a handful of integer operations and never allocates, so it doesn't
+     *  distort the latencies being measured.
+     */
+    class latency_histogram
+    {
+    public:
+        //------------------------------------------------------------------------------------------
+        // Accessors / operations.
+
+        /// Record a single duration. Negative durations are recorded as zero.
+        void record(std::chrono::nanoseconds value) noexcept
+        {
+            const auto ns{ static_cast<std::uint64_t>(std::max<std::int64_t>(value.count(), 0)) };
+            ++m_counts[bucket_index(ns)];
+            ++m_total;
+            m_min = std::min(m_min, ns);
+            m_max = std::max(m_max, ns);
+        }
+
+        /// Add all of the values recorded by another histogram to this one.
+        void merge(const latency_histogram & other) noexcept
+        {
+            for (std::size_t i{ 0U }; i < bucket_count; ++i)
+                m_counts[i] += other.m_counts[i];
+            m_total += other.m_total;
+            m_min = std::min(m_min, other.m_min);
+            m_max = std::max(m_max, other.m_max);
+        }
+
+        /// Get the number of values which have been recorded.
+        std::uint64_t count() const noexcept
+        {
+            return m_total;
+        }
+
+        /// Get the smallest value which has been recorded, or zero if there are none.
+        std::chrono::nanoseconds min() const noexcept
+        {
+            return std::chrono::nanoseconds{ m_total > 0U ? static_cast<std::int64_t>(m_min) : 0 };
+        }
+
+        /// Get the largest value which has been recorded, or zero if there are none.
+        std::chrono::nanoseconds max() const noexcept
+        {
+            return std::chrono::nanoseconds{ static_cast<std::int64_t>(m_max) };
+        }
+
+        /**
+         * Get the value at a given percentile.
+         * As with HdrHistogram, this reports the highest value which is equivalent to the recorded
+         *  values in the same bucket, capped at the largest recorded value.
+         *
+         * @param percentile The percentile to query, from 0 to 100.
+         * @return Returns the value at or below which the given percentage of values fall. Returns
+         *  zero if no values have been recorded.
+         */
+        std::chrono::nanoseconds percentile(double percentile) const noexcept
+        {
+            if (m_total == 0U)
+                return std::chrono::nanoseconds{ 0 };
+
+            const auto fraction{ std::clamp(percentile, 0.0, 100.0) / 100.0 };
+            auto target{ static_cast<std::uint64_t>(fraction * static_cast<double>(m_total) + 0.5) };
+            target = std::clamp<std::uint64_t>(target, 1U, m_total);
+
+            std::uint64_t cumulative{ 0U };
+            for (std::size_t i{ 0U }; i < bucket_count; ++i)
+            {
+                cumulative += m_counts[i];
+                if (cumulative >= target)
+                {
+                    const auto value{ std::min(highest_equivalent_value(i), m_max) };
+                    return std::chrono::nanoseconds{ static_cast<std::int64_t>(value) };
+                }
+            }
+            return max();
+        }
+
+    private:
+        //------------------------------------------------------------------------------------------
+        // Internal operations.
+
+        /// The number of bits of precision kept for each value.
+        static constexpr unsigned precision_bits{ 7U };
+
+        /// Values below this are recorded exactly.
+        static constexpr std::uint64_t sub_bucket_count{ std::uint64_t{ 1U } << precision_bits };
+
+        /// Each power-of-two range above sub_bucket_count is split into this many buckets.
+        static constexpr std::uint64_t sub_bucket_half{ sub_bucket_count / 2U };
+
+        /// The total number of buckets needed to cover every 64-bit value.
+        static constexpr std::size_t bucket_count{
+            (64U - precision_bits + 2U) * sub_bucket_half
+        };
+
+        /// Get the position of the most significant bit which is set. The value must not be zero.
+        static unsigned most_significant_bit(std::uint64_t value) noexcept
+        {
+            unsigned result{ 0U };
+            while ((value >>= 1U) != 0U)
+                ++result;
+            return result;
+        }
+
+        /// Get the index of the bucket which a value is recorded in.
+        static std::size_t bucket_index(std::uint64_t value) noexcept
+        {
+            if (value < sub_bucket_count)
+                return static_cast<std::size_t>(value);
+            const auto shift{ most_significant_bit(value) - (precision_bits - 1U) };
+            return static_cast<std::size_t>(shift * sub_bucket_half + (value >> shift));
+        }
+
+        /// Get the largest value which would be recorded in the given bucket.
+        static std::uint64_t highest_equivalent_value(std::size_t index) noexcept
+        {
+            if (index < sub_bucket_count)
+                return index;
+            const auto shift{ index / sub_bucket_half - 1U };
+            const auto mantissa{ index - shift * sub_bucket_half };
+            return ((mantissa + 1U) << shift) - 1U;
+        }
+
+
+        //------------------------------------------------------------------------------------------
+        // Data.
+
+        /// The number of values recorded in each bucket.
+        std::array<std::uint64_t, bucket_count> m_counts{};
+
+        /// The total number of values recorded.
+        std::uint64_t m_total{ 0U };
+
+        /// The smallest value recorded.
+        std::uint64_t m_min{ std::numeric_limits<std::uint64_t>::max() };
+
+        /// The largest value recorded.
+        std::uint64_t m_max{ 0U };
+    };
+}
+
+#endif
@@ -0,0 +1,78 @@
+/**
+ * @file parallel.bench.cpp
+ * @brief Micro-benchmarks for the per-element overhead of the cancellable parallel algorithms.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include <benchmark/benchmark.h>
+#include <shared_flag/parallel.hpp>
+#include <shared_flag/shared_flag.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <vector>
+
+using namespace prb;
+
+namespace
+{
+    /// The number of elements processed in each iteration.
+    constexpr std::size_t elements_per_batch{ 1U << 20U };
+}
+
+//--------------------------------------------------------------------------------------------------
+// Overhead.
+
+// Sum a large array in a plain loop, as a baseline for the cost of each element.
+void sequential_sum(benchmark::State & state)
+{
+    std::vector<std::uint32_t> values(elements_per_batch);
+    std::iota(values.begin(), values.end(), 0U);
+
+    for (auto _ : state)
+    {
+        std::uint64_t total{ 0U };
+        for (const auto value : values)
+            total += value;
+        benchmark::DoNotOptimize(total);
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(elements_per_batch));
+}
+
+// Sum the same array with parallel_transform_reduce(). The elements are so cheap that the result
+//  shows how well chunking hides the cost of claiming work and checking the flag.
+void parallel_sum(benchmark::State & state)
+{
+    thread_pool pool{ static_cast<std::size_t>(state.range(0)) };
+    const shared_flag cancel;
+    std::vector<std::uint32_t> values(elements_per_batch);
+    std::iota(values.begin(), values.end(), 0U);
+
+    for (auto _ : state)
+    {
+        const auto total{ parallel_transform_reduce(
+            pool,
+            cancel,
+            values.begin(),
+            values.end(),
+            std::uint64_t{ 0U },
+            std::plus<>{},
+            [](std::uint32_t value) { return std::uint64_t{ value }; }
+        ) };
+        benchmark::DoNotOptimize(total);
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(elements_per_batch));
+}
+
+BENCHMARK(sequential_sum)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(parallel_sum)
+    ->ArgName("threads")
+    ->Arg(1)
+    ->Arg(4)
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,223 @@
+/**
+ * @file shared_flag.bench.cpp
+ * @brief Micro-benchmarks for the basic operations of the shared flag classes.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include <benchmark/benchmark.h>
+#include <shared_flag/compact_shared_flag.hpp>
+#include <shared_flag/shared_flag.hpp>
+#include "waiter_pool.hpp"
+#include <chrono>
+#include <cstddef>
+#include <type_traits>
+
+using namespace std::literals;
+using namespace prb;
+
+namespace
+{
+    /// Create a handle of the specified type which refers to a new flag.
+    template <class Handle>
+    Handle make_handle()
+    {
+        if constexpr (std::is_same_v<Handle, shared_flag_reader>)
+            return shared_flag_reader{ shared_flag{} };
+        else if constexpr (std::is_same_v<Handle, compact_shared_flag_reader>)
+            return compact_shared_flag_reader{ compact_shared_flag{} };
+        else
+            return Handle{};
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+// Construction / destruction.
+
+template <class Flag>
+void construct_and_destroy(benchmark::State & state)
+{
+    for (auto _ : state)
+    {
+        Flag flag;
+        benchmark::DoNotOptimize(flag);
+    }
+}
+
+BENCHMARK_TEMPLATE(construct_and_destroy, shared_flag);
+BENCHMARK_TEMPLATE(construct_and_destroy, compact_shared_flag);
+
+
+//--------------------------------------------------------------------------------------------------
+// Copy / move.
+
+template <class Handle>
+void copy_construct(benchmark::State & state)
+{
+    const auto original{ make_handle<Handle>() };
+    for (auto _ : state)
+    {
+        Handle copy{ original };
+        benchmark::DoNotOptimize(copy);
+    }
+}
+
+BENCHMARK_TEMPLATE(copy_construct, shared_flag);
+BENCHMARK_TEMPLATE(copy_construct, shared_flag_reader);
+BENCHMARK_TEMPLATE(copy_construct, compact_shared_flag);
+BENCHMARK_TEMPLATE(copy_construct, compact_shared_flag_reader);
+
+template <class Handle>
+void copy_assign(benchmark::State & state)
+{
+    const auto original{ make_handle<Handle>() };
+    auto copy{ make_handle<Handle>() };
+    for (auto _ : state)
+    {
+        copy = original;
+        benchmark::DoNotOptimize(copy);
+    }
+}
+
+BENCHMARK_TEMPLATE(copy_assign, shared_flag);
+BENCHMARK_TEMPLATE(copy_assign, shared_flag_reader);
+BENCHMARK_TEMPLATE(copy_assign, compact_shared_flag);
+BENCHMARK_TEMPLATE(copy_assign, compact_shared_flag_reader);
+
+/// Each iteration moves the state from one handle to another and back again.
+template <class Handle>
+void move_assign(benchmark::State & state)
+{
+    auto first{ make_handle<Handle>() };
+    auto second{ make_handle<Handle>() };
+    for (auto _ : state)
+    {
+        second = std::move(first);
+        first = std::move(second);
+        benchmark::DoNotOptimize(first);
+    }
+}
+
+BENCHMARK_TEMPLATE(move_assign, shared_flag);
+BENCHMARK_TEMPLATE(move_assign, shared_flag_reader);
+BENCHMARK_TEMPLATE(move_assign, compact_shared_flag);
+BENCHMARK_TEMPLATE(move_assign, compact_shared_flag_reader);
+
+
+//--------------------------------------------------------------------------------------------------
+// get()
+
+template <class Handle>
+void get_uncontended(benchmark::State & state)
+{
+    const auto flag{ make_handle<Handle>() };
+    for (auto _ : state)
+        benchmark::DoNotOptimize(flag.get());
+}
+
+BENCHMARK_TEMPLATE(get_uncontended, shared_flag_reader);
+BENCHMARK_TEMPLATE(get_uncontended, compact_shared_flag_reader);
+
+/// Every thread polls the same handle. For shared_flag, this contends on the handle's lock bit.
+template <class Flag>
+void get_contended_same_handle(benchmark::State & state)
+{
+    static const Flag shared;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(shared.get());
+}
+
+BENCHMARK_TEMPLATE(get_contended_same_handle, shared_flag)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(get_contended_same_handle, compact_shared_flag)->ThreadRange(1, 8)->UseRealTime();
+
+/// Every thread polls its own handle to the same flag, as a pool of workers would.
+template <class Flag>
+void get_contended_own_handle(benchmark::State & state)
+{
+    static const Flag shared;
+    const Flag flag{ shared };
+    for (auto _ : state)
+        benchmark::DoNotOptimize(flag.get());
+}
+
+BENCHMARK_TEMPLATE(get_contended_own_handle, shared_flag)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(get_contended_own_handle, compact_shared_flag)->ThreadRange(1, 8)->UseRealTime();
+
+//--------------------------------------------------------------------------------------------------
+// set()
+
+/**
+ * Measures the time taken by set() itself, with a given number of threads blocked on the flag.
+ * This includes issuing the wake-ups, but not the time for the waiters to start running.
+ */
+template <class Flag>
+void set_with_waiters(benchmark::State & state)
+{
+    const auto num_waiters{ static_cast<std::size_t>(state.range(0)) };
+    bench::waiter_pool<Flag> waiters{ num_waiters };
+
+    for (auto _ : state)
+    {
+        Flag flag;
+        if (num_waiters > 0U)
+            waiters.arm(flag);
+
+        const auto start{ std::chrono::steady_clock::now() };
+        flag.set();
+        const auto end{ std::chrono::steady_clock::now() };
+        state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+
+        if (num_waiters > 0U)
+            waiters.drain();
+    }
+}
+
+BENCHMARK_TEMPLATE(set_with_waiters, shared_flag)->Arg(0)->UseManualTime();
+BENCHMARK_TEMPLATE(set_with_waiters, shared_flag)->Arg(1)->Arg(8)->Arg(64)->UseManualTime()->Iterations(1000);
+BENCHMARK_TEMPLATE(set_with_waiters, compact_shared_flag)->Arg(0)->UseManualTime();
+BENCHMARK_TEMPLATE(set_with_waiters, compact_shared_flag)->Arg(1)->Arg(8)->Arg(64)->UseManualTime()->Iterations(1000);
+
+
+//--------------------------------------------------------------------------------------------------
+// wait_for()
+
+/// An expired timeout on a clear flag should return without blocking.
+template <class Handle>
+void wait_for_zero_timeout(benchmark::State & state)
+{
+    const auto flag{ make_handle<Handle>() };
+    for (auto _ : state)
+        benchmark::DoNotOptimize(flag.wait_for(0ns));
+}
+
+BENCHMARK_TEMPLATE(wait_for_zero_timeout, shared_flag_reader);
+BENCHMARK_TEMPLATE(wait_for_zero_timeout, compact_shared_flag_reader);
+
+/**
+ * Blocks on a clear flag for a short timeout.
+ * The "overshoot" counter shows how long the call took beyond the requested timeout.
+ */
+template <class Handle>
+void wait_for_timeout(benchmark::State & state)
+{
+    const auto flag{ make_handle<Handle>() };
+    const std::chrono::microseconds timeout{ state.range(0) };
+    std::chrono::steady_clock::duration overshoot{ 0 };
+
+    for (auto _ : state)
+    {
+        const auto start{ std::chrono::steady_clock::now() };
+        benchmark::DoNotOptimize(flag.wait_for(timeout));
+        overshoot += std::chrono::steady_clock::now() - start - timeout;
+    }
+
+    state.counters["overshoot_us"] = benchmark::Counter(
+        std::chrono::duration<double, std::micro>(overshoot).count(),
+        benchmark::Counter::kAvgIterations
+    );
+}
+
+BENCHMARK_TEMPLATE(wait_for_timeout, shared_flag_reader)->Arg(10)->Arg(100)->UseRealTime();
+BENCHMARK_TEMPLATE(wait_for_timeout, compact_shared_flag_reader)->Arg(10)->Arg(100)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,135 @@
+/**
+ * @file thread_pool.bench.cpp
+ * @brief Micro-benchmarks for the task throughput of the thread pool.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include <benchmark/benchmark.h>
+#include <shared_flag/shared_flag.hpp>
+#include <shared_flag/shared_latch_flag.hpp>
+#include <shared_flag/thread_pool.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+using namespace prb;
+
+namespace
+{
+    /// The number of tasks submitted in each iteration.
+    constexpr std::int64_t tasks_per_batch{ 10000 };
+
+    /// A small task, which counts down a latch when it's destroyed, whether or not it ran.
+    class batch_task
+    {
+    public:
+        explicit batch_task(shared_latch_flag * done) noexcept :
+            m_done{ done }
+        {
+        }
+
+        batch_task(batch_task && other) noexcept :
+            m_done{ std::exchange(other.m_done, nullptr) }
+        {
+        }
+
+        batch_task(const batch_task &) = delete;
+        batch_task & operator=(const batch_task &) = delete;
+        batch_task & operator=(batch_task &&) = delete;
+
+        ~batch_task()
+        {
+            if (m_done)
+                m_done->count_down();
+        }
+
+        void operator()() const noexcept
+        {
+            // Stand in for a little real work, so that running a task costs more than discarding it.
+            std::uint64_t value{ 0U };
+            for (std::uint64_t i{ 0U }; i < 256U; ++i)
+            {
+                value += i;
+                benchmark::DoNotOptimize(value);
+            }
+        }
+
+    private:
+        shared_latch_flag * m_done;
+    };
+
+    /// The same task, but taking the reader which the pool passes to it.
+    class batch_flag_task : public batch_task
+    {
+    public:
+        using batch_task::batch_task;
+
+        void operator()(const shared_flag_reader &) const noexcept
+        {
+            batch_task::operator()();
+        }
+    };
+
+    /**
+     * Submit a batch of tasks, and cancel a percentage of them straight afterwards. Cancelled tasks
+     *  which are still queued when a worker reaches them are discarded instead of run.
+     */
+    template <class Task>
+    void run_batches(benchmark::State & state)
+    {
+        const auto cancel_percent{ state.range(0) };
+        const auto thread_count{ static_cast<std::size_t>(state.range(1)) };
+        thread_pool pool{ thread_count };
+        const shared_flag never_cancelled;
+
+        const auto discarded_before{ pool.discarded_count() };
+        for (auto _ : state)
+        {
+            shared_flag cancel;
+            shared_latch_flag done{ tasks_per_batch };
+            for (std::int64_t i{ 0 }; i < tasks_per_batch; ++i)
+            {
+                const bool cancellable{ i % 100 < cancel_percent };
+                pool.submit(cancellable ? cancel : never_cancelled, Task{ &done });
+            }
+            cancel.set();
+            done.wait();
+        }
+
+        state.SetItemsProcessed(state.iterations() * tasks_per_batch);
+        state.counters["discarded"] = benchmark::Counter(
+            static_cast<double>(pool.discarded_count() - discarded_before) /
+                static_cast<double>(state.iterations() * tasks_per_batch),
+            benchmark::Counter::kDefaults
+        );
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+// Throughput.
+
+// Run batches of tasks which don't take a flag.
+void submit_with_cancellation(benchmark::State & state)
+{
+    run_batches<batch_task>(state);
+}
+
+// Run batches of tasks which take a flag. Compared with the above, this shows the cost of giving
+//  each task a flag of its own, which is only linked to the pool's stop flag if the task runs.
+void submit_taking_flag_with_cancellation(benchmark::State & state)
+{
+    run_batches<batch_flag_task>(state);
+}
+
+BENCHMARK(submit_with_cancellation)
+    ->ArgNames({ "cancel%", "threads" })
+    ->ArgsProduct({ { 0, 50, 90 }, { 1, 4 } })
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(submit_taking_flag_with_cancellation)
+    ->ArgNames({ "cancel%", "threads" })
+    ->ArgsProduct({ { 0, 50, 90 }, { 1, 4 } })
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,181 @@
+/**
+ * @file waiter_pool.hpp
+ * @brief Declares a group of threads which repeatedly block on flags, for use in benchmarks.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_BENCH_WAITER_POOL_HPP_INCLUDED
+#define PRB_BENCH_WAITER_POOL_HPP_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace prb::bench
+{
+    /// Determines which function the threads in a waiter_pool use to block on a flag.
+    enum class wait_mode
+    {
+        /// Call wait(), with no timeout.
+        wait,
+
+        /// Call wait_for(), with a timeout long enough that it never expires.
+        wait_for
+    };
+
+    /**
+     * A fixed group of threads which each block on a flag, one round at a time.
+     * The threads are reused between rounds so that thread creation isn't measured. Each thread
+     *  records the time at which it returned from waiting.
+     */
+    template <class Flag>
+    class waiter_pool
+    {
+    public:
+        //------------------------------------------------------------------------------------------
+        // Construction / destruction.
+
+        /**
+         * Start the threads. They don't wait on anything until arm() is called.
+         *
+         * @param num_waiters The number of threads to start.
+         * @param mode Determines how the threads wait on each flag.
+         */
+        explicit waiter_pool(std::size_t num_waiters, wait_mode mode = wait_mode::wait) :
+            m_mode{ mode },
+            m_wake_times(num_waiters)
+        {
+            m_threads.reserve(num_waiters);
+            for (std::size_t i{ 0U }; i < num_waiters; ++i)
+                m_threads.emplace_back([this, i] { run(i); });
+        }
+
+        waiter_pool(const waiter_pool &) = delete;
+        waiter_pool & operator=(const waiter_pool &) = delete;
+
+        /// Stop and join all of the threads. They must not be waiting on a flag.
+        ~waiter_pool()
+        {
+            {
+                std::lock_guard lock{ m_mtx };
+                m_stop = true;
+                ++m_round;
+            }
+            m_cond_var.notify_all();
+            for (auto & thread : m_threads)
+                thread.join();
+        }
+
+
+        //------------------------------------------------------------------------------------------
+        // Accessors / operations.
+
+        /// Get the number of threads in the pool.
+        std::size_t size() const noexcept
+        {
+            return m_threads.size();
+        }
+
+        /**
+         * Give all of the threads a new flag to wait on, and return once they are all blocked.
+         * There's no way to observe a thread being parked, so this gives them a short time to get
+         *  there after they've all started waiting.
+         *
+         * @param flag The flag to wait on. Each thread takes its own copy.
+         * @param settle_time How long to give the threads to block after they've all started
+         *  waiting.
+         */
+        void arm(const Flag & flag, std::chrono::microseconds settle_time = std::chrono::microseconds{ 100 })
+        {
+            m_ready.store(0U, std::memory_order_relaxed);
+            {
+                std::lock_guard lock{ m_mtx };
+                m_flag.emplace(flag);
+                ++m_round;
+            }
+            m_cond_var.notify_all();
+            while (m_ready.load(std::memory_order_acquire) < m_threads.size())
+                std::this_thread::yield();
+            std::this_thread::sleep_for(settle_time);
+        }
+
+        /// Wait until all of the threads have returned from waiting on the current flag.
+        void drain()
+        {
+            while (m_done.load(std::memory_order_acquire) < m_threads.size())
+                std::this_thread::yield();
+            m_done.store(0U, std::memory_order_relaxed);
+        }
+
+        /**
+         * Get the times at which each thread returned from waiting in the last round.
+         * This must only be called after drain().
+         */
+        const std::vector<std::chrono::steady_clock::time_point> & wake_times() const noexcept
+        {
+            return m_wake_times;
+        }
+
+    private:
+        //------------------------------------------------------------------------------------------
+        // Internal operations.
+
+        /// The function executed by each thread.
+        void run(std::size_t index)
+        {
+            std::uint64_t last_round{ 0U };
+            for (;;)
+            {
+                std::optional<Flag> flag;
+                {
+                    std::unique_lock lock{ m_mtx };
+                    m_cond_var.wait(lock, [&] { return m_round != last_round; });
+                    if (m_stop)
+                        return;
+                    last_round = m_round;
+                    flag = m_flag;
+                }
+
+                m_ready.fetch_add(1U, std::memory_order_release);
+                if (m_mode == wait_mode::wait)
+                    flag->wait();
+                else
+                    flag->wait_for(std::chrono::hours{ 1 });
+                m_wake_times[index] = std::chrono::steady_clock::now();
+
+                flag.reset();
+                m_done.fetch_add(1U, std::memory_order_release);
+            }
+        }
+
+
+        //------------------------------------------------------------------------------------------
+        // Data.
+
+        const wait_mode m_mode;
+        std::vector<std::thread> m_threads;
+        std::vector<std::chrono::steady_clock::time_point> m_wake_times;
+
+        /// Protects the members below, which are used to hand out a new flag each round.
+        std::mutex m_mtx;
+        std::condition_variable m_cond_var;
+        std::optional<Flag> m_flag;
+        std::uint64_t m_round{ 0U };
+        bool m_stop{ false };
+
+        /// The number of threads which have started waiting on the current flag.
+        std::atomic<std::size_t> m_ready{ 0U };
+
+        /// The number of threads which have finished waiting on the current flag.
+        std::atomic<std::size_t> m_done{ 0U };
+    };
+}
+
+#endif
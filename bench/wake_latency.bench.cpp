@@ -0,0 +1,211 @@
+/**
+ * @file wake_latency.bench.cpp
+ * @brief Measures how long it takes threads blocked on a shared flag to resume after it is set.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ *
+ * For each group size, this parks that many threads on a flag, sets it, and records how long each
+ *  thread took to return from wait() or wait_for() after set() was called. This is repeated for a
+ *  number of rounds, with a new flag each time.
+ *
+ * Usage:
+ *
+ *      shared_flag.wake_latency [--waiters=1,10,100,1000,10000] [--rounds=1000]
+ *          [--max-wakes=2000000] [--mode=wait|wait_for] [--handle=shared|compact]
+ *
+ * The number of rounds for large groups is reduced so that no group records more than max-wakes
+ *  samples, otherwise the largest groups take a very long time on machines with few cores.
+ */
+
+#include <shared_flag/compact_shared_flag.hpp>
+#include <shared_flag/shared_flag.hpp>
+#include "latency_histogram.hpp"
+#include "waiter_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace prb;
+
+namespace
+{
+    /// The settings for a run, as given on the command line.
+    struct options
+    {
+        std::vector<std::size_t> waiters{ 1U, 10U, 100U, 1000U, 10000U };
+        std::size_t rounds{ 1000U };
+        std::size_t max_wakes{ 2000000U };
+        bench::wait_mode mode{ bench::wait_mode::wait };
+        bool compact{ false };
+    };
+
+    /// The results for one group size.
+    struct group_result
+    {
+        std::size_t waiters{ 0U };
+        std::size_t rounds{ 0U };
+
+        /// The time from calling set() to each thread returning from its wait.
+        bench::latency_histogram latency;
+
+        /// The time between the first and last thread returning from its wait in each round.
+        bench::latency_histogram spread;
+    };
+
+    /// Parse a comma-separated list of positive integers.
+    std::vector<std::size_t> parse_list(std::string_view text)
+    {
+        std::vector<std::size_t> result;
+        while (!text.empty())
+        {
+            const auto comma{ std::min(text.find(','), text.size()) };
+            const auto value{ std::stoull(std::string{ text.substr(0U, comma) }) };
+            if (value == 0U)
+                throw std::invalid_argument{ "Values must be greater than zero." };
+            result.push_back(static_cast<std::size_t>(value));
+            text.remove_prefix(std::min(comma + 1U, text.size()));
+        }
+        return result;
+    }
+
+    /// Parse the command line arguments.
+    options parse_options(int argc, char * argv[])
+    {
+        options result;
+        for (int i{ 1 }; i < argc; ++i)
+        {
+            const std::string_view arg{ argv[i] };
+            const auto value{ arg.substr(std::min(arg.find('=') + 1U, arg.size())) };
+
+            if (arg.rfind("--waiters=", 0U) == 0U)
+                result.waiters = parse_list(value);
+            else if (arg.rfind("--rounds=", 0U) == 0U)
+                result.rounds = parse_list(value).at(0U);
+            else if (arg.rfind("--max-wakes=", 0U) == 0U)
+                result.max_wakes = parse_list(value).at(0U);
+            else if (arg == "--mode=wait")
+                result.mode = bench::wait_mode::wait;
+            else if (arg == "--mode=wait_for")
+                result.mode = bench::wait_mode::wait_for;
+            else if (arg == "--handle=shared")
+                result.compact = false;
+            else if (arg == "--handle=compact")
+                result.compact = true;
+            else
+                throw std::invalid_argument{ "Unrecognised argument: " + std::string{ arg } };
+        }
+        return result;
+    }
+
+    /// Park a group of threads on a new flag repeatedly, and record how long they take to wake.
+    template <class Flag>
+    group_result measure(std::size_t num_waiters, std::size_t rounds, bench::wait_mode mode)
+    {
+        group_result result;
+        result.waiters = num_waiters;
+        result.rounds = rounds;
+
+        bench::waiter_pool<Flag> waiters{ num_waiters, mode };
+
+        // Larger groups need longer to get from "about to wait" to actually blocked.
+        const std::chrono::microseconds settle_time{ 200 + static_cast<long>(num_waiters) * 2 };
+
+        for (std::size_t round{ 0U }; round < rounds; ++round)
+        {
+            Flag flag;
+            waiters.arm(flag, settle_time);
+
+            const auto set_time{ std::chrono::steady_clock::now() };
+            flag.set();
+            waiters.drain();
+
+            const auto & wake_times{ waiters.wake_times() };
+            const auto [first, last] = std::minmax_element(wake_times.begin(), wake_times.end());
+            for (const auto wake_time : wake_times)
+                result.latency.record(wake_time - set_time);
+            result.spread.record(*last - *first);
+        }
+
+        return result;
+    }
+
+    /// Convert a duration to fractional microseconds, for display.
+    double to_us(std::chrono::nanoseconds value)
+    {
+        return std::chrono::duration<double, std::micro>(value).count();
+    }
+
+    /// Print a heading for the table of results.
+    void print_heading(const options & opts)
+    {
+        std::printf(
+            "Set-to-wake latency using %s::%s(). All times are in microseconds.\n\n",
+            opts.compact ? "compact_shared_flag" : "shared_flag",
+            opts.mode == bench::wait_mode::wait ? "wait" : "wait_for"
+        );
+        std::printf(
+            "%8s %7s %9s | %9s %9s %9s %9s | %9s %9s %9s\n",
+            "waiters", "rounds", "samples",
+            "p50", "p99", "p99.9", "max",
+            "spread50", "spread99", "spreadmax"
+        );
+    }
+
+    /// Print one row of the table of results.
+    void print_row(const group_result & result)
+    {
+        std::printf(
+            "%8zu %7zu %9llu | %9.1f %9.1f %9.1f %9.1f | %9.1f %9.1f %9.1f\n",
+            result.waiters,
+            result.rounds,
+            static_cast<unsigned long long>(result.latency.count()),
+            to_us(result.latency.percentile(50.0)),
+            to_us(result.latency.percentile(99.0)),
+            to_us(result.latency.percentile(99.9)),
+            to_us(result.latency.max()),
+            to_us(result.spread.percentile(50.0)),
+            to_us(result.spread.percentile(99.0)),
+            to_us(result.spread.max())
+        );
+        std::fflush(stdout);
+    }
+
+    template <class Flag>
+    void run(const options & opts)
+    {
+        print_heading(opts);
+        for (const auto num_waiters : opts.waiters)
+        {
+            const auto rounds{ std::max<std::size_t>(
+                1U,
+                std::min(opts.rounds, opts.max_wakes / num_waiters)
+            ) };
+            print_row(measure<Flag>(num_waiters, rounds, opts.mode));
+        }
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    try
+    {
+        const auto opts{ parse_options(argc, argv) };
+        if (opts.compact)
+            run<compact_shared_flag>(opts);
+        else
+            run<shared_flag>(opts);
+    }
+    catch (const std::exception & ex)
+    {
+        std::fprintf(stderr, "Error: %s\n", ex.what());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,438 @@
+/**
+ * @file async_wait.hpp
+ * @brief Declares C++20 coroutine awaitables which suspend until a shared flag is set.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_ASYNC_WAIT_HPP_INCLUDED
+#define PRB_ASYNC_WAIT_HPP_INCLUDED
+
+#if !defined(__cpp_impl_coroutine) || !__has_include(<coroutine>)
+#   error "async_wait.hpp requires C++20 coroutine support."
+#endif
+
+#include "detail/deadline.hpp"
+#include "detail/flag_listener.hpp"
+#include "detail/flag_state.hpp"
+#include "detail/handle_traits.hpp"
+#include "detail/state_access.hpp"
+#include "detail/state_ptr.hpp"
+#include "detail/timer_service.hpp"
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+/*
+ * These awaitables let a coroutine wait for a flag without blocking the thread it's running on.
+ *  The coroutine is suspended, and resumed when the flag is set. Suspending doesn't allocate
+ *  memory or use any threads, so a single thread can have any number of coroutines waiting.
+ *
+ * The simplest form is to await a flag handle directly. The coroutine is resumed by the thread
+ *  which sets the flag, before set() returns:
+ *
+ * @code
+ *      co_await cancelled;
+ * @endcode
+ *
+ * Usually, the coroutine should be resumed on its own executor instead. An executor can be any
+ *  object which is callable with a std::coroutine_handle<>, and which arranges for the handle to
+ *  be resumed. It's called by the thread which sets the flag (or by the timer thread, if a timeout
+ *  expires), so it should queue the handle and return quickly. It must not throw.
+ *
+ * @code
+ *      // Resume on the server's event loop, or after 5 seconds if the flag isn't set by then.
+ *      const bool cancelled{ co_await async_wait_for(request_cancelled, 5s, loop_executor) };
+ * @endcode
+ *
+ * Timeouts are handled by a single shared timer thread, which is started when it's first needed.
+ *
+ * If a suspended coroutine is destroyed, its wait is cancelled safely. Any mixture of shared_flag,
+ *  shared_flag_reader, compact_shared_flag, and compact_shared_flag_reader can be awaited.
+ */
+
+namespace prb
+{
+    /// An executor which resumes a coroutine immediately, on the thread which calls it.
+    struct inline_executor
+    {
+        /// Resume the coroutine.
+        void operator()(std::coroutine_handle<> handle) const noexcept
+        {
+            handle.resume();
+        }
+    };
+
+    /**
+     * An awaitable which suspends the awaiting coroutine until a flag is set.
+     * Use async_wait() or co_await on a flag handle to create this.
+     *
+     * @tparam Executor The type of executor which resumes the coroutine.
+     */
+    template <class Executor>
+    class flag_awaiter : private detail::flag_listener
+    {
+        static_assert(
+            std::is_invocable_v<Executor &, std::coroutine_handle<>>,
+            "The executor must be callable with a std::coroutine_handle<>."
+        );
+
+    public:
+        //------------------------------------------------------------------------------------------
+        // Construction / destruction.
+
+        /**
+         * Construct an awaitable for the specified shared state.
+         *
+         * @param state The state of the flag to wait on. It must not be empty.
+         * @param executor Resumes the coroutine once the flag has been set.
+         */
+        flag_awaiter(detail::state_ptr state, Executor executor) :
+            detail::flag_listener{ &on_set },
+            m_state{ std::move(state) },
+            m_executor(std::move(executor))
+        {
+        }
+
+        flag_awaiter(const flag_awaiter &) = delete;
+        flag_awaiter & operator=(const flag_awaiter &) = delete;
+        flag_awaiter(flag_awaiter &&) = delete;
+        flag_awaiter & operator=(flag_awaiter &&) = delete;
+
+        /**
+         * The destructor deregisters the awaitable from the flag.
+         * This happens if the coroutine is destroyed while it's suspended.
+         */
+        ~flag_awaiter()
+        {
+            m_state->remove_listener(*this);
+        }
+
+
+        //------------------------------------------------------------------------------------------
+        // Accessors / operations.
+
+        /// Check if the flag has already been set, meaning the coroutine needn't be suspended.
+        bool await_ready() const noexcept
+        {
+            return m_state->is_set();
+        }
+
+        /**
+         * Register to resume the coroutine when the flag is set.
+         *
+         * @param handle The coroutine which is being suspended.
+         * @return Returns true if the coroutine should stay suspended. Returns false if the flag
+         *  was set in the meantime, in which case the coroutine continues straight away.
+         */
+        bool await_suspend(std::coroutine_handle<> handle) noexcept
+        {
+            m_handle = handle;
+
+            // Once this has been registered, another thread may resume the coroutine (and destroy
+            //  this object) at any moment, so nothing can be touched afterwards.
+            return m_state->add_listener(*this);
+        }
+
+        /// Called when the coroutine resumes. The flag is always set by then.
+        void await_resume() const noexcept
+        {
+        }
+
+    private:
+        //------------------------------------------------------------------------------------------
+        // Internal operations.
+
+        /// Called by the shared state when the flag is set.
+        static void on_set(detail::flag_listener & listener) noexcept
+        {
+            auto & self{ static_cast<flag_awaiter &>(listener) };
+            self.m_executor(self.m_handle);
+        }
+
+
+        //------------------------------------------------------------------------------------------
+        // Data.
+
+        /// Keeps the shared state alive while the coroutine is waiting on it.
+        detail::state_ptr m_state;
+
+        /// Resumes the coroutine once the flag has been set.
+        Executor m_executor;
+
+        /// The coroutine which is suspended.
+        std::coroutine_handle<> m_handle{};
+    };
+
+    /**
+     * An awaitable which suspends the awaiting coroutine until a flag is set or a deadline passes.
+     * Use async_wait_for() or async_wait_until() to create this.
+     *
+     * The flag and the timer race to resume the coroutine. Whichever gets there first resumes it
+     *  via the executor, and the other does nothing.
+     *
+     * @tparam Executor The type of executor which resumes the coroutine.
+     */
+    template <class Executor>
+    class timed_flag_awaiter : private detail::flag_listener, private detail::timer_entry
+    {
+        static_assert(
+            std::is_invocable_v<Executor &, std::coroutine_handle<>>,
+            "The executor must be callable with a std::coroutine_handle<>."
+        );
+
+    public:
+        //------------------------------------------------------------------------------------------
+        // Construction / destruction.
+
+        /**
+         * Construct an awaitable for the specified shared state.
+         *
+         * @param state The state of the flag to wait on. It must not be empty.
+         * @param deadline Resume the coroutine at this time if the flag hasn't been set by then.
+         * @param executor Resumes the coroutine once the flag has been set or the deadline passes.
+         */
+        timed_flag_awaiter(
+            detail::state_ptr state,
+            std::chrono::steady_clock::time_point deadline,
+            Executor executor
+        ) :
+            detail::flag_listener{ &on_set },
+            detail::timer_entry{ &on_timeout },
+            m_state{ std::move(state) },
+            m_deadline{ deadline },
+            m_executor(std::move(executor))
+        {
+        }
+
+        timed_flag_awaiter(const timed_flag_awaiter &) = delete;
+        timed_flag_awaiter & operator=(const timed_flag_awaiter &) = delete;
+        timed_flag_awaiter(timed_flag_awaiter &&) = delete;
+        timed_flag_awaiter & operator=(timed_flag_awaiter &&) = delete;
+
+        /**
+         * The destructor cancels the timer and deregisters the awaitable from the flag.
+         * If either of them is resuming the coroutine on another thread, this waits for it to
+         *  return from the executor.
+         */
+        ~timed_flag_awaiter()
+        {
+            if (m_deadline != detail::no_deadline)
+                detail::timer_service::instance().cancel(*this);
+            m_state->remove_listener(*this);
+        }
+
+
+        //------------------------------------------------------------------------------------------
+        // Accessors / operations.
+
+        /// Check if the flag has been set or the deadline has passed.
+        bool await_ready() const noexcept
+        {
+            return m_state->is_set() || (
+                m_deadline != detail::no_deadline &&
+                std::chrono::steady_clock::now() >= m_deadline
+            );
+        }
+
+        /**
+         * Register to resume the coroutine when the flag is set or the deadline passes.
+         *
+         * @param handle The coroutine which is being suspended.
+         * @return Returns true if the coroutine should stay suspended. Returns false if the flag
+         *  was set or the timer expired in the meantime, in which case the coroutine continues
+         *  straight away.
+         */
+        bool await_suspend(std::coroutine_handle<> handle) noexcept
+        {
+            m_handle = handle;
+            if (m_deadline != detail::no_deadline)
+                detail::timer_service::instance().schedule(*this, m_deadline);
+            if (!m_state->add_listener(*this))
+                m_status.fetch_or(fired_bit, std::memory_order_acq_rel);
+
+            // Either callback may have run already. If so, it left the coroutine for this to
+            //  continue. Otherwise, once set_up_bit is visible, nothing else can be touched here.
+            const auto previous{ m_status.fetch_or(set_up_bit, std::memory_order_acq_rel) };
+            return (previous & fired_bit) == 0U;
+        }
+
+        /**
+         * Called when the coroutine resumes.
+         *
+         * @return Returns true if the flag has been set. Returns false if the deadline passed first.
+         */
+        bool await_resume() const noexcept
+        {
+            return m_state->is_set();
+        }
+
+    private:
+        //------------------------------------------------------------------------------------------
+        // Internal operations.
+
+        /// Resume the coroutine, unless something else has already claimed it.
+        void fire() noexcept
+        {
+            const auto previous{ m_status.fetch_or(fired_bit, std::memory_order_acq_rel) };
+            if ((previous & fired_bit) != 0U)
+                return;
+
+            // If await_suspend() hasn't finished yet then it will see fired_bit, and won't
+            //  suspend the coroutine in the first place.
+            if ((previous & set_up_bit) != 0U)
+                m_executor(m_handle);
+        }
+
+        /// Called by the shared state when the flag is set.
+        static void on_set(detail::flag_listener & listener) noexcept
+        {
+            static_cast<timed_flag_awaiter &>(listener).fire();
+        }
+
+        /// Called by the timer service when the deadline passes.
+        static void on_timeout(detail::timer_entry & timer) noexcept
+        {
+            static_cast<timed_flag_awaiter &>(timer).fire();
+        }
+
+
+        //------------------------------------------------------------------------------------------
+        // Data.
+
+        /// Bit in m_status indicating that await_suspend() has finished registering.
+        static constexpr std::uint8_t set_up_bit{ 1U };
+
+        /// Bit in m_status indicating that the flag was set or the deadline passed.
+        static constexpr std::uint8_t fired_bit{ 2U };
+
+        /// Keeps the shared state alive while the coroutine is waiting on it.
+        detail::state_ptr m_state;
+
+        /// The time at which to resume the coroutine if the flag hasn't been set.
+        const std::chrono::steady_clock::time_point m_deadline;
+
+        /// Resumes the coroutine once the flag has been set or the deadline passes.
+        Executor m_executor;
+
+        /// The coroutine which is suspended.
+        std::coroutine_handle<> m_handle{};
+
+        /// Decides which of await_suspend() and the two callbacks resumes the coroutine.
+        std::atomic<std::uint8_t> m_status{ 0U };
+    };
+
+
+    //----------------------------------------------------------------------------------------------
+    // Awaitable factories.
+
+    /**
+     * Suspend the awaiting coroutine until a flag is set, then resume it via an executor.
+     * If the flag has already been set then the coroutine isn't suspended.
+     *
+     * @param flag The flag to wait on.
+     * @param executor Resumes the coroutine once the flag has been set.
+     * @return Returns an awaitable. Awaiting it returns nothing.
+     * @throw std::logic_error The flag does not have a reference to a shared state. This happens
+     *  if it has been moved away.
+     */
+    template <
+        class Flag,
+        class Executor = inline_executor,
+        std::enable_if_t<detail::is_flag_handle_v<Flag>, int> = 0
+    >
+    flag_awaiter<Executor> async_wait(const Flag & flag, Executor executor = {})
+    {
+        return flag_awaiter<Executor>{ detail::state_access::get(flag), std::move(executor) };
+    }
+
+    /**
+     * Suspend the awaiting coroutine until a flag is set or a time point is reached, then resume
+     *  it via an executor.
+     * If the flag has already been set, or the time point has passed, then the coroutine isn't
+     *  suspended.
+     *
+     * @param flag The flag to wait on.
+     * @param timeout_time The time point at which to stop waiting. It's converted to an
+     *  equivalent steady clock deadline when this is called, so later adjustments to a non-steady
+     *  clock aren't taken into account.
+     * @param executor Resumes the coroutine once the flag has been set or the time is reached.
+     * @return Returns an awaitable. Awaiting it returns true if the flag was set, or false if the
+     *  time point was reached first.
+     * @throw std::logic_error The flag does not have a reference to a shared state. This happens
+     *  if it has been moved away.
+     */
+    template <
+        class Flag,
+        class Clock,
+        class Duration,
+        class Executor = inline_executor,
+        std::enable_if_t<detail::is_flag_handle_v<Flag>, int> = 0
+    >
+    timed_flag_awaiter<Executor> async_wait_until(
+        const Flag & flag,
+        const std::chrono::time_point<Clock, Duration> & timeout_time,
+        Executor executor = {}
+    )
+    {
+        const auto deadline{ detail::deadline_at(timeout_time) };
+        return timed_flag_awaiter<Executor>{
+            detail::state_access::get(flag), deadline, std::move(executor)
+        };
+    }
+
+    /**
+     * Suspend the awaiting coroutine until a flag is set or a period of time has elapsed, then
+     *  resume it via an executor.
+     * If the flag has already been set, or the timeout is zero or negative, then the coroutine
+     *  isn't suspended.
+     *
+     * @param flag The flag to wait on.
+     * @param timeout_duration The maximum period of time to wait for.
+     * @param executor Resumes the coroutine once the flag has been set or the time has elapsed.
+     * @return Returns an awaitable. Awaiting it returns true if the flag was set, or false if the
+     *  timeout elapsed first.
+     * @throw std::logic_error The flag does not have a reference to a shared state. This happens
+     *  if it has been moved away.
+     */
+    template <
+        class Flag,
+        class Rep,
+        class Period,
+        class Executor = inline_executor,
+        std::enable_if_t<detail::is_flag_handle_v<Flag>, int> = 0
+    >
+    timed_flag_awaiter<Executor> async_wait_for(
+        const Flag & flag,
+        const std::chrono::duration<Rep, Period> & timeout_duration,
+        Executor executor = {}
+    )
+    {
+        return timed_flag_awaiter<Executor>{
+            detail::state_access::get(flag),
+            detail::deadline_after(timeout_duration),
+            std::move(executor)
+        };
+    }
+
+    /**
+     * Suspend the awaiting coroutine until a flag is set.
+     * The coroutine is resumed by the thread which sets the flag, before set() returns. Use
+     *  async_wait() to resume it via an executor instead.
+     */
+    inline flag_awaiter<inline_executor> operator co_await(const shared_flag_reader & flag)
+    {
+        return async_wait(flag);
+    }
+
+    /// @copydoc operator co_await(const shared_flag_reader &)
+    inline flag_awaiter<inline_executor> operator co_await(const compact_shared_flag_reader & flag)
+    {
+        return async_wait(flag);
+    }
+}
+
+#endif
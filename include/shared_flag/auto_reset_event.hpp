@@ -0,0 +1,264 @@
+/**
+ * @file auto_reset_event.hpp
+ * @brief Declares handles to a shared event which releases one waiting thread each time it's set.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_AUTO_RESET_EVENT_HPP_INCLUDED
+#define PRB_AUTO_RESET_EVENT_HPP_INCLUDED
+
+#include "detail/deadline.hpp"
+#include "detail/event_state.hpp"
+#include "detail/state_ptr.hpp"
+#include <chrono>
+#include <stdexcept>
+
+namespace prb
+{
+    /**
+     * A handle which can wait on a shared auto-reset event.
+     * Each time the event is set, it releases exactly one waiting thread, and that thread resets it
+     *  again. If no thread is waiting then the event stays set until one arrives. Setting an event
+     *  which is already set has no effect, so several calls to set() before anybody waits only
+     *  release one thread.
+     *
+     * This is useful for handing work to one of a pool of threads, or for passing control back and
+     *  forth between two threads, without allocating anything per hand-over.
+     *
+     * Waiting on the event changes it, so the term "reader" means that this handle can't set the
+     *  event, rather than that it can't modify it.
+     *
+     * This follows the same thread-safety rules as compact_shared_flag_reader. Any number of
+     *  threads can use different instances which refer to the same event. If one thread modifies
+     *  an instance (e.g. by assigning to it) then no other thread may access that instance at the
+     *  same time.
+     *
+     * This class must be copied from an instance of auto_reset_event.
+     */
+    class auto_reset_event_reader
+    {
+    public:
+        //------------------------------------------------------------------------------------------
+        // Construction / destruction.
+
+        /**
+         * Copy constructor -- copies a reference to the shared state of an existing instance.
+         *
+         * @param other An existing instance to copy a shared state reference from. This can be an
+         *  instance of auto_reset_event or auto_reset_event_reader.
+         */
+        auto_reset_event_reader(const auto_reset_event_reader & other) noexcept = default;
+
+        /// Copy assignment -- copies a reference to the shared state of an existing instance.
+        auto_reset_event_reader & operator=(const auto_reset_event_reader & other) noexcept = default;
+
+        /**
+         * Move constructor -- acquires the shared state reference from another instance.
+         * Afterwards, the other instance will no longer have a reference to the shared state.
+         */
+        auto_reset_event_reader(auto_reset_event_reader && other) noexcept = default;
+
+        /// Move assignment -- acquires the shared state reference from another instance.
+        auto_reset_event_reader & operator=(auto_reset_event_reader && other) noexcept = default;
+
+        /**
+         * The destructor releases this instance's reference to the shared state, if it has one.
+         * This is deliberately not virtual, as with compact_shared_flag_reader.
+         */
+        ~auto_reset_event_reader() = default;
+
+
+        //------------------------------------------------------------------------------------------
+        // Accessors / operations.
+
+        /**
+         * Check if this instance contains a reference to a shared state.
+         *
+         * @return Returns true if this object contains a reference to a shared state. Returns false
+         *  if the reference has been moved away.
+         */
+        bool valid() const noexcept
+        {
+            return static_cast<bool>(m_state);
+        }
+
+        /**
+         * Reset the event if it's set, without blocking.
+         *
+         * @return Returns true if the event was set, in which case the caller has consumed it.
+         *  Returns false otherwise.
+         * @throw std::logic_error This instance does not contain a reference to a shared state.
+         *  This happens if the contents of this object have been moved away.
+         */
+        bool try_wait() const
+        {
+            return checked_state().try_wait();
+        }
+
+        /**
+         * Block the current thread until it's released by the event.
+         * This will return immediately if the event is already set. Either way, the event is reset
+         *  before this returns.
+         *
+         * @throw std::logic_error This instance does not contain a reference to a shared state.
+         *  This happens if the contents of this object have been moved away.
+         */
+        void wait() const;
+
+        /**
+         * Block the current thread until it's released by the event, or the specified time has
+         *  elapsed.
+         *
+         * @param timeout_duration The maximum period of time to block for.
+         * @return Returns true if the thread was released, in which case the event has been reset.
+         *  Returns false if the timeout expired first.
+         * @throw std::logic_error This instance does not contain a reference to a shared state.
+         *  This happens if the contents of this object have been moved away.
+         */
+        template <class Rep, class Period>
+        bool wait_for(const std::chrono::duration<Rep, Period> & timeout_duration) const
+        {
+            return checked_state().wait_until(detail::deadline_after(timeout_duration), 0U);
+        }
+
+        /**
+         * Block the current thread until it's released by the event, or the specified time is
+         *  reached.
+         * If the time point is not measured by the steady clock then the clock is re-checked each
+         *  time the thread wakes up, in case it has been adjusted.
+         *
+         * @param timeout_time The maximum time point to block until.
+         * @return Returns true if the thread was released, in which case the event has been reset.
+         *  Returns false if the time point was reached first.
+         * @throw std::logic_error This instance does not contain a reference to a shared state.
+         *  This happens if the contents of this object have been moved away.
+         */
+        template <class Clock, class Duration>
+        bool wait_until(const std::chrono::time_point<Clock, Duration> & timeout_time) const
+        {
+            auto & state{ checked_state() };
+            return detail::wait_until_deadline(timeout_time, [&](std::chrono::steady_clock::time_point deadline)
+            {
+                return state.wait_until(deadline, 0U);
+            });
+        }
+
+    protected:
+        //------------------------------------------------------------------------------------------
+        // Internal operations.
+
+        /**
+         * Construct an instance which refers to the specified shared state.
+         * This is used by auto_reset_event to create new states.
+         */
+        explicit auto_reset_event_reader(detail::event_state_ptr state) noexcept;
+
+        /**
+         * Get the shared state referenced by this instance.
+         *
+         * @throw std::logic_error This instance does not contain a reference to a shared state.
+         */
+        detail::event_state & checked_state() const
+        {
+            if (!m_state)
+                throw std::logic_error{ "Shared state has been moved away." };
+            return *m_state;
+        }
+
+
+        //------------------------------------------------------------------------------------------
+        // Data.
+
+        /**
+         * A pointer to the shared state referenced by this instance.
+         * This will be null if the shared state was moved away.
+         */
+        detail::event_state_ptr m_state;
+    };
+
+    /**
+     * A handle which can set, reset, and wait on a shared auto-reset event.
+     * See auto_reset_event_reader for details.
+     *
+     * Example of passing control back and forth between two threads:
+     *
+     * @code
+     *      auto_reset_event ping;
+     *      auto_reset_event pong;
+     *      std::thread other{ [ping, pong]() mutable
+     *      {
+     *          for (int i = 0; i < 100; ++i)
+     *          {
+     *              ping.wait();
+     *              pong.set();
+     *          }
+     *      } };
+     *
+     *      for (int i = 0; i < 100; ++i)
+     *      {
+     *          ping.set();
+     *          pong.wait();
+     *      }
+     *      other.join();
+     * @endcode
+     */
+    class auto_reset_event final : public auto_reset_event_reader
+    {
+    public:
+        //------------------------------------------------------------------------------------------
+        // Construction / destruction.
+
+        /**
+         * Constructor -- generates and stores a reference to a new shared state.
+         *
+         * @param initially_set Determines whether the event starts off set.
+         */
+        explicit auto_reset_event(bool initially_set = false);
+
+        /// Copy constructor -- copies a reference to the shared state of an existing instance.
+        auto_reset_event(const auto_reset_event & other) noexcept = default;
+
+        /// Copy assignment -- copies a reference to the shared state of an existing instance.
+        auto_reset_event & operator=(const auto_reset_event & other) noexcept = default;
+
+        /// Move constructor -- acquires the shared state reference from another instance.
+        auto_reset_event(auto_reset_event && other) noexcept = default;
+
+        /// Move assignment -- acquires the shared state reference from another instance.
+        auto_reset_event & operator=(auto_reset_event && other) noexcept = default;
+
+        /// The destructor releases this instance's reference to the shared state, if it has one.
+        ~auto_reset_event() = default;
+
+
+        //------------------------------------------------------------------------------------------
+        // Accessors / operations.
+
+        /**
+         * Set the event, releasing one waiting thread if there are any.
+         * If no thread is waiting then the event stays set until one arrives. This does nothing if
+         *  the event was already set.
+         *
+         * @throw std::logic_error This instance does not have a reference to a shared state. This
+         *  happens if it has been moved away.
+         */
+        void set()
+        {
+            checked_state().set();
+        }
+
+        /**
+         * Reset the event without releasing a thread, if it was set.
+         *
+         * @throw std::logic_error This instance does not have a reference to a shared state. This
+         *  happens if it has been moved away.
+         */
+        void reset()
+        {
+            checked_state().reset();
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,38 @@
+/**
+ * @file child_of.hpp
+ * @brief Declares a tag which selects the constructors that link a new flag to parent flags.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_CHILD_OF_HPP_INCLUDED
+#define PRB_CHILD_OF_HPP_INCLUDED
+
+namespace prb
+{
+    /**
+     * Tag type which selects the constructors of shared_flag and compact_shared_flag that create a
+     *  child flag. A child flag is set automatically when any of its parents are set.
+     *
+     * This is useful for building a hierarchy of cancellation signals, without dedicating a thread
+     *  to each level:
+     *
+     * @code
+     *      shared_flag shutdown;
+     *      shared_flag session{ child_of, shutdown };
+     *      shared_flag request{ child_of, session, request_timeout };
+     *
+     *      // This sets session and request too.
+     *      shutdown.set();
+     * @endcode
+     */
+    struct child_of_t
+    {
+        explicit child_of_t() = default;
+    };
+
+    /// Pass this as the first constructor argument of a flag to make it a child of other flags.
+    inline constexpr child_of_t child_of{};
+}
+
+#endif
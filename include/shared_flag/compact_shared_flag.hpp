@@ -0,0 +1,196 @@
+/**
+ * @file compact_shared_flag.hpp
+ * @brief Declares a lightweight handle which can read and write the state of a shared flag.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_COMPACT_SHARED_FLAG_HPP_INCLUDED
+#define PRB_COMPACT_SHARED_FLAG_HPP_INCLUDED
+
+#include "detail/handle_traits.hpp"
+#include "detail/state_access.hpp"
+#include "detail/state_ptr.hpp"
+#include "child_of.hpp"
+#include "compact_shared_flag_reader.hpp"
+#include <type_traits>
+
+namespace prb
+{
+    class shared_flag;
+
+    /**
+     * A lightweight handle which can set, query, and wait on the state of a shared boolean flag.
+     * This is an alternative to shared_flag for code which stores or copies a large number of
+     *  handles, or which queries the flag in a tight loop.
+     *
+     * Like std::shared_ptr, the handle itself is not internally synchronised. Any number of threads
+     *  can safely use different instances which refer to the same flag, or call const functions on
+     *  the same instance. If one thread modifies an instance (e.g. by assigning to it) then no
+     *  other thread may access that instance at the same time. See compact_shared_flag_reader for
+     *  more details.
+     *
+     * Example of using the flag to terminate a worker thread:
+     *
+     * @code
+     *      auto task = [](compact_shared_flag_reader flag)
+     *      {
+     *          while (!flag)
+     *          {
+     *              // Do work here.
+     *          }
+     *      };
+     *
+     *      compact_shared_flag flag;
+     *      std::thread task_thread{ task, flag };
+     *      flag.set();
+     *      task_thread.join();
+     * @endcode
+     */
+    class compact_shared_flag final : public compact_shared_flag_reader
+    {
+    public:
+        //------------------------------------------------------------------------------------------
+        // Construction / destruction.
+
+        /**
+         * Default constructor -- generates and stores a reference to a new shared state.
+         */
+        compact_shared_flag();
+
+        /**
+         * Constructor -- generates and stores a reference to a new shared state, with a specific
+         *  default spin policy.
+         *
+         * @param policy Determines how long threads waiting on the flag busy-wait before blocking.
+         */
+        explicit compact_shared_flag(const spin_policy & policy);
+
+        /**
+         * Constructor -- generates a new shared state which is a child of one or more other flags.
+         * The new flag is set automatically when any of its parents are set, including when their
+         *  own parents are set. If a parent has already been set then the new flag is set straight
+         *  away. The new flag can also be set by itself, which doesn't affect its parents.
+         *
+         * Propagation is synchronous, and doesn't use any threads: a parent's set() function
+         *  doesn't return until all of its descendants have been set. The links are removed
+         *  automatically when the new shared state is destroyed. Until then, they keep the parents'
+         *  shared states alive.
+         *
+         * Example of a flag which is set if either of two other flags is set:
+         *
+         * @code
+         *      compact_shared_flag child{ child_of, parent1, parent2 };
+         * @endcode
+         *
+         * @param parents The flags to link to. Any mixture of shared_flag, shared_flag_reader,
+         *  compact_shared_flag, and compact_shared_flag_reader can be used.
+         * @throw std::logic_error One of the parents does not have a reference to a shared state.
+         *  This happens if it has been moved away.
+         */
+        template <class... Parents, std::enable_if_t<detail::are_flag_handles_v<Parents...>, int> = 0>
+        compact_shared_flag(child_of_t, const Parents &... parents) :
+            compact_shared_flag_reader{ detail::make_child_state({ detail::state_access::get(parents)... }) }
+        {
+        }
+
+        /**
+         * Conversion constructor -- copies a reference to the shared state of a shared_flag.
+         * Afterwards, this instance and the other instance will both have a reference to the same
+         *  shared state. That means both can set, query, and wait on the same flag.
+         *
+         * @param other An existing instance to copy a shared state reference from. It must contain
+         *  a reference to a shared state; i.e. it must not have been moved away.
+         * @throw std::logic_error The other instance does not have a reference to a shared state.
+         *  This happens if it has been moved away.
+         */
+        explicit compact_shared_flag(const shared_flag & other);
+
+        /// Copy constructor -- copies a reference to the shared state of an existing instance.
+        compact_shared_flag(const compact_shared_flag & other) noexcept = default;
+
+        /// Copy assignment -- copies a reference to the shared state of an existing instance.
+        compact_shared_flag & operator=(const compact_shared_flag & other) noexcept = default;
+
+        /// Move constructor -- acquires the shared state reference from another instance.
+        compact_shared_flag(compact_shared_flag && other) noexcept = default;
+
+        /// Move assignment -- acquires the shared state reference from another instance.
+        compact_shared_flag & operator=(compact_shared_flag && other) noexcept = default;
+
+        /// Promoting a compact_shared_flag_reader to a compact_shared_flag is not permitted.
+        compact_shared_flag(const compact_shared_flag_reader &) = delete;
+
+        /// Promoting a compact_shared_flag_reader to a compact_shared_flag is not permitted.
+        compact_shared_flag & operator=(const compact_shared_flag_reader &) = delete;
+
+        /// Promoting a compact_shared_flag_reader to a compact_shared_flag is not permitted.
+        compact_shared_flag(compact_shared_flag_reader &&) = delete;
+
+        /// Promoting a compact_shared_flag_reader to a compact_shared_flag is not permitted.
+        compact_shared_flag & operator=(compact_shared_flag_reader &&) = delete;
+
+        /**
+         * The destructor releases this instance's reference to the shared state, if it has one.
+         * If it was the last reference to the shared state then the state is deleted.
+         */
+        ~compact_shared_flag() = default;
+
+
+        //------------------------------------------------------------------------------------------
+        // Accessors / operations.
+
+        /**
+         * Set the flag and wake any threads which are waiting on it.
+         * This does nothing if the flag was already set.
+         *
+         * @throw std::logic_error This instance does not have a reference to a shared state. This
+         *  happens if it has been moved away.
+         */
+        void set()
+        {
+            checked_state().set();
+        }
+
+        /**
+         * Set the flag with a reason, and wake any threads which are waiting on it.
+         * See shared_flag::set(const T &) for details.
+         *
+         * @param reason A small trivially copyable value, such as an enumerator or std::error_code.
+         * @throw std::logic_error This instance does not have a reference to a shared state. This
+         *  happens if it has been moved away.
+         */
+        template <class T>
+        void set(const T & reason)
+        {
+            checked_state().set(reason);
+        }
+
+#if defined(__linux__)
+        /**
+         * Set the flag from a signal handler.
+         * Unlike set(), this is async-signal-safe. It doesn't lock anything, allocate memory, or
+         *  throw, and it preserves errno. Threads which are blocked on the flag are woken
+         *  straight away if the futex backend is in use.
+         *
+         * Listeners, such as flag_callback, wait_any(), and child flags, are notified by a
+         *  background thread instead, as are blocked threads with the condition variable backend.
+         *  Call start_signal_dispatch() before installing the signal handler to start that thread.
+         *
+         * The handle must not be modified while the signal handler could be using it. Keep a
+         *  compact_shared_flag rather than a shared_flag for this, because reading a shared_flag
+         *  takes a brief lock, which could deadlock if the signal interrupts its owner.
+         *
+         * This does nothing if the flag was already set, or if this instance does not contain a
+         *  reference to a shared state.
+         */
+        void set_from_signal() noexcept
+        {
+            if (m_state)
+                m_state->set_from_signal();
+        }
+#endif
+    };
+}
+
+#endif
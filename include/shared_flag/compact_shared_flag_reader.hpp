@@ -0,0 +1,309 @@
+/**
+ * @file compact_shared_flag_reader.hpp
+ * @brief Declares a lightweight handle which can read the state of a shared flag.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_COMPACT_SHARED_FLAG_READER_HPP_INCLUDED
+#define PRB_COMPACT_SHARED_FLAG_READER_HPP_INCLUDED
+
+#include "detail/flag_state.hpp"
+#include "detail/state_access.hpp"
+#include "detail/state_ptr.hpp"
+#include "spin_policy.hpp"
+#include <chrono>
+#include <optional>
+#include <stdexcept>
+
+namespace prb
+{
+    class shared_flag_reader;
+
+    /**
+     * A lightweight handle which can read and wait on the state of a shared boolean flag.
+     * This is an alternative to shared_flag_reader for code which stores or copies a large number
+     *  of handles, or which queries the flag in a tight loop.
+     *
+     * The difference is that this class follows the same thread-safety rules as std::shared_ptr:
+     *  - Any number of threads can safely query and wait on the same flag via different instances
+     *     which refer to the same shared state.
+     *  - Multiple threads can safely call const functions on the same instance at the same time.
+     *  - However, if one thread modifies an instance (e.g. by assigning to it or moving from it)
+     *     then no other thread may access that instance at the same time.
+     *
+     * In return, an instance is no bigger than the pointer to its shared state, it has no virtual
+     *  functions, and no operation needs to lock the handle itself. Querying the flag is a single
+     *  atomic load.
+     *
+     * As with shared_flag_reader, this class can only read the state of a flag. It must be copied
+     *  from an instance of compact_shared_flag, or converted from an instance of shared_flag_reader.
+     *  It is not possible to construct or assign a compact_shared_flag from a
+     *  compact_shared_flag_reader.
+     *
+     * Example of giving lots of tasks a handle to the same flag:
+     *
+     * @code
+     *      compact_shared_flag flag;
+     *      for (auto & task : tasks)
+     *          task.cancelled = flag;  // <-- task.cancelled is a compact_shared_flag_reader
+     *
+     *      // Cancel all of the tasks.
+     *      flag.set();
+     * @endcode
+     */
+    class compact_shared_flag_reader
+    {
+    public:
+        //------------------------------------------------------------------------------------------
+        // Construction / destruction.
+
+        /**
+         * Conversion constructor -- copies a reference to the shared state of a shared_flag_reader.
+         * Afterwards, this instance and the other instance will both have a reference to the same
+         *  shared state. That means both can query and wait on the same flag.
+         *
+         * @param other An existing instance to copy a shared state reference from. This can be an
+         *  instance of shared_flag or shared_flag_reader. It must contain a reference to a shared
+         *  state; i.e. it must not have been moved away.
+         * @throw std::logic_error The other instance does not have a reference to a shared state.
+         *  This happens if it has been moved away.
+         */
+        explicit compact_shared_flag_reader(const shared_flag_reader & other);
+
+        /**
+         * Copy constructor -- copies a reference to the shared state of an existing instance.
+         * Afterwards, this instance and the other instance will both have a reference to the same
+         *  shared state. If the other instance has no shared state then neither will this one.
+         *
+         * @param other An existing instance to copy a shared state reference from. This can be an
+         *  instance of compact_shared_flag or compact_shared_flag_reader.
+         */
+        compact_shared_flag_reader(const compact_shared_flag_reader & other) noexcept = default;
+
+        /**
+         * Copy assignment -- copies a reference to the shared state of an existing instance.
+         * If this instance previously had a reference to a shared state then it will have been
+         *  released first.
+         *
+         * @param other An existing instance to copy a shared state reference from. This can be an
+         *  instance of compact_shared_flag or compact_shared_flag_reader.
+         * @return Returns a reference to this instance.
+         */
+        compact_shared_flag_reader & operator=(const compact_shared_flag_reader & other) noexcept = default;
+
+        /**
+         * Move constructor -- acquires the shared state reference from another instance.
+         * Afterwards, the other instance will no longer have a reference to the shared state.
+         *
+         * @param other An existing instance to move a shared state reference from. This can be an
+         *  instance of compact_shared_flag or compact_shared_flag_reader.
+         */
+        compact_shared_flag_reader(compact_shared_flag_reader && other) noexcept = default;
+
+        /**
+         * Move assignment -- acquires the shared state reference from another instance.
+         * Afterwards, the other instance will no longer have a reference to the shared state. If
+         *  this instance previously had a reference to a shared state then it will have been
+         *  released first.
+         *
+         * @param other An existing instance to move a shared state reference from. This can be an
+         *  instance of compact_shared_flag or compact_shared_flag_reader.
+         * @return Returns a reference to this instance.
+         */
+        compact_shared_flag_reader & operator=(compact_shared_flag_reader && other) noexcept = default;
+
+        /**
+         * The destructor releases this instance's reference to the shared state, if it has one.
+         * If it was the last reference to the shared state then the state is deleted.
+         *
+         * @note This is deliberately not virtual. Instances should never be deleted via a pointer
+         *  to this class if they are actually instances of compact_shared_flag.
+         */
+        ~compact_shared_flag_reader() = default;
+
+
+        //------------------------------------------------------------------------------------------
+        // Accessors / operations.
+
+        /**
+         * Check if this instance contains a reference to a shared state.
+         *
+         * @return Returns true if this object contains a reference to a shared state. Returns false
+         *  if the reference has been moved away.
+         */
+        bool valid() const noexcept
+        {
+            return static_cast<bool>(m_state);
+        }
+
+        /**
+         * Check if the flag has been set.
+         *
+         * @return Returns true if the flag has been set. Returns false otherwise.
+         * @throw std::logic_error This instance does not contain a reference to a shared state.
+         *  This happens if the contents of this object have been moved away.
+         */
+        bool get() const
+        {
+            return checked_state().is_set();
+        }
+
+        /**
+         * Check if the flag has been set.
+         * This is a convenience wrapper around get(). It allows this object to be used as part of a
+         *  boolean condition.
+         *
+         * @return Returns true if the flag has been set. Returns false otherwise.
+         * @throw std::logic_error This instance does not contain a reference to a shared state.
+         *  This happens if the contents of this object have been moved away.
+         */
+        operator bool() const
+        {
+            return get();
+        }
+
+        /**
+         * Get the reason the flag was set, if it was set with one.
+         * See shared_flag_reader::reason() for details.
+         *
+         * @tparam T The type of reason which was passed to set().
+         * @return Returns a copy of the reason. Returns an empty optional if the flag hasn't been
+         *  set yet, if it was set without a reason, or if the reason was of a different type.
+         * @throw std::logic_error This instance does not contain a reference to a shared state.
+         *  This happens if the contents of this object have been moved away.
+         */
+        template <class T>
+        std::optional<T> reason() const
+        {
+            return checked_state().reason<T>();
+        }
+
+#if defined(__linux__)
+        /// The type of handle returned by native_handle().
+        using native_handle_type = int;
+
+        /**
+         * Get a file descriptor which becomes readable when the flag is set.
+         * This is a Linux eventfd which can be watched by epoll(), poll(), or select(). See
+         *  shared_flag_reader::native_handle() for details.
+         *
+         * @return Returns the descriptor. It must not be read from or closed.
+         * @throw std::logic_error This instance does not contain a reference to a shared state.
+         *  This happens if the contents of this object have been moved away.
+         * @throw std::system_error The eventfd could not be created.
+         */
+        native_handle_type native_handle() const
+        {
+            return checked_state().native_handle();
+        }
+#endif
+
+        /**
+         * Block the current thread until the flag has been set.
+         * This will return immediately if the flag was already set.
+         *
+         * @param policy Optionally determines how long the thread busy-waits before blocking. If
+         *  this is omitted then the flag's default spin policy is used.
+         * @throw std::logic_error This instance does not contain a reference to a shared state.
+         *  This happens if the contents of this object have been moved away.
+         */
+        void wait() const;
+
+        /// @copydoc wait()
+        void wait(const spin_policy & policy) const;
+
+        /**
+         * Block the current thread until the flag has been set or the specified time has elapsed.
+         * This will return immediately if the flag was already set.
+         *
+         * @param timeout_duration The maximum period of time to block for.
+         * @param policy Optionally determines how long the thread busy-waits before blocking. If
+         *  this is omitted then the flag's default spin policy is used.
+         * @return Returns true if the flag has been set. Returns false if the flag had not been set
+         *  when the timeout expired.
+         * @throw std::logic_error This instance does not contain a reference to a shared state.
+         *  This happens if the contents of this object have been moved away.
+         */
+        template <class Rep, class Period>
+        bool wait_for(const std::chrono::duration<Rep, Period> & timeout_duration) const
+        {
+            return checked_state().wait_for(timeout_duration);
+        }
+
+        /// @copydoc wait_for(const std::chrono::duration<Rep, Period> &) const
+        template <class Rep, class Period>
+        bool wait_for(
+            const std::chrono::duration<Rep, Period> & timeout_duration,
+            const spin_policy & policy
+        ) const
+        {
+            return checked_state().wait_for(timeout_duration, policy);
+        }
+
+        /**
+         * Block the current thread until the flag has been set or the specified time is reached.
+         * This will return immediately if the flag was already set.
+         *
+         * @param timeout_time The maximum time point to block until.
+         * @param policy Optionally determines how long the thread busy-waits before blocking. If
+         *  this is omitted then the flag's default spin policy is used.
+         * @return Returns true if the flag has been set. Returns false if the flag had not been set
+         *  when the time point was reached.
+         * @throw std::logic_error This instance does not contain a reference to a shared state.
+         *  This happens if the contents of this object have been moved away.
+         */
+        template <class Clock, class Duration>
+        bool wait_until(const std::chrono::time_point<Clock, Duration> & timeout_time) const
+        {
+            return checked_state().wait_until(timeout_time);
+        }
+
+        /// @copydoc wait_until(const std::chrono::time_point<Clock, Duration> &) const
+        template <class Clock, class Duration>
+        bool wait_until(
+            const std::chrono::time_point<Clock, Duration> & timeout_time,
+            const spin_policy & policy
+        ) const
+        {
+            return checked_state().wait_until(timeout_time, policy);
+        }
+
+    protected:
+        //------------------------------------------------------------------------------------------
+        // Internal operations.
+
+        /**
+         * Construct an instance which refers to the specified shared state.
+         * This is used by compact_shared_flag to create new states.
+         */
+        explicit compact_shared_flag_reader(detail::state_ptr state) noexcept;
+
+        /**
+         * Get the shared state referenced by this instance.
+         *
+         * @throw std::logic_error This instance does not contain a reference to a shared state.
+         */
+        detail::flag_state & checked_state() const
+        {
+            if (!m_state)
+                throw std::logic_error{ "Shared state has been moved away." };
+            return *m_state;
+        }
+
+
+        //------------------------------------------------------------------------------------------
+        // Data.
+
+        // Allow library components to access the shared state.
+        friend struct detail::state_access;
+
+        /**
+         * A pointer to the shared state referenced by this instance.
+         * This will be null if the shared state was moved away.
+         */
+        detail::state_ptr m_state;
+    };
+}
+
+#endif
@@ -0,0 +1,171 @@
+/**
+ * @file composite_flag.hpp
+ * @brief Declares a read-only flag which is set when any of a changeable group of flags is set.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_COMPOSITE_FLAG_HPP_INCLUDED
+#define PRB_COMPOSITE_FLAG_HPP_INCLUDED
+
+#include "detail/handle_traits.hpp"
+#include "detail/state_access.hpp"
+#include "detail/state_ptr.hpp"
+#include "compact_shared_flag_reader.hpp"
+#include "shared_flag_reader.hpp"
+#include <type_traits>
+
+namespace prb
+{
+    /**
+     * A read-only flag which is set as soon as any one of a group of source flags is set.
+     * Sources can be attached and detached at any time. For example, a job could stop if its own
+     *  timeout expires, if the user cancels it, or if the application is shutting down.
+     *
+     * This is the inverse of constructing a flag with child_of. Instead of fixing its parents when
+     *  it's constructed, a composite flag lets other code change them later.
+     *
+     * The composite has its own shared state. Each attached source holds a link to it, and sets it
+     *  synchronously when the source is set. Querying the composite is therefore a single atomic
+     *  load, no matter how many sources it has. Detaching a source doesn't clear the composite if
+     *  it has already been set.
+     *
+     * Copying a composite_flag shares the same state, including its group of sources. Attaching or
+     *  detaching via one copy affects all of them. It can also be passed anywhere that expects a
+     *  shared_flag_reader; a reader copied from it sees the composite flag, but can't change its
+     *  sources. The sources stay attached until they're detached or the shared state is destroyed.
+     *
+     * Example of a job which can be stopped for several reasons:
+     *
+     * @code
+     *      composite_flag stop{ shutdown, user_cancel };
+     *      stop.attach(job_timeout);
+     *      run_job(stop);
+     * @endcode
+     *
+     * @warning Don't attach composite flags to each other in a cycle. Each link keeps its source's
+     *  state alive, so the states in a cycle would never be destroyed.
+     *
+     * @note All operations are thread-safe. Multiple threads can attach and detach sources at the
+     *  same time, including from within a callback which runs when a flag is set.
+     */
+    class composite_flag final : public shared_flag_reader
+    {
+    public:
+        //------------------------------------------------------------------------------------------
+        // Construction / destruction.
+
+        /**
+         * Default constructor -- generates a new shared state with no sources.
+         * The flag won't be set until a source is attached and set.
+         */
+        composite_flag();
+
+        /**
+         * Constructor -- generates a new shared state, and attaches the specified sources to it.
+         * If any source has already been set then the new flag is set immediately.
+         *
+         * @param sources The flags to attach. Any mixture of shared_flag, shared_flag_reader,
+         *  compact_shared_flag, and compact_shared_flag_reader can be used. To attach another
+         *  composite_flag, convert it to a shared_flag_reader first; otherwise it's copied.
+         * @throw std::logic_error One of the sources does not have a reference to a shared state.
+         *  This happens if it has been moved away.
+         */
+        template <class... Sources, std::enable_if_t<detail::are_flag_handles_v<Sources...>, int> = 0>
+        explicit composite_flag(const Sources &... sources) :
+            shared_flag_reader{ detail::make_child_state({ detail::state_access::get(sources)... }) }
+        {
+        }
+
+        /**
+         * Copy constructor -- copies a reference to the shared state of an existing instance.
+         * Both instances then refer to the same flag and the same group of sources.
+         *
+         * @param other An existing instance to copy a shared state reference from. It must not have
+         *  been moved away.
+         * @throw std::logic_error The other instance does not have a reference to a shared state.
+         *  This happens if it has been moved away.
+         */
+        composite_flag(const composite_flag & other);
+
+        /**
+         * Copy assignment -- copies a reference to the shared state of an existing instance.
+         * If this instance previously had a reference to a shared state then it will have been
+         *  released first. That doesn't detach any of its sources.
+         *
+         * @param other An existing instance to copy a shared state reference from. It must not have
+         *  been moved away.
+         * @return Returns a reference to this instance.
+         * @throw std::logic_error The other instance does not have a reference to a shared state.
+         *  This happens if it has been moved away.
+         */
+        composite_flag & operator=(const composite_flag & other);
+
+        /**
+         * Move constructor -- acquires the shared state reference from another instance.
+         * The other instance cannot be used after that unless another reference is copied or
+         *  assigned into it.
+         */
+        composite_flag(composite_flag && other) noexcept;
+
+        /**
+         * Move assignment -- acquires the shared state reference from another instance.
+         * The other instance cannot be used after that unless another reference is copied or
+         *  assigned into it.
+         *
+         * @return Returns a reference to this instance.
+         */
+        composite_flag & operator=(composite_flag && other) noexcept;
+
+        /// Assigning a shared_flag_reader to a composite_flag is not permitted.
+        composite_flag & operator=(const shared_flag_reader &) = delete;
+
+        /// Assigning a shared_flag_reader to a composite_flag is not permitted.
+        composite_flag & operator=(shared_flag_reader &&) = delete;
+
+        /**
+         * The destructor releases this instance's reference to the shared state, if it has one.
+         * If it was the last reference to the shared state then the state is deleted, and all of
+         *  its sources are detached.
+         */
+        ~composite_flag() override;
+
+
+        //------------------------------------------------------------------------------------------
+        // Accessors / operations.
+
+        /**
+         * Attach a source flag, so that setting it sets this flag.
+         * If the source has already been set then this flag is set before this returns.
+         * The same source can be attached more than once. Each attachment must be detached
+         *  separately.
+         *
+         * @param source The flag to attach. This can be an instance of shared_flag or
+         *  shared_flag_reader.
+         * @throw std::logic_error This instance or the source does not have a reference to a shared
+         *  state. This happens if it has been moved away.
+         */
+        void attach(const shared_flag_reader & source);
+
+        /// @copydoc attach(const shared_flag_reader &)
+        void attach(const compact_shared_flag_reader & source);
+
+        /**
+         * Detach a source flag, so that setting it no longer sets this flag.
+         * If the source is being set on another thread at the same time, this waits until it has
+         *  finished setting this flag. This flag isn't cleared if it has already been set.
+         *
+         * @param source A flag which was previously attached. This can be any handle which refers
+         *  to the same shared state as the one which was attached.
+         * @return Returns true if the source was detached. Returns false if it wasn't attached.
+         * @throw std::logic_error This instance or the source does not have a reference to a shared
+         *  state. This happens if it has been moved away.
+         */
+        bool detach(const shared_flag_reader & source);
+
+        /// @copydoc detach(const shared_flag_reader &)
+        bool detach(const compact_shared_flag_reader & source);
+    };
+}
+
+#endif
@@ -0,0 +1,62 @@
+/**
+ * @file deadline_flag.hpp
+ * @brief Declares functions which create shared flags that set themselves at a deadline.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_DEADLINE_FLAG_HPP_INCLUDED
+#define PRB_DEADLINE_FLAG_HPP_INCLUDED
+
+#include "detail/deadline.hpp"
+#include "deadline_reached.hpp"
+#include "shared_flag.hpp"
+#include <chrono>
+
+namespace prb
+{
+    /**
+     * Create a shared flag which sets itself when a deadline is reached.
+     * All deadline flags are managed by a single background thread, which keeps them in a
+     *  hierarchical timing wheel. Arming and cancelling a deadline take constant time, however
+     *  many are armed, so it's fine to give every request its own timeout flag.
+     *
+     * The flag is set with a deadline_reached reason. It may be set up to a millisecond or so
+     *  after the deadline, but never before it. It can also be set early like any other flag, in
+     *  which case the timer is cancelled straight away. The timer is also cancelled if every
+     *  handle to the flag is released before the deadline, so finished requests don't linger in
+     *  the timing wheel.
+     *
+     * A deadline flag is an ordinary shared_flag. It can be combined with other flags, e.g.
+     *  to stop a request when either its session ends or its time runs out:
+     *
+     * @code
+     *      shared_flag request_stop{ child_of, session_stop, make_deadline_flag(start + 30s) };
+     * @endcode
+     *
+     * @param deadline The time point at which to set the flag. If it has already passed then the
+     *  flag is set before this returns.
+     * @return Returns a new flag which will be set at the deadline.
+     * @throw std::bad_alloc The flag's state or timer could not be allocated.
+     *
+     * @note Callbacks and child flags attached to the flag are called on the timer thread when
+     *  the deadline is reached. They should return quickly, so that other deadlines aren't delayed.
+     */
+    shared_flag make_deadline_flag(std::chrono::steady_clock::time_point deadline);
+
+    /**
+     * Create a shared flag which sets itself when a timeout has elapsed.
+     * This converts the timeout to a deadline, and calls make_deadline_flag().
+     *
+     * @param timeout_duration The period of time after which to set the flag.
+     * @return Returns a new flag which will be set when the timeout has elapsed.
+     * @throw std::bad_alloc The flag's state or timer could not be allocated.
+     */
+    template <class Rep, class Period>
+    shared_flag make_timeout_flag(const std::chrono::duration<Rep, Period> & timeout_duration)
+    {
+        return make_deadline_flag(detail::deadline_after(timeout_duration));
+    }
+}
+
+#endif
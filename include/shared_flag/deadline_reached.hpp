@@ -0,0 +1,27 @@
+/**
+ * @file deadline_reached.hpp
+ * @brief Declares the reason given when a deadline flag sets itself.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_DEADLINE_REACHED_HPP_INCLUDED
+#define PRB_DEADLINE_REACHED_HPP_INCLUDED
+
+namespace prb
+{
+    /**
+     * The reason given when a deadline flag is set because its deadline was reached.
+     * This lets workers tell a timeout apart from other reasons for stopping:
+     *
+     * @code
+     *      if (flag.reason<deadline_reached>())
+     *          report_timeout();
+     * @endcode
+     */
+    struct deadline_reached
+    {
+    };
+}
+
+#endif
@@ -0,0 +1,192 @@
+/**
+ * @file atomic_state_ptr.hpp
+ * @brief Declares a thread-safe owning pointer to the shared state of a flag.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_DETAIL_ATOMIC_STATE_PTR_HPP_INCLUDED
+#define PRB_DETAIL_ATOMIC_STATE_PTR_HPP_INCLUDED
+
+#include "flag_state.hpp"
+#include "state_ptr.hpp"
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <utility>
+
+namespace prb::detail
+{
+    /**
+     * An owning pointer to a flag_state which can safely be read and modified by multiple threads.
+     * This is similar to std::atomic<std::shared_ptr<>> in C++20, and it uses the same technique as
+     *  common implementations of that: the pointer and a lock bit are stored in a single atomic
+     *  word. The lock bit is only held for the few instructions needed to copy or swap the pointer.
+     *  It's never held while blocking, or while running anything which could block.
+     *
+     * That means:
+     *  - Threads which copy the pointer out (e.g. to wait on the state) don't block threads which
+     *     replace it, and vice versa.
+     *  - Every operation is noexcept.
+     *  - The pointer is no bigger than a raw pointer.
+     *
+     * States are aligned to a cache line, so the low bits of their address are always zero. The
+     *  lowest bit is used as the lock.
+     */
+    class atomic_state_ptr
+    {
+    public:
+        //------------------------------------------------------------------------------------------
+        // Construction / destruction.
+
+        /// Default constructor -- creates an empty pointer.
+        atomic_state_ptr() noexcept = default;
+
+        /// Take ownership of the reference held by a non-atomic pointer.
+        explicit atomic_state_ptr(state_ptr state) noexcept :
+            m_value{ to_value(state.release()) }
+        {
+        }
+
+        atomic_state_ptr(const atomic_state_ptr &) = delete;
+        atomic_state_ptr & operator=(const atomic_state_ptr &) = delete;
+        atomic_state_ptr(atomic_state_ptr &&) = delete;
+        atomic_state_ptr & operator=(atomic_state_ptr &&) = delete;
+
+        /// The destructor releases the reference held by this instance, if there is one.
+        ~atomic_state_ptr()
+        {
+            state_ptr{ to_state(m_value.load(std::memory_order_acquire)) };
+        }
+
+
+        //------------------------------------------------------------------------------------------
+        // Accessors / operations.
+
+        /**
+         * Get a new reference to the state pointed to by this instance.
+         * The returned pointer keeps the state alive even if this instance is reassigned.
+         *
+         * @return Returns a pointer to the state. This will be empty if this instance is empty.
+         */
+        state_ptr load() const noexcept
+        {
+            auto * const state{ lock() };
+            state_ptr result{ state_ptr::share(state) };
+            unlock(state);
+            return result;
+        }
+
+        /**
+         * Replace the state pointed to by this instance.
+         * The previous reference is released after the lock has been released.
+         *
+         * @param state The new state to point to. This can be empty.
+         */
+        void store(state_ptr state) noexcept
+        {
+            exchange(std::move(state));
+        }
+
+        /**
+         * Replace the state pointed to by this instance, and return the previous state.
+         *
+         * @param state The new state to point to. This can be empty.
+         * @return Returns the state which this instance previously pointed to.
+         */
+        state_ptr exchange(state_ptr state) noexcept
+        {
+            auto * const previous{ lock() };
+            m_value.store(to_value(state.release()), std::memory_order_release);
+            return state_ptr{ previous };
+        }
+
+        /**
+         * Call a function with a pointer to the state, while holding the lock.
+         * This avoids modifying the reference count, so it's cheaper than load() for very short
+         *  operations. The function must not block, and must not access this instance.
+         *
+         * @param function The function to call. It will receive a pointer to the state, which will
+         *  be null if this instance is empty.
+         * @return Returns whatever the function returns.
+         */
+        template <class Function>
+        decltype(auto) visit(Function && function) const
+        {
+            auto * const state{ lock() };
+            struct unlocker
+            {
+                const atomic_state_ptr & m_ptr;
+                flag_state * m_state;
+                ~unlocker() { m_ptr.unlock(m_state); }
+            } guard{ *this, state };
+            return std::forward<Function>(function)(state);
+        }
+
+        /**
+         * Get the state pointer without taking the lock or a reference.
+         * This is only safe if no other thread can replace this instance's pointer at the same
+         *  time. The state is then kept alive by the reference which this instance holds.
+         *
+         * @return Returns the state, or null if this instance is empty.
+         */
+        flag_state * get_unlocked() const noexcept
+        {
+            return to_state(m_value.load(std::memory_order_acquire));
+        }
+
+    private:
+        //------------------------------------------------------------------------------------------
+        // Internal operations.
+
+        /// Bit in m_value which indicates that the pointer is locked.
+        static constexpr std::uintptr_t lock_bit{ 1U };
+
+        static_assert(alignof(flag_state) > lock_bit, "The lock bit must not overlap state addresses.");
+
+        /// Convert a state pointer to the representation stored in m_value.
+        static std::uintptr_t to_value(flag_state * state) noexcept
+        {
+            return reinterpret_cast<std::uintptr_t>(state);
+        }
+
+        /// Convert the representation stored in m_value to a state pointer.
+        static flag_state * to_state(std::uintptr_t value) noexcept
+        {
+            return reinterpret_cast<flag_state *>(value & ~lock_bit);
+        }
+
+        /**
+         * Acquire the lock bit.
+         * The lock is only ever held for a handful of instructions, so this spins rather than
+         *  blocking. It yields between attempts in case the holder has been pre-empted.
+         *
+         * @return Returns the state pointer which is protected by the lock.
+         */
+        flag_state * lock() const noexcept
+        {
+            auto value{ m_value.fetch_or(lock_bit, std::memory_order_acquire) };
+            while ((value & lock_bit) != 0U)
+            {
+                std::this_thread::yield();
+                value = m_value.fetch_or(lock_bit, std::memory_order_acquire);
+            }
+            return to_state(value);
+        }
+
+        /// Release the lock bit, without changing the pointer.
+        void unlock(flag_state * state) const noexcept
+        {
+            m_value.store(to_value(state), std::memory_order_release);
+        }
+
+
+        //------------------------------------------------------------------------------------------
+        // Data.
+
+        /// The pointer to the state, combined with the lock bit.
+        mutable std::atomic<std::uintptr_t> m_value{ 0U };
+    };
+}
+
+#endif
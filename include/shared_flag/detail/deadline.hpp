@@ -0,0 +1,117 @@
+/**
+ * @file deadline.hpp
+ * @brief Declares helpers which convert timeouts to steady clock deadlines.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_DETAIL_DEADLINE_HPP_INCLUDED
+#define PRB_DETAIL_DEADLINE_HPP_INCLUDED
+
+#include <chrono>
+
+namespace prb::detail
+{
+    /// A steady clock deadline which means there is no time limit.
+    inline constexpr std::chrono::steady_clock::time_point no_deadline{
+        std::chrono::steady_clock::time_point::max()
+    };
+
+    /**
+     * Convert a relative timeout to an absolute steady clock deadline.
+     * Timeouts which are too long to represent are converted to an indefinite wait.
+     *
+     * @param timeout_duration The timeout to convert. If this is zero or negative then the
+     *  deadline is the current time.
+     * @return Returns the equivalent deadline, or no_deadline if the timeout is too long.
+     */
+    template <class Rep, class Period>
+    std::chrono::steady_clock::time_point deadline_after(
+        const std::chrono::duration<Rep, Period> & timeout_duration
+    )
+    {
+        using std::chrono::steady_clock;
+
+        const auto now{ steady_clock::now() };
+        if (timeout_duration <= timeout_duration.zero())
+            return now;
+
+        // Compare in floating point to avoid overflowing when converting very long timeouts.
+        const std::chrono::duration<double> remaining{ steady_clock::time_point::max() - now };
+        if (std::chrono::duration<double>{ timeout_duration } >= remaining)
+            return no_deadline;
+
+        return now + std::chrono::ceil<steady_clock::duration>(timeout_duration);
+    }
+
+    /**
+     * Convert a time point on any clock to an equivalent steady clock deadline.
+     * The conversion is only done once, so it won't follow later adjustments to a non-steady
+     *  clock. Use wait_until_deadline() where that matters.
+     *
+     * @param timeout_time The time point to convert.
+     * @return Returns the equivalent deadline, or no_deadline if the time point is too far away to
+     *  represent.
+     */
+    template <class Clock, class Duration>
+    std::chrono::steady_clock::time_point deadline_at(
+        const std::chrono::time_point<Clock, Duration> & timeout_time
+    )
+    {
+        using floating_seconds = std::chrono::duration<double>;
+
+        const auto now{ Clock::now() };
+        const auto remaining{
+            floating_seconds{ timeout_time.time_since_epoch() } -
+            floating_seconds{ now.time_since_epoch() }
+        };
+        if (remaining >= floating_seconds{ std::chrono::steady_clock::duration::max() } / 2)
+            return no_deadline;
+        if (remaining <= floating_seconds::zero())
+            return std::chrono::steady_clock::now();
+        return deadline_after(timeout_time - now);
+    }
+
+    /**
+     * Repeat a timed wait operation until it succeeds or a time point on any clock is reached.
+     * The time point is converted to a steady clock deadline before each attempt. If the time
+     *  point isn't measured by the steady clock then the clock is re-checked each time the attempt
+     *  times out, in case it has been adjusted.
+     *
+     * @param timeout_time The maximum time point to wait until.
+     * @param attempt A function which receives a steady clock deadline, waits until it, and
+     *  returns a value which converts to true if the wait succeeded.
+     * @return Returns the result of the last attempt. If the time point had already been reached
+     *  then there is exactly one attempt, with a deadline which has already expired.
+     */
+    template <class Clock, class Duration, class Attempt>
+    auto wait_until_deadline(
+        const std::chrono::time_point<Clock, Duration> & timeout_time,
+        Attempt && attempt
+    )
+    {
+        using floating_seconds = std::chrono::duration<double>;
+
+        for (;;)
+        {
+            // Compare in floating point first to avoid overflowing if the time point is very far
+            //  away. Such time points are treated as an indefinite wait.
+            const auto now{ Clock::now() };
+            const auto remaining{
+                floating_seconds{ timeout_time.time_since_epoch() } -
+                floating_seconds{ now.time_since_epoch() }
+            };
+            if (remaining >= floating_seconds{ std::chrono::steady_clock::duration::max() } / 2)
+                return attempt(no_deadline);
+
+            const bool expired{ now >= timeout_time };
+            auto result{ attempt(
+                expired ? std::chrono::steady_clock::now() : deadline_after(timeout_time - now)
+            ) };
+            if (result || expired)
+                return result;
+        }
+    }
+}
+
+#endif
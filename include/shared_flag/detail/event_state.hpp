@@ -0,0 +1,241 @@
+/**
+ * @file event_state.hpp
+ * @brief Declares the shared state referenced by the resettable event handles.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_DETAIL_EVENT_STATE_HPP_INCLUDED
+#define PRB_DETAIL_EVENT_STATE_HPP_INCLUDED
+
+#include "deadline.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#if !defined(PRB_SHARED_FLAG_USE_FUTEX)
+#   include <condition_variable>
+#   include <mutex>
+#endif
+
+namespace prb::detail
+{
+    class event_state;
+    template <class State>
+    class basic_state_ptr;
+
+    /// An owning pointer to the shared state of an event. See basic_state_ptr.
+    using event_state_ptr = basic_state_ptr<event_state>;
+
+    /// Determines what happens to an event once it has released a waiting thread.
+    enum class event_reset
+    {
+        /// The event stays set until it's reset explicitly, so it releases every waiting thread.
+        manual,
+
+        /// The event is reset by the first waiting thread which it releases.
+        automatic
+    };
+
+    /**
+     * Contains the shared state referenced by the resettable event handles.
+     * Unlike flag_state, this can be set and reset any number of times, so one state can be reused
+     *  for the whole lifetime of a program.
+     *
+     * The event is a single 32-bit word. The lowest bit says whether it's set. The rest is a
+     *  generation counter, which is incremented every time the event goes from reset to set. A
+     *  thread waiting on a manual-reset event notes the generation when it starts waiting, and is
+     *  released if the generation changes. That means it can't miss a set() which is followed
+     *  immediately by a reset(), even if it doesn't get to run in between.
+     *
+     * Waiting threads block on the word using the same backend as flag_state. The number of
+     *  blocked threads is counted separately rather than recorded in the word, so that set() can
+     *  skip the wake-up once they have all gone.
+     *
+     * Like flag_state, the state is reference-counted intrusively, so each event is a single
+     *  allocation. Use event_state_ptr to manage its lifetime.
+     *
+     * @note All operations are thread-safe.
+     */
+    class event_state
+    {
+    public:
+        //------------------------------------------------------------------------------------------
+        // Construction / destruction.
+
+        /**
+         * Construct a state with the specified behaviour.
+         *
+         * @param mode Determines whether the event is reset automatically when it releases a thread.
+         * @param initially_set Determines whether the event starts off set.
+         */
+        event_state(event_reset mode, bool initially_set) noexcept;
+
+        event_state(const event_state &) = delete;
+        event_state & operator=(const event_state &) = delete;
+        event_state(event_state &&) = delete;
+        event_state & operator=(event_state &&) = delete;
+        ~event_state() = default;
+
+
+        //------------------------------------------------------------------------------------------
+        // Accessors / operations.
+
+        /**
+         * Check if the event is currently set.
+         *
+         * @return Returns true if the event is set. Returns false otherwise.
+         */
+        bool is_set() const noexcept
+        {
+            return (m_word.load(std::memory_order_acquire) & set_bit) != 0U;
+        }
+
+        /**
+         * Get the number of times the event has gone from reset to set.
+         * This wraps around eventually, so it's only useful for detecting a change.
+         *
+         * @return Returns the current generation.
+         */
+        std::uint32_t generation() const noexcept
+        {
+            return m_word.load(std::memory_order_acquire) >> generation_shift;
+        }
+
+        /**
+         * Set the event, and wake threads which are waiting on it.
+         * For a manual-reset event, every waiting thread is released. For an auto-reset event,
+         *  one waiting thread is released, and it resets the event again.
+         *
+         * This does nothing if the event was already set.
+         */
+        void set() noexcept;
+
+        /// Reset the event, if it was set.
+        void reset() noexcept;
+
+        /**
+         * Check if the event is set, without blocking.
+         * If this is an auto-reset event then this also resets it.
+         *
+         * @return Returns true if the event was set. Returns false otherwise.
+         */
+        bool try_wait() noexcept;
+
+        /**
+         * Block the current thread until the event releases it, or the specified time is reached.
+         * A manual-reset event releases the thread if it's set, or if its generation differs from
+         *  the one given. An auto-reset event releases the thread if the thread manages to reset
+         *  it.
+         *
+         * @param deadline The maximum time point to block until. A value of no_deadline means
+         *  there is no time limit.
+         * @param start_generation For a manual-reset event, the value of generation() when the
+         *  caller started waiting. This is ignored for an auto-reset event.
+         * @return Returns true if the thread was released. Returns false if the deadline was
+         *  reached.
+         */
+        bool wait_until(std::chrono::steady_clock::time_point deadline, std::uint32_t start_generation);
+
+    private:
+        //------------------------------------------------------------------------------------------
+        // Internal operations.
+
+        // Allow the owning pointer to manage the reference count.
+        template <class State>
+        friend class basic_state_ptr;
+
+        /// Add a reference to this state. Taking a new reference requires no ordering.
+        void add_reference() noexcept
+        {
+            m_ref_count.fetch_add(1U, std::memory_order_relaxed);
+        }
+
+        /**
+         * Add a reference to this state, unless the last reference has already been released.
+         *
+         * @return Returns true if a reference was added. Returns false if the state is being
+         *  destroyed.
+         */
+        bool try_add_reference() noexcept
+        {
+            auto count{ m_ref_count.load(std::memory_order_relaxed) };
+            do
+            {
+                if (count == 0U)
+                    return false;
+            }
+            while (!m_ref_count.compare_exchange_weak(count, count + 1U, std::memory_order_relaxed));
+            return true;
+        }
+
+        /**
+         * Release a reference to this state.
+         * The release ordering ensures that everything done via the reference happens-before the
+         *  state is deleted by the owner of the last reference.
+         *
+         * @return Returns true if that was the last reference, meaning the caller must delete the
+         *  state. Returns false otherwise.
+         */
+        bool release_reference() noexcept
+        {
+            if (m_ref_count.fetch_sub(1U, std::memory_order_release) != 1U)
+                return false;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return true;
+        }
+
+        /**
+         * Check if the event would release a waiting thread right now.
+         * For an auto-reset event, this resets the event if it was set.
+         *
+         * @param start_generation See wait_until().
+         * @return Returns true if the thread has been released. Returns false otherwise.
+         */
+        bool try_release(std::uint32_t start_generation) noexcept;
+
+
+        //------------------------------------------------------------------------------------------
+        // Data.
+
+        /// Bit in m_word indicating that the event is set.
+        static constexpr std::uint32_t set_bit{ 1U };
+
+        /// The generation counter occupies all of the bits above set_bit.
+        static constexpr std::uint32_t generation_shift{ 1U };
+
+        /// The amount added to m_word to increment the generation counter.
+        static constexpr std::uint32_t generation_increment{ 1U << generation_shift };
+
+        /// Determines whether the event is reset automatically when it releases a thread.
+        const event_reset m_mode;
+
+        /**
+         * Holds the event value and the generation counter.
+         * This is 32 bits wide so that it can be used directly as a futex.
+         */
+        std::atomic<std::uint32_t> m_word;
+
+        /**
+         * The number of threads which are blocked, or about to block, on the event.
+         * A waiter increments this before its final check of m_word, and set() checks it after
+         *  modifying m_word. Both are sequentially consistent, so either the waiter sees the new
+         *  value or set() sees the waiter.
+         */
+        std::atomic<std::uint32_t> m_waiters{ 0U };
+
+        /// The number of event_state_ptr instances which refer to this state.
+        std::atomic<std::size_t> m_ref_count{ 1U };
+
+#if !defined(PRB_SHARED_FLAG_USE_FUTEX)
+        /// Protects access to m_cond_var.
+        std::mutex m_mtx;
+
+        /// Allows threads to block on the event and be notified when it changes.
+        std::condition_variable m_cond_var;
+#endif
+    };
+}
+
+#endif
@@ -0,0 +1,97 @@
+/**
+ * @file flag_listener.hpp
+ * @brief Declares a node which can be registered with a flag's state to be notified when it's set.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_DETAIL_FLAG_LISTENER_HPP_INCLUDED
+#define PRB_DETAIL_FLAG_LISTENER_HPP_INCLUDED
+
+#include <atomic>
+#include <thread>
+
+namespace prb::detail
+{
+    class flag_state;
+
+    /**
+     * A node in a flag_state's intrusive list of listeners.
+     * Registering a listener with flag_state::add_listener() causes its callback to be called
+     *  exactly once, by the thread which sets the flag. The listener is owned by whoever registered
+     *  it, so registration never allocates memory.
+     *
+     * A listener must not be destroyed while it's registered. Calling flag_state::remove_listener()
+     *  makes it safe to destroy, even if the callback is being run on another thread at the time.
+     *  The callback itself may also remove (and then destroy) its own listener.
+     */
+    class flag_listener
+    {
+    public:
+        /// The type of function called when the flag is set. It receives the registered listener.
+        using callback = void (*)(flag_listener & listener) noexcept;
+
+        //------------------------------------------------------------------------------------------
+        // Construction / destruction.
+
+        /**
+         * Construct a listener which isn't registered yet.
+         *
+         * @param function The function to call when the flag is set.
+         */
+        explicit flag_listener(callback function) noexcept :
+            m_callback{ function }
+        {
+        }
+
+        flag_listener(const flag_listener &) = delete;
+        flag_listener & operator=(const flag_listener &) = delete;
+        flag_listener(flag_listener &&) = delete;
+        flag_listener & operator=(flag_listener &&) = delete;
+        ~flag_listener() = default;
+
+    private:
+        //------------------------------------------------------------------------------------------
+        // Data.
+
+        // The state manages the list pointers and the completion status.
+        friend class flag_state;
+
+        /// The function to call when the flag is set.
+        const callback m_callback;
+
+        /// The previous listener in the list. This is protected by the state's listener lock.
+        flag_listener * m_prev{ nullptr };
+
+        /// The next listener in the list. This is protected by the state's listener lock.
+        flag_listener * m_next{ nullptr };
+
+        /**
+         * Indicates whether this listener is currently in a state's list.
+         * This is protected by the state's listener lock.
+         */
+        bool m_linked{ false };
+
+        /**
+         * The thread which is calling the callback, if it has been taken out of the list.
+         * This is protected by the state's listener lock.
+         */
+        std::thread::id m_executor{};
+
+        /**
+         * Points to a variable on the stack of the thread calling the callback, while it's running.
+         * If the callback removes its own listener, this is set to true so that the calling thread
+         *  knows not to touch the listener again.
+         */
+        bool * m_destroyed{ nullptr };
+
+        /**
+         * Set while the listener isn't registered, once the callback has returned, or if it will
+         *  never be called. A thread removing a listener which has already been taken out of the
+         *  list waits for this.
+         */
+        std::atomic<bool> m_complete{ true };
+    };
+}
+
+#endif
@@ -0,0 +1,766 @@
+/**
+ * @file flag_state.hpp
+ * @brief Declares the shared state referenced by instances of shared_flag and shared_flag_reader.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_DETAIL_FLAG_STATE_HPP_INCLUDED
+#define PRB_DETAIL_FLAG_STATE_HPP_INCLUDED
+
+#include "../spin_policy.hpp"
+#include "deadline.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <optional>
+#include <type_traits>
+
+#if defined(PRB_SHARED_FLAG_USE_FUTEX)
+#   if !defined(__linux__)
+#       error "The futex wait backend is only available on Linux."
+#   endif
+#else
+#   include <condition_variable>
+#   include <mutex>
+#endif
+
+namespace prb::detail
+{
+    class deadline_timer;
+    class flag_listener;
+    class flag_state;
+    class parent_set;
+    template <class State>
+    class basic_state_ptr;
+
+    /// An owning pointer to the shared state of a flag. See basic_state_ptr.
+    using state_ptr = basic_state_ptr<flag_state>;
+
+    /**
+     * The size of a cache line, for the purpose of avoiding false sharing.
+     * States are aligned to this, and frequently written members are kept on a separate line from
+     *  the flag word.
+     *
+     * This affects the layout of flag_state, so it must be the same in every translation unit. The
+     *  value of std::hardware_destructive_interference_size can vary with compiler tuning options.
+     *  If that's a concern, define PRB_SHARED_FLAG_CACHE_LINE_SIZE to pin it to a fixed value.
+     */
+#if defined(PRB_SHARED_FLAG_CACHE_LINE_SIZE)
+    inline constexpr std::size_t cache_line_size{ PRB_SHARED_FLAG_CACHE_LINE_SIZE };
+#elif defined(__cpp_lib_hardware_interference_size)
+#   if defined(__GNUC__) && !defined(__clang__)
+#       pragma GCC diagnostic push
+#       pragma GCC diagnostic ignored "-Winterference-size"
+#   endif
+    inline constexpr std::size_t cache_line_size{ std::hardware_destructive_interference_size };
+#   if defined(__GNUC__) && !defined(__clang__)
+#       pragma GCC diagnostic pop
+#   endif
+#else
+    inline constexpr std::size_t cache_line_size{ 64U };
+#endif
+
+/*
+ * By default, the flag word is kept on its own cache line, away from anything which is written
+ *  while the flag is clear. Defining PRB_SHARED_FLAG_PACKED_STATE removes the padding instead.
+ */
+#if defined(PRB_SHARED_FLAG_PACKED_STATE)
+#   define PRB_DETAIL_CACHE_ALIGNED
+#else
+#   define PRB_DETAIL_CACHE_ALIGNED alignas(prb::detail::cache_line_size)
+#endif
+
+    /// The maximum size of a reason which can be stored with a flag. This fits std::error_code.
+    inline constexpr std::size_t max_reason_size{ 16U };
+
+    /**
+     * Check if a type can be stored as the reason a flag was set.
+     * The reason is copied byte-for-byte into the state, so it must be trivially copyable.
+     */
+    template <class T>
+    inline constexpr bool is_flag_reason_v{
+        std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T> &&
+        sizeof(T) <= max_reason_size
+    };
+
+    /// Each reason type has a unique address, so that a reason can't be read back as another type.
+    template <class T>
+    inline constexpr char reason_type_tag{};
+
+    /**
+     * Contains the shared state referenced by shared_flag_reader and shared_flag instances.
+     * This contains the flag value and whatever the wait backend needs to block on it.
+     *
+     * There are two wait backends, selected at build time:
+     *  - If PRB_SHARED_FLAG_USE_FUTEX is defined, waiting threads are parked directly on the flag
+     *     word using Linux futexes.
+     *  - Otherwise, waiting threads block on a std::condition_variable.
+     *
+     * Either way, get() is a single atomic load, and set() is a single atomic read-modify-write if
+     *  no thread has ever blocked on the flag. Before blocking, a waiting thread may spin or yield
+     *  according to a spin_policy. Each state has a default policy, which can be overridden for
+     *  each call.
+     *
+     * The flag can be set with a small reason value, such as an enumerator or std::error_code. It's
+     *  stored in the state before the flag is published, so any thread which sees the flag set
+     *  can read the reason without further synchronisation. Only the first reason is kept.
+     *
+     * Other components can register a flag_listener to be notified when the flag is set. This is
+     *  how a thread can block on several flags at once. A state can also be linked to one or more
+     *  parent states, so that it's set automatically when any of them is set, or armed to set
+     *  itself when a deadline is reached.
+     *
+     * The state is reference-counted intrusively, so that the reference count, the flag, and the
+     *  wait structures all live in a single allocation. Use state_ptr and make_state() to manage the
+     *  lifetime of a state.
+     *
+     * By default, the state is split across cache lines according to how it's accessed:
+     *  - The first line holds the flag word, the default spin policy, and the reason. Once the
+     *     state has been constructed, these are only written by set(), and by a thread which is
+     *     about to block.
+     *     Threads which poll the flag only ever touch this line.
+     *  - The following lines hold the reference count, the list of listeners, and the wait
+     *     backend's bookkeeping. These are written whenever a handle is copied or destroyed, and
+     *     whenever a waiting thread locks or unlocks the mutex, without invalidating the line which
+     *     pollers are reading.
+     *
+     * If PRB_SHARED_FLAG_PACKED_STATE is defined then the padding is omitted, and the state is only
+     *  as big as its members. That's useful if there are lots of flags and they are rarely polled
+     *  by more than one thread at a time.
+     *
+     * @note All operations are thread-safe.
+     */
+    class PRB_DETAIL_CACHE_ALIGNED flag_state
+    {
+    public:
+        //------------------------------------------------------------------------------------------
+        // Construction / destruction.
+
+        flag_state() = default;
+
+        /**
+         * Construct a state with the specified default spin policy.
+         *
+         * @param policy The spin policy used by wait operations which don't specify one.
+         */
+        explicit flag_state(const spin_policy & policy) noexcept;
+
+        flag_state(const flag_state &) = delete;
+        flag_state & operator=(const flag_state &) = delete;
+        flag_state(flag_state &&) = delete;
+        flag_state & operator=(flag_state &&) = delete;
+
+        /// The destructor removes any links to parent states.
+        ~flag_state();
+
+
+        //------------------------------------------------------------------------------------------
+        // Accessors / operations.
+
+        /**
+         * Check if the flag has been set.
+         * This is a single acquire load, so it synchronises with the modification made by set().
+         *
+         * @return Returns true if the flag has been set. Returns false otherwise.
+         */
+        bool is_set() const noexcept
+        {
+            return (m_flag.load(std::memory_order_acquire) & set_bit) != 0U;
+        }
+
+        /**
+         * Set the flag and wake any threads which are blocked on it.
+         * This does nothing if the flag was already set.
+         */
+        void set() noexcept;
+
+        /**
+         * Set the flag with a reason, and wake any threads which are blocked on it.
+         * The reason is published atomically with the flag. If the flag was already set, or
+         *  another thread is setting it with a reason, then this reason is discarded. In the
+         *  latter case, this waits for the other thread to finish so that the flag is set when it
+         *  returns.
+         *
+         * @param reason The value to store. is_flag_reason_v<T> must be true.
+         */
+        template <class T>
+        void set(const T & reason) noexcept
+        {
+            static_assert(is_flag_reason_v<T>, "A flag reason must be trivially copyable, and no bigger than max_reason_size.");
+            set_with_reason(&reason, sizeof(T), &reason_type_tag<T>);
+        }
+
+        /**
+         * Set the flag, copying another state's reason if it has one.
+         * This is how a child flag inherits the reason its parent was set.
+         *
+         * @param source The state to copy the reason from. It must already have been set.
+         */
+        void set_from(const flag_state & source) noexcept;
+
+        /**
+         * Get the reason the flag was set.
+         * This is a single acquire load of the flag word, followed by a copy of the reason.
+         *
+         * @return Returns the reason which was passed to set(). Returns an empty optional if the flag
+         *  hasn't been set, if it was set without a reason, or if the reason had a different type.
+         */
+        template <class T>
+        std::optional<T> reason() const noexcept
+        {
+            static_assert(is_flag_reason_v<T>, "A flag reason must be trivially copyable, and no bigger than max_reason_size.");
+            T value{};
+            if (!load_reason(&value, sizeof(T), &reason_type_tag<T>))
+                return std::nullopt;
+            return value;
+        }
+
+        /**
+         * Get the spin policy used by wait operations which don't specify one.
+         *
+         * @return Returns the default spin policy for this state.
+         */
+        const spin_policy & default_spin_policy() const noexcept
+        {
+            return m_spin_policy;
+        }
+
+        /**
+         * Block the current thread until the flag has been set.
+         * This will return immediately if the flag was already set.
+         */
+        void wait();
+
+        /**
+         * Block the current thread until the flag has been set, using a specific spin policy.
+         * This will return immediately if the flag was already set.
+         *
+         * @param policy Determines how long to spin and yield before blocking.
+         */
+        void wait(const spin_policy & policy);
+
+        /**
+         * Block the current thread until the flag has been set or the specified time is reached.
+         * This will return immediately if the flag was already set.
+         *
+         * @param deadline The maximum time point to block until. A value of
+         *  std::chrono::steady_clock::time_point::max() means there is no time limit.
+         * @return Returns true if the flag has been set. Returns false if the flag had not been set
+         *  when the deadline was reached.
+         */
+        bool wait_until(std::chrono::steady_clock::time_point deadline);
+
+        /**
+         * Block the current thread until the flag has been set or the specified time is reached,
+         *  using a specific spin policy.
+         * This will return immediately if the flag was already set.
+         *
+         * @param deadline The maximum time point to block until. A value of
+         *  std::chrono::steady_clock::time_point::max() means there is no time limit.
+         * @param policy Determines how long to spin and yield before blocking.
+         * @return Returns true if the flag has been set. Returns false if the flag had not been set
+         *  when the deadline was reached.
+         */
+        bool wait_until(std::chrono::steady_clock::time_point deadline, const spin_policy & policy);
+
+        /**
+         * Block the current thread until the flag has been set or the specified time has elapsed.
+         * This converts the timeout to an equivalent steady clock deadline.
+         *
+         * @param timeout_duration The maximum period of time to block for.
+         * @param policy Determines how long to spin and yield before blocking.
+         * @return Returns true if the flag has been set. Returns false otherwise.
+         */
+        template <class Rep, class Period>
+        bool wait_for(
+            const std::chrono::duration<Rep, Period> & timeout_duration,
+            const spin_policy & policy
+        );
+
+        /**
+         * Block the current thread until the flag has been set or the specified time has elapsed,
+         *  using the default spin policy.
+         */
+        template <class Rep, class Period>
+        bool wait_for(const std::chrono::duration<Rep, Period> & timeout_duration);
+
+        /**
+         * Block the current thread until the flag has been set or the specified time is reached.
+         * If the time point is not measured by the steady clock then the clock is re-checked each
+         *  time the thread wakes up, in case it has been adjusted.
+         *
+         * @param timeout_time The maximum time point to block until.
+         * @param policy Determines how long to spin and yield before blocking.
+         * @return Returns true if the flag has been set. Returns false otherwise.
+         */
+        template <class Clock, class Duration>
+        bool wait_until(
+            const std::chrono::time_point<Clock, Duration> & timeout_time,
+            const spin_policy & policy
+        );
+
+        /**
+         * Block the current thread until the flag has been set or the specified time is reached,
+         *  using the default spin policy.
+         */
+        template <class Clock, class Duration>
+        bool wait_until(const std::chrono::time_point<Clock, Duration> & timeout_time);
+
+        /**
+         * Register a listener to be called when the flag is set.
+         * The listener's callback will be called exactly once, by the thread which sets the flag,
+         *  unless the listener is removed first. It must be removed before it's destroyed.
+         *
+         * @param listener The listener to register. It must not already be registered.
+         * @return Returns true if the listener was registered. Returns false if the flag had
+         *  already been set, in which case the callback won't be called.
+         */
+        bool add_listener(flag_listener & listener) noexcept;
+
+        /**
+         * Deregister a listener, so that it's safe to destroy.
+         * If another thread is running the listener's callback, this blocks until it has returned.
+         *  It's safe to call this even if add_listener() returned false or was never called, or if
+         *  the callback has already been called.
+         *
+         * @param listener A listener which may have been passed to add_listener().
+         */
+        void remove_listener(flag_listener & listener) noexcept;
+
+        /**
+         * Link this state to zero or more parent states, so that it's set when any of them is set.
+         * If a parent has already been set then this state is set immediately.
+         *
+         * Setting a parent sets its children synchronously, before the parent's set() returns.
+         *  That includes the children's own children, and so on, so it takes time proportional to
+         *  the number of descendants.
+         *
+         * Each link keeps its parent state alive. The links are removed automatically when this
+         *  state is destroyed. More parents can be attached or detached later, via attach_parent()
+         *  and detach_parent().
+         *
+         * This must only be called once, before the state is shared with any other thread.
+         *
+         * @param parents Points to the first of a sequence of parent states. None of them may be
+         *  empty.
+         * @param count The number of parent states in the sequence. This can be zero.
+         * @throw std::bad_alloc Memory for the links could not be allocated. In that case, no links
+         *  are made.
+         */
+        void link_to_parents(const state_ptr * parents, std::size_t count);
+
+        /**
+         * Do the first half of link_to_parents(), making the links without registering them.
+         * Everything the links need is allocated here, so register_parents() can't fail. Until
+         *  that's called, setting a parent doesn't set this state, and destroying this state
+         *  doesn't touch the parents at all.
+         *
+         * This must only be called once, instead of link_to_parents().
+         *
+         * @param parents Points to the first of a sequence of parent states. None of them may be
+         *  empty.
+         * @param count The number of parent states in the sequence. This can be zero.
+         * @throw std::bad_alloc Memory for the links could not be allocated. In that case, no links
+         *  are made.
+         */
+        void prepare_parents(const state_ptr * parents, std::size_t count);
+
+        /**
+         * Do the second half of link_to_parents(), registering the links made by prepare_parents()
+         *  with their parents. If a parent has already been set then this state is set immediately.
+         *
+         * This must only be called once, after prepare_parents(), before the state is shared with
+         *  any other thread.
+         */
+        void register_parents() noexcept;
+
+        /**
+         * Link this state to another parent state, so that it's set when the parent is set.
+         * If the parent has already been set then this state is set immediately.
+         * The same parent can be attached more than once. Each link must be detached separately.
+         *
+         * This is only valid if link_to_parents() was called when the state was created.
+         *
+         * @param parent The state to link to. It must not be empty.
+         * @throw std::bad_alloc Memory for the link could not be allocated.
+         */
+        void attach_parent(state_ptr parent);
+
+        /**
+         * Remove a link to a parent state, so that setting the parent no longer sets this state.
+         * If the link's callback is being run by another thread, this waits for it to finish.
+         *  This state isn't cleared if it had already been set.
+         *
+         * This is only valid if link_to_parents() was called when the state was created.
+         *
+         * @param parent The parent state to unlink from.
+         * @return Returns true if a link was removed. Returns false if the parent wasn't linked.
+         */
+        bool detach_parent(const flag_state & parent) noexcept;
+
+        /**
+         * Arm this state to be set automatically when a deadline is reached.
+         * The shared timer_service sets the flag, with a deadline_reached reason. If the flag is
+         *  set some other way first, or the state is destroyed, then the timer is cancelled. If the
+         *  deadline has already passed then the flag is set straight away.
+         *
+         * Arming the timer doesn't keep the state alive. When the last handle is released, the
+         *  state is destroyed as usual, without waiting for the deadline.
+         *
+         * This must only be called once, before the state is shared with any other thread.
+         *
+         * @param deadline The time point at which to set the flag. If this is no_deadline then the
+         *  flag is never set automatically.
+         * @throw std::bad_alloc Memory for the timer could not be allocated.
+         */
+        void set_at(std::chrono::steady_clock::time_point deadline);
+
+        /**
+         * Start counting down to setting the flag, for a shared_latch_flag.
+         * This must only be called once, before the state is shared with any other thread. If the
+         *  count is zero then the flag is set straight away.
+         *
+         * @param count The number of times count_down() must be called before the flag is set.
+         */
+        void start_latch(std::ptrdiff_t count) noexcept
+        {
+            m_latch_count.store(count, std::memory_order_relaxed);
+            if (count == 0)
+                set();
+        }
+
+        /**
+         * Decrement the latch count, and set the flag if this takes it to zero.
+         * The decrement is a single atomic read-modify-write. Only the call which reaches zero
+         *  goes on to set the flag. Counting down after that has no further effect.
+         *
+         * @param update The amount to decrement the count by. This must not be negative.
+         */
+        void count_down(std::ptrdiff_t update) noexcept
+        {
+            // Release makes this party's work visible to whichever party sets the flag. Acquire
+            //  lets that party pass on everything before the previous decrements, via the flag.
+            const auto previous{ m_latch_count.fetch_sub(update, std::memory_order_acq_rel) };
+            if (previous > 0 && previous <= update)
+                set();
+        }
+
+        /**
+         * Get the number of times count_down() must still be called before the flag is set.
+         *
+         * @return Returns the remaining count, or zero if it has been reached.
+         */
+        std::ptrdiff_t latch_count() const noexcept
+        {
+            const auto count{ m_latch_count.load(std::memory_order_acquire) };
+            return count > 0 ? count : 0;
+        }
+
+#if defined(__linux__)
+        /**
+         * Get a Linux eventfd which becomes readable when the flag is set.
+         * The eventfd is created the first time this is called, so flags which are never polled
+         *  don't use a file descriptor. After that, set() signals it as well as waking any
+         *  blocked threads. If the flag has already been set then the eventfd is readable straight
+         *  away.
+         *
+         * The eventfd is owned by this state, and is closed when the state is destroyed. Callers
+         *  must not read from it or close it.
+         *
+         * @return Returns the eventfd's file descriptor. This is the same every time.
+         * @throw std::system_error The eventfd could not be created.
+         */
+        int native_handle();
+
+        /**
+         * Set the flag from a signal handler, or anywhere else that only async-signal-safe
+         *  functions can be called.
+         * This never locks anything or allocates memory. It sets the flag with a single atomic
+         *  read-modify-write, and then signals the eventfd from native_handle() if there is one.
+         *  With the futex backend, it also wakes blocked threads directly. errno is preserved.
+         *
+         * Listeners (such as callbacks and child flags) can't be called from a signal handler, and
+         *  nor can the condition variable be notified. Those are handed over to a background thread
+         *  instead, which must have been started by start_signal_dispatch(). Until then, they're
+         *  kept waiting.
+         *
+         * This does nothing if the flag was already set.
+         */
+        void set_from_signal() noexcept;
+
+        /**
+         * Start the background thread which finishes the work of set_from_signal().
+         * This does nothing if the thread has already been started. It runs until the program
+         *  exits.
+         *
+         * @throw std::system_error The thread or the eventfd used to wake it could not be created.
+         */
+        static void start_signal_dispatch();
+#endif
+
+    private:
+        //------------------------------------------------------------------------------------------
+        // Internal operations.
+
+        // Allow the owning pointer to manage the reference count.
+        template <class State>
+        friend class basic_state_ptr;
+
+        /// Add a reference to this state. Taking a new reference requires no ordering.
+        void add_reference() noexcept
+        {
+            m_ref_count.fetch_add(1U, std::memory_order_relaxed);
+        }
+
+        /**
+         * Add a reference to this state, unless the last reference has already been released.
+         *
+         * @return Returns true if a reference was added. Returns false if the state is being
+         *  destroyed.
+         */
+        bool try_add_reference() noexcept
+        {
+            auto count{ m_ref_count.load(std::memory_order_relaxed) };
+            do
+            {
+                if (count == 0U)
+                    return false;
+            }
+            while (!m_ref_count.compare_exchange_weak(count, count + 1U, std::memory_order_relaxed));
+            return true;
+        }
+
+        /**
+         * Release a reference to this state.
+         * The release ordering ensures that everything done via the reference happens-before the
+         *  state is deleted by the owner of the last reference.
+         *
+         * @return Returns true if that was the last reference, meaning the caller must delete the
+         *  state. Returns false otherwise.
+         */
+        bool release_reference() noexcept
+        {
+            if (m_ref_count.fetch_sub(1U, std::memory_order_release) != 1U)
+                return false;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return true;
+        }
+
+        /**
+         * Poll the flag according to the spin and yield phases of a spin policy.
+         *
+         * @param deadline Stop polling if this time point is reached.
+         * @param policy Determines how many times to spin and yield.
+         * @return Returns true if the flag was seen to be set. Returns false otherwise.
+         */
+        bool spin_until(std::chrono::steady_clock::time_point deadline, const spin_policy & policy) const noexcept;
+
+        /// Call and deregister each listener in turn. This is only called once the flag is set.
+        void notify_listeners() noexcept;
+
+        /// Wake any threads which are blocked on the flag. This is only called once it's set.
+        void wake_waiters() noexcept;
+
+        /**
+         * Do the work of set() after the flag word has been updated.
+         *
+         * @param previous The value of the flag word before set_bit was added.
+         */
+        void finish_set(std::uint32_t previous) noexcept;
+
+        /**
+         * Claim the reason, store it, and publish it with the flag.
+         *
+         * @param reason Points to the reason's bytes.
+         * @param size The number of bytes to copy. This must not exceed max_reason_size.
+         * @param type Identifies the reason's type.
+         */
+        void set_with_reason(const void * reason, std::size_t size, const void * type) noexcept;
+
+        /**
+         * Copy the reason out of the state, if it has one of the specified type.
+         * The reason is only written before has_reason_bit is published, so the acquire load
+         *  makes it safe to read.
+         *
+         * @return Returns true if the reason was copied. Returns false otherwise.
+         */
+        bool load_reason(void * reason, std::size_t size, const void * type) const noexcept
+        {
+            if ((m_flag.load(std::memory_order_acquire) & has_reason_bit) == 0U || m_reason_type != type)
+                return false;
+            std::memcpy(reason, m_reason, size);
+            return true;
+        }
+
+#if defined(__linux__)
+        /**
+         * Finish setting each state which set_from_signal() has deferred since the last call.
+         * This is only called by the signal dispatch thread.
+         */
+        static void dispatch_deferred() noexcept;
+#endif
+
+        /// Acquire the lock which protects the list of listeners.
+        void lock_listeners() noexcept;
+
+        /// Release the lock which protects the list of listeners.
+        void unlock_listeners() noexcept;
+
+
+        //------------------------------------------------------------------------------------------
+        // Data.
+
+        /// Bit in m_flag indicating that the flag has been set.
+        static constexpr std::uint32_t set_bit{ 1U };
+
+        /// Bit in m_flag indicating that at least one thread has blocked on the flag.
+        static constexpr std::uint32_t waiting_bit{ 2U };
+
+        /// Bit in m_flag indicating that at least one listener has been registered.
+        static constexpr std::uint32_t listening_bit{ 4U };
+
+        /// Bit in m_flag indicating that m_eventfd must be signalled when the flag is set.
+        static constexpr std::uint32_t pollable_bit{ 8U };
+
+        /// Bit in m_flag indicating that a thread has claimed m_reason, and is about to set the flag.
+        static constexpr std::uint32_t claimed_bit{ 16U };
+
+        /// Bit in m_flag indicating that m_reason is valid. It's only ever added along with set_bit.
+        static constexpr std::uint32_t has_reason_bit{ 32U };
+
+        /**
+         * Holds the flag value and a record of whether any thread has ever blocked, listened, or
+         *  polled on it. Once a bit has been set, it should never be cleared.
+         *
+         * This is not protected by a mutex. Readers only ever need to load it, so polling the flag
+         *  never writes to memory shared with other threads. Blocking threads set waiting_bit before
+         *  going to sleep. Because set() modifies the same word, one of them is guaranteed to observe
+         *  the other; i.e. either the waiter sees the flag, or set() sees the waiter.
+         *
+         * This is 32 bits wide so that it can be used directly as a futex.
+         */
+        std::atomic<std::uint32_t> m_flag{ 0U };
+
+        /// The spin policy used by wait operations which don't specify one.
+        const spin_policy m_spin_policy{};
+
+        /// Identifies the type of m_reason. This is only meaningful once has_reason_bit is set.
+        const void * m_reason_type{ nullptr };
+
+        /**
+         * The reason the flag was set, if any.
+         * It's written by the thread which adds claimed_bit, before it publishes has_reason_bit.
+         *  Nothing writes it after that.
+         */
+        unsigned char m_reason[max_reason_size]{};
+
+        /**
+         * The number of state_ptr instances which refer to this state.
+         * This starts a new cache line, as it's modified every time a handle is copied or destroyed.
+         */
+        PRB_DETAIL_CACHE_ALIGNED std::atomic<std::size_t> m_ref_count{ 1U };
+
+        /**
+         * Protects m_listeners, and the list pointers of the listeners in it.
+         * This is a spin lock, because it's only held to link or unlink a node.
+         */
+        std::atomic_flag m_listeners_lock = ATOMIC_FLAG_INIT;
+
+        /**
+         * The first in a doubly-linked list of listeners to call when the flag is set.
+         * This is only checked by set() if listening_bit has been set.
+         */
+        flag_listener * m_listeners{ nullptr };
+
+        /**
+         * The links registered with this state's parents.
+         * This is null unless link_to_parents() has been called. It isn't replaced after that.
+         */
+        parent_set * m_parents{ nullptr };
+
+        /**
+         * The timer which sets the flag when its deadline is reached.
+         * This is null unless set_at() has been called. It isn't replaced after that.
+         */
+        deadline_timer * m_deadline_timer{ nullptr };
+
+        /**
+         * The count used by shared_latch_flag. This is zero for other flags.
+         * It's kept away from the flag word, as it's modified every time the latch counts down.
+         */
+        std::atomic<std::ptrdiff_t> m_latch_count{ 0 };
+
+#if defined(__linux__)
+        /**
+         * The eventfd returned by native_handle(), or -1 if it hasn't been created yet.
+         * This is published before pollable_bit is set, so set() can read it once it sees the bit.
+         */
+        std::atomic<int> m_eventfd{ -1 };
+
+        /**
+         * The next state in the stack of states waiting for the signal dispatch thread.
+         * This is only used if set_from_signal() had to defer some of its work.
+         */
+        flag_state * m_next_deferred{ nullptr };
+#endif
+
+#if !defined(PRB_SHARED_FLAG_USE_FUTEX)
+        /**
+         * Protects access to m_cond_var.
+         * This is only locked by threads which are about to block, and by a thread setting the
+         *  flag if waiting_bit indicates that it may need to wake somebody.
+         */
+        std::mutex m_mtx;
+
+        /// Allows threads to block on the flag and be notified when it changes.
+        std::condition_variable m_cond_var;
+#endif
+    };
+
+
+    //----------------------------------------------------------------------------------------------
+    // Template implementations.
+
+    template <class Rep, class Period>
+    bool flag_state::wait_for(
+        const std::chrono::duration<Rep, Period> & timeout_duration,
+        const spin_policy & policy
+    )
+    {
+        if (is_set())
+            return true;
+        return wait_until(deadline_after(timeout_duration), policy);
+    }
+
+    template <class Rep, class Period>
+    bool flag_state::wait_for(const std::chrono::duration<Rep, Period> & timeout_duration)
+    {
+        return wait_for(timeout_duration, m_spin_policy);
+    }
+
+    template <class Clock, class Duration>
+    bool flag_state::wait_until(
+        const std::chrono::time_point<Clock, Duration> & timeout_time,
+        const spin_policy & policy
+    )
+    {
+        return wait_until_deadline(timeout_time, [&](std::chrono::steady_clock::time_point deadline)
+        {
+            return wait_until(deadline, policy);
+        });
+    }
+
+    template <class Clock, class Duration>
+    bool flag_state::wait_until(const std::chrono::time_point<Clock, Duration> & timeout_time)
+    {
+        return wait_until(timeout_time, m_spin_policy);
+    }
+}
+
+#undef PRB_DETAIL_CACHE_ALIGNED
+
+#endif
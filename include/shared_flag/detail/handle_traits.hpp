@@ -0,0 +1,51 @@
+/**
+ * @file handle_traits.hpp
+ * @brief Declares type traits which identify shared flag handles.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_DETAIL_HANDLE_TRAITS_HPP_INCLUDED
+#define PRB_DETAIL_HANDLE_TRAITS_HPP_INCLUDED
+
+#include "../compact_shared_flag_reader.hpp"
+#include "../shared_flag_reader.hpp"
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace prb::detail
+{
+    /// Check if a type is one of the shared flag handle classes, or derived from one.
+    template <class T>
+    inline constexpr bool is_flag_handle_v{
+        std::is_base_of_v<shared_flag_reader, T> ||
+        std::is_base_of_v<compact_shared_flag_reader, T>
+    };
+
+    /// Check if all of a set of types are flag handles, and there is at least one of them.
+    template <class... Handles>
+    inline constexpr bool are_flag_handles_v{
+        sizeof...(Handles) > 0U && (is_flag_handle_v<Handles> && ...)
+    };
+
+    /// Check if a type is a range of flag handles.
+    template <class Range, class = void>
+    struct is_flag_handle_range : std::false_type {};
+
+    template <class Range>
+    struct is_flag_handle_range<
+        Range,
+        std::void_t<
+            decltype(std::begin(std::declval<const Range &>())),
+            decltype(std::end(std::declval<const Range &>()))
+        >
+    > : std::bool_constant<
+        is_flag_handle_v<std::decay_t<decltype(*std::begin(std::declval<const Range &>()))>>
+    > {};
+
+    template <class Range>
+    inline constexpr bool is_flag_handle_range_v{ is_flag_handle_range<Range>::value };
+}
+
+#endif
@@ -0,0 +1,78 @@
+/**
+ * @file multi_wait.hpp
+ * @brief Declares the internal operations which block a thread on several flags at once.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_DETAIL_MULTI_WAIT_HPP_INCLUDED
+#define PRB_DETAIL_MULTI_WAIT_HPP_INCLUDED
+
+#include "flag_listener.hpp"
+#include "state_ptr.hpp"
+#include <chrono>
+#include <cstddef>
+#include <optional>
+
+namespace prb::detail
+{
+    struct multi_wait_context;
+
+    /**
+     * Refers to one of the flags involved in a multi-flag wait operation.
+     * The caller provides the storage for these, so that waiting on a fixed number of flags
+     *  doesn't allocate memory. The caller only needs to fill in the state.
+     */
+    struct multi_wait_entry final : flag_listener
+    {
+        multi_wait_entry() noexcept;
+
+        /// The state of the flag to wait on.
+        state_ptr state;
+
+        /// The operation which this entry is currently part of. This is set by the operation.
+        multi_wait_context * context{ nullptr };
+
+        /// The position of this entry in the array passed to the operation.
+        std::size_t index{ 0U };
+
+        /// Indicates whether the listener is registered with the state.
+        bool registered{ false };
+    };
+
+    /**
+     * Block the current thread until at least one of several flags has been set, or until a
+     *  deadline is reached.
+     * The thread registers a listener with each flag, and then blocks once. Nothing polls the
+     *  flags, and no other threads are involved.
+     *
+     * @param entries Pointer to an array of entries. Each entry must refer to a state.
+     * @param count The number of entries in the array. This must not be zero.
+     * @param deadline The time point to give up at, or no_deadline to wait indefinitely.
+     * @return Returns the index of a flag which was set. If several flags were already set on
+     *  entry, this is the lowest such index. Returns an empty optional if the deadline was reached.
+     */
+    std::optional<std::size_t> wait_any_state(
+        multi_wait_entry * entries,
+        std::size_t count,
+        std::chrono::steady_clock::time_point deadline
+    );
+
+    /**
+     * Block the current thread until all of several flags have been set, or until a deadline is
+     *  reached.
+     * The thread registers a listener with each flag, and then blocks once.
+     *
+     * @param entries Pointer to an array of entries. Each entry must refer to a state.
+     * @param count The number of entries in the array. This can be zero.
+     * @param deadline The time point to give up at, or no_deadline to wait indefinitely.
+     * @return Returns true if all of the flags were set. Returns false if the deadline was reached.
+     */
+    bool wait_all_states(
+        multi_wait_entry * entries,
+        std::size_t count,
+        std::chrono::steady_clock::time_point deadline
+    );
+}
+
+#endif
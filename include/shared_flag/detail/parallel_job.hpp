@@ -0,0 +1,141 @@
+/**
+ * @file parallel_job.hpp
+ * @brief Declares the bookkeeping shared by the threads taking part in a parallel algorithm.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_DETAIL_PARALLEL_JOB_HPP_INCLUDED
+#define PRB_DETAIL_PARALLEL_JOB_HPP_INCLUDED
+
+#include "flag_state.hpp"
+#include "state_ptr.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+namespace prb::detail
+{
+    /**
+     * Tracks the chunks claimed by one participant in a parallel_job.
+     * Each participant has its own, so that it can adapt its chunk size without synchronising.
+     */
+    struct chunk_cursor
+    {
+        /// The first index of the chunk which is being processed.
+        std::size_t begin{ 0U };
+
+        /// One past the last index of the chunk which is being processed.
+        std::size_t end{ 0U };
+
+        /// The number of indices to claim next time.
+        std::size_t size{ 1U };
+
+        /// The time at which the current chunk was claimed.
+        std::chrono::steady_clock::time_point started{};
+    };
+
+    /**
+     * Hands out chunks of an index range to the threads taking part in a parallel algorithm.
+     *
+     * Each participant claims a chunk, processes it, then asks for another. The flag which cancels
+     *  the job is checked before each claim, so a participant stops within one chunk of it being
+     *  set. Chunk sizes adapt to how long each chunk takes: a participant starts with a single
+     *  index, and doubles its chunk size while chunks finish well within the target duration. Cheap
+     *  elements therefore cost one atomic increment and one flag check per chunk, rather than per
+     *  element, while expensive elements are still claimed a few at a time.
+     *
+     * Participants which join after the range has been exhausted find no work, and leave without
+     *  touching anything but the job itself. The job is shared by reference count for that reason,
+     *  so helpers which were queued but didn't start in time can still run safely later.
+     */
+    class parallel_job
+    {
+    public:
+        //------------------------------------------------------------------------------------------
+        // Construction / destruction.
+
+        /**
+         * Constructor -- prepares to hand out a range of indices.
+         *
+         * @param cancel The shared state of the flag which cancels the job.
+         * @param count The number of indices in the range, starting from zero.
+         * @param participants The maximum number of threads which will take part. This limits the
+         *  size of each chunk, so that the work can be spread between them.
+         * @param chunk_duration The target time for processing each chunk.
+         */
+        parallel_job(
+            state_ptr cancel,
+            std::size_t count,
+            std::size_t participants,
+            std::chrono::steady_clock::duration chunk_duration
+        ) noexcept;
+
+        parallel_job(const parallel_job &) = delete;
+        parallel_job & operator=(const parallel_job &) = delete;
+        parallel_job(parallel_job &&) = delete;
+        parallel_job & operator=(parallel_job &&) = delete;
+        ~parallel_job() = default;
+
+
+        //------------------------------------------------------------------------------------------
+        // Accessors / operations.
+
+        /// Register a thread as a participant. It must call leave() when next_chunk() returns false.
+        void enter() noexcept;
+
+        /**
+         * Record that the participant's current chunk is finished, and claim another one.
+         *
+         * @param cursor The participant's cursor. On success, this contains the new chunk.
+         * @return Returns true if a chunk was claimed. Returns false if the range is exhausted or
+         *  the job has been cancelled.
+         */
+        bool next_chunk(chunk_cursor & cursor) noexcept;
+
+        /**
+         * Deregister a participant. The last one to leave marks the job as finished.
+         * Anything the participant did beforehand happens-before wait() returns.
+         */
+        void leave() noexcept;
+
+        /**
+         * Block until every participant has left.
+         * This is called by the thread which started the job, after it has taken part itself.
+         *
+         * @return Returns true if every index was processed. Returns false if the job was cancelled
+         *  before that.
+         */
+        bool wait();
+
+    private:
+        //------------------------------------------------------------------------------------------
+        // Data.
+
+        /// The shared state of the flag which cancels the job.
+        const state_ptr m_cancel;
+
+        /// The number of indices in the range.
+        const std::size_t m_count;
+
+        /// The largest chunk which will be handed out, so that the work can still be shared.
+        const std::size_t m_max_chunk;
+
+        /// The target time for processing each chunk.
+        const std::chrono::steady_clock::duration m_chunk_duration;
+
+        /// The first index which hasn't been claimed yet. This may overshoot the end of the range.
+        std::atomic<std::size_t> m_next{ 0U };
+
+        /// The number of indices which have been processed.
+        std::atomic<std::size_t> m_processed{ 0U };
+
+        /// The number of participants which have entered but not left.
+        std::atomic<std::size_t> m_active{ 0U };
+
+        /// Set when the last participant leaves.
+        flag_state m_finished;
+    };
+}
+
+#endif
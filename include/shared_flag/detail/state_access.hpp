@@ -0,0 +1,54 @@
+/**
+ * @file state_access.hpp
+ * @brief Declares an internal helper which can access the shared state held by flag handles.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_DETAIL_STATE_ACCESS_HPP_INCLUDED
+#define PRB_DETAIL_STATE_ACCESS_HPP_INCLUDED
+
+#include "state_ptr.hpp"
+
+namespace prb
+{
+    class shared_flag_reader;
+    class compact_shared_flag_reader;
+}
+
+namespace prb::detail
+{
+    /**
+     * Gives library components access to the shared state referenced by a flag handle.
+     * This is a friend of each handle type, so that handles don't need to expose their state
+     *  publicly.
+     */
+    struct state_access
+    {
+        /**
+         * Get a reference to the shared state held by a handle.
+         *
+         * @param handle The handle to get the shared state from.
+         * @return Returns a pointer to the shared state. This keeps the state alive independently of
+         *  the handle.
+         * @throw std::logic_error The handle does not have a reference to a shared state. This
+         *  happens if it has been moved away.
+         */
+        static state_ptr get(const shared_flag_reader & handle);
+
+        /// @copydoc get(const shared_flag_reader &)
+        static state_ptr get(const compact_shared_flag_reader & handle);
+
+        /**
+         * Create a read-only handle which refers to a shared state.
+         * This lets library components which manage their own state hand out readers for it.
+         *
+         * @param state The state to refer to. If this is empty then so is the handle, as though it
+         *  had been moved away.
+         * @return Returns a new handle which owns the reference.
+         */
+        static shared_flag_reader make_reader(state_ptr state) noexcept;
+    };
+}
+
+#endif
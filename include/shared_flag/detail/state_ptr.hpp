@@ -0,0 +1,220 @@
+/**
+ * @file state_ptr.hpp
+ * @brief Declares an intrusive reference-counted pointer to the shared state of a flag or event.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_DETAIL_STATE_PTR_HPP_INCLUDED
+#define PRB_DETAIL_STATE_PTR_HPP_INCLUDED
+
+#include "flag_state.hpp"
+#include <cstddef>
+#include <initializer_list>
+#include <utility>
+
+namespace prb::detail
+{
+    /**
+     * An owning pointer to a shared state, which uses the reference count stored in the state.
+     * The state type must provide add_reference(), try_add_reference(), and release_reference(),
+     *  as flag_state and event_state do.
+     *
+     * This behaves like a cut-down std::shared_ptr. The differences are:
+     *  - It is only the size of a raw pointer, as there is no separate control block.
+     *  - Creating a new state is a single allocation which holds the reference count and the flag.
+     *  - There are no weak references and no custom deleters.
+     *
+     * As with std::shared_ptr, different instances can safely be used by different threads at the
+     *  same time, even if they point to the same state. However, an instance is not internally
+     *  synchronised.
+     */
+    template <class State>
+    class basic_state_ptr
+    {
+    public:
+        //------------------------------------------------------------------------------------------
+        // Construction / destruction.
+
+        /// Default constructor -- creates an empty pointer.
+        constexpr basic_state_ptr() noexcept = default;
+
+        /// Constructs an empty pointer.
+        constexpr basic_state_ptr(std::nullptr_t) noexcept {}
+
+        /**
+         * Take ownership of a newly allocated state.
+         * The state's reference count must already account for this pointer. That's the case for a
+         *  newly constructed state.
+         *
+         * @param state The state to take ownership of. This can be null.
+         */
+        explicit basic_state_ptr(State * state) noexcept :
+            m_state{ state }
+        {
+        }
+
+        /// Copy constructor -- adds a reference to the state pointed to by another instance.
+        basic_state_ptr(const basic_state_ptr & other) noexcept :
+            m_state{ other.m_state }
+        {
+            if (m_state)
+                m_state->add_reference();
+        }
+
+        /// Copy assignment -- adds a reference to the state pointed to by another instance.
+        basic_state_ptr & operator=(const basic_state_ptr & other) noexcept
+        {
+            basic_state_ptr{ other }.swap(*this);
+            return *this;
+        }
+
+        /// Move constructor -- takes the reference held by another instance.
+        basic_state_ptr(basic_state_ptr && other) noexcept :
+            m_state{ std::exchange(other.m_state, nullptr) }
+        {
+        }
+
+        /// Move assignment -- takes the reference held by another instance.
+        basic_state_ptr & operator=(basic_state_ptr && other) noexcept
+        {
+            basic_state_ptr{ std::move(other) }.swap(*this);
+            return *this;
+        }
+
+        /// The destructor releases the reference held by this instance, if there is one.
+        ~basic_state_ptr()
+        {
+            if (m_state && m_state->release_reference())
+                delete m_state;
+        }
+
+        /**
+         * Create a new pointer to a state which is already owned elsewhere.
+         * This adds a reference to the state.
+         *
+         * @param state The state to point to. This can be null.
+         * @return Returns a pointer which owns the new reference.
+         */
+        static basic_state_ptr share(State * state) noexcept
+        {
+            if (state)
+                state->add_reference();
+            return basic_state_ptr{ state };
+        }
+
+        /**
+         * Create a new pointer to a state, unless its last reference has already been released.
+         * This is for code which holds a raw pointer to a state that may be in the process of being
+         *  destroyed, such as a listener which the state's destructor is waiting to remove.
+         *
+         * @param state The state to point to. This must not be null, and it must not have been
+         *  deleted yet.
+         * @return Returns a pointer which owns the new reference. Returns an empty pointer if the
+         *  state is being destroyed.
+         */
+        static basic_state_ptr try_share(State * state) noexcept
+        {
+            return basic_state_ptr{ state->try_add_reference() ? state : nullptr };
+        }
+
+
+        //------------------------------------------------------------------------------------------
+        // Accessors / operations.
+
+        /// Get the raw pointer to the state. This will be null if this instance is empty.
+        State * get() const noexcept
+        {
+            return m_state;
+        }
+
+        /// Access the state. This instance must not be empty.
+        State * operator->() const noexcept
+        {
+            return m_state;
+        }
+
+        /// Access the state. This instance must not be empty.
+        State & operator*() const noexcept
+        {
+            return *m_state;
+        }
+
+        /// Check if this instance points to a state.
+        explicit operator bool() const noexcept
+        {
+            return m_state != nullptr;
+        }
+
+        /**
+         * Give up ownership of the state without releasing the reference.
+         * The caller becomes responsible for the reference, e.g. by passing it back to the
+         *  constructor.
+         *
+         * @return Returns the state which this instance pointed to. This will be null if this
+         *  instance was empty.
+         */
+        State * release() noexcept
+        {
+            return std::exchange(m_state, nullptr);
+        }
+
+        /// Release the reference held by this instance, if there is one.
+        void reset() noexcept
+        {
+            basic_state_ptr{}.swap(*this);
+        }
+
+        /// Exchange the states pointed to by this instance and another.
+        void swap(basic_state_ptr & other) noexcept
+        {
+            std::swap(m_state, other.m_state);
+        }
+
+        /// Check if two instances point to the same state.
+        friend bool operator==(const basic_state_ptr & lhs, const basic_state_ptr & rhs) noexcept
+        {
+            return lhs.m_state == rhs.m_state;
+        }
+
+        /// Check if two instances point to different states.
+        friend bool operator!=(const basic_state_ptr & lhs, const basic_state_ptr & rhs) noexcept
+        {
+            return lhs.m_state != rhs.m_state;
+        }
+
+    private:
+        //------------------------------------------------------------------------------------------
+        // Data.
+
+        /// The state referenced by this instance. This is null if the instance is empty.
+        State * m_state{ nullptr };
+    };
+
+    /**
+     * Allocate a new state, and return a pointer which owns the only reference to it.
+     *
+     * @param args Arguments to pass to the state's constructor.
+     * @return Returns a pointer to the new state.
+     */
+    template <class... Args>
+    state_ptr make_state(Args &&... args)
+    {
+        return state_ptr{ new flag_state(std::forward<Args>(args)...) };
+    }
+
+    /**
+     * Allocate a new state which is set automatically when any of its parents are set.
+     *
+     * @param parents The states to link the new state to. None of them may be empty.
+     * @return Returns a pointer to the new state.
+     */
+    inline state_ptr make_child_state(std::initializer_list<state_ptr> parents)
+    {
+        auto state{ make_state() };
+        state->link_to_parents(parents.begin(), parents.size());
+        return state;
+    }
+}
+
+#endif
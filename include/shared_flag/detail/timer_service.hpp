@@ -0,0 +1,242 @@
+/**
+ * @file timer_service.hpp
+ * @brief Declares a background thread which calls functions when their deadlines are reached.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_DETAIL_TIMER_SERVICE_HPP_INCLUDED
+#define PRB_DETAIL_TIMER_SERVICE_HPP_INCLUDED
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+namespace prb::detail
+{
+    class timer_service;
+
+    /**
+     * A timer which can be scheduled with the timer_service.
+     * Like flag_listener, the timer is owned by whoever schedules it. It must not be destroyed
+     *  while it's scheduled; cancelling it makes it safe to destroy.
+     */
+    class timer_entry
+    {
+    public:
+        /// The type of function called when the deadline is reached. It receives the timer.
+        using callback = void (*)(timer_entry & timer) noexcept;
+
+        //------------------------------------------------------------------------------------------
+        // Construction / destruction.
+
+        /**
+         * Construct a timer which isn't scheduled yet.
+         *
+         * @param function The function to call when the deadline is reached.
+         */
+        explicit timer_entry(callback function) noexcept :
+            m_callback{ function }
+        {
+        }
+
+        timer_entry(const timer_entry &) = delete;
+        timer_entry & operator=(const timer_entry &) = delete;
+        timer_entry(timer_entry &&) = delete;
+        timer_entry & operator=(timer_entry &&) = delete;
+        ~timer_entry() = default;
+
+    private:
+        //------------------------------------------------------------------------------------------
+        // Data.
+
+        // The service manages the wheel position.
+        friend class timer_service;
+
+        /// The function to call when the deadline is reached.
+        const callback m_callback;
+
+        /// The tick at which the timer is due. This is protected by the service's mutex.
+        std::uint64_t m_expiry{ 0U };
+
+        /**
+         * Points to the head of the wheel slot containing this timer, or null if it isn't
+         *  scheduled. This is protected by the service's mutex.
+         */
+        timer_entry ** m_slot{ nullptr };
+
+        /// The previous timer in the same slot. This is protected by the service's mutex.
+        timer_entry * m_prev{ nullptr };
+
+        /// The next timer in the same slot. This is protected by the service's mutex.
+        timer_entry * m_next{ nullptr };
+    };
+
+    /**
+     * Runs a single background thread which calls timer callbacks when their deadlines are reached.
+     * This lets lots of asynchronous operations time out without dedicating a thread to each one.
+     *
+     * Timers are kept in a hierarchical timing wheel, so scheduling and cancelling a timer take
+     *  constant time however many are scheduled, and never allocate memory. Deadlines are rounded
+     *  up to the next tick of timer_resolution. The first level of the wheel has a slot for each of
+     *  the next 256 ticks. Each higher level has 64 slots, each covering a whole revolution of the
+     *  level below. When the wheel turns past the start of a higher slot, its timers are moved down
+     *  to the level which now covers them. A timer is moved at most once per level, so the cost of
+     *  running it stays constant too. Deadlines more than about 49 days ahead wait in the top level,
+     *  and are re-sorted each time it comes round.
+     *
+     * Callbacks are called on the service thread, one at a time. They must not block, or they will
+     *  delay every other timer.
+     *
+     * The thread is started the first time the service is used, and stopped when the program
+     *  exits. Timers which are still scheduled at that point are never called.
+     */
+    class timer_service
+    {
+    public:
+        //------------------------------------------------------------------------------------------
+        // Construction / destruction.
+
+        /// Get the shared instance of the service, starting it if necessary.
+        static timer_service & instance();
+
+        timer_service(const timer_service &) = delete;
+        timer_service & operator=(const timer_service &) = delete;
+        timer_service(timer_service &&) = delete;
+        timer_service & operator=(timer_service &&) = delete;
+
+        /// The destructor stops the service thread.
+        ~timer_service();
+
+
+        //------------------------------------------------------------------------------------------
+        // Accessors / operations.
+
+        /// The length of a tick. Timers are never called early, but may be called up to this late.
+        static constexpr std::chrono::milliseconds timer_resolution{ 1 };
+
+        /**
+         * Schedule a timer to be called when a deadline is reached.
+         * If the deadline has already passed then the timer is called as soon as possible.
+         *
+         * @param timer The timer to schedule. It must not already be scheduled.
+         * @param deadline The time point at which to call the timer.
+         */
+        void schedule(timer_entry & timer, std::chrono::steady_clock::time_point deadline) noexcept;
+
+        /**
+         * Cancel a timer, so that it's safe to destroy.
+         * If the timer is being called on the service thread, this blocks until it has returned,
+         *  unless it's called by the timer's own callback. It's safe to call this even if the timer
+         *  was never scheduled, or has already been called.
+         *
+         * @param timer The timer to cancel.
+         */
+        void cancel(timer_entry & timer) noexcept;
+
+    private:
+        //------------------------------------------------------------------------------------------
+        // Internal operations.
+
+        /// Start the service thread.
+        timer_service();
+
+        /// Call each timer when its deadline is reached, until the service is stopped.
+        void run() noexcept;
+
+        /// Convert a deadline to the tick at which it's due, rounding up.
+        std::uint64_t to_tick(std::chrono::steady_clock::time_point deadline) const noexcept;
+
+        /// Add a timer to the slot which covers its expiry. The caller must hold the mutex.
+        void insert(timer_entry & timer) noexcept;
+
+        /// Remove a timer from its slot. The caller must hold the mutex.
+        void unlink(timer_entry & timer) noexcept;
+
+        /**
+         * Move the timers in the higher-level slots which start at the current tick down to the
+         *  levels which now cover them. The caller must hold the mutex.
+         */
+        void cascade() noexcept;
+
+        /**
+         * Find the next tick at which the wheel has work to do.
+         * The caller must hold the mutex. There must be at least one timer scheduled.
+         *
+         * @return Returns the earliest tick at which a timer is due, or at which a slot containing
+         *  timers is due to be cascaded.
+         */
+        std::uint64_t next_event() const noexcept;
+
+
+        //------------------------------------------------------------------------------------------
+        // Data.
+
+        /// The number of bits of the tick which select a slot in the first level.
+        static constexpr unsigned int near_bits{ 8U };
+
+        /// The number of bits of the tick which select a slot in each higher level.
+        static constexpr unsigned int far_bits{ 6U };
+
+        /// The number of levels above the first.
+        static constexpr std::size_t far_levels{ 4U };
+
+        /// The number of ticks covered by one revolution of the first level.
+        static constexpr std::uint64_t near_size{ std::uint64_t{ 1U } << near_bits };
+
+        /// Selects a slot in the first level from a tick.
+        static constexpr std::uint64_t near_mask{ near_size - 1U };
+
+        /// Selects a slot in a higher level from a shifted tick.
+        static constexpr std::uint64_t far_mask{ (std::uint64_t{ 1U } << far_bits) - 1U };
+
+        /// The number of ticks which the whole wheel can cover.
+        static constexpr std::uint64_t horizon{ std::uint64_t{ 1U } << (near_bits + far_bits * far_levels) };
+
+        /// The value of m_wake_tick while the service thread has nothing to wait for.
+        static constexpr std::uint64_t never_wake{ std::numeric_limits<std::uint64_t>::max() };
+
+        /// The time point which corresponds to tick zero.
+        const std::chrono::steady_clock::time_point m_epoch;
+
+        /// Protects all of the members below, except for the thread.
+        std::mutex m_mtx;
+
+        /// Notifies the service thread of new timers, and cancelling threads of finished callbacks.
+        std::condition_variable m_cond_var;
+
+        /// The next tick to be processed. Every scheduled timer expires at or after this.
+        std::uint64_t m_current{ 0U };
+
+        /**
+         * The tick at which the sleeping service thread will wake up, if nothing else wakes it.
+         * This is zero while the thread is awake, and never_wake while it waits for a timer.
+         */
+        std::uint64_t m_wake_tick{ 0U };
+
+        /// The number of timers which are scheduled.
+        std::size_t m_count{ 0U };
+
+        /// The slots of the first level. Each is the head of a doubly-linked list of timers.
+        std::array<timer_entry *, near_size> m_near{};
+
+        /// The slots of the higher levels.
+        std::array<std::array<timer_entry *, far_mask + 1U>, far_levels> m_far{};
+
+        /// The timer whose callback is currently running, if any.
+        timer_entry * m_firing{ nullptr };
+
+        /// Tells the service thread to exit.
+        bool m_stopping{ false };
+
+        /// The service thread.
+        std::thread m_thread;
+    };
+}
+
+#endif
@@ -0,0 +1,155 @@
+/**
+ * @file flag_callback.hpp
+ * @brief Declares a class which runs a function when a shared flag is set.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_FLAG_CALLBACK_HPP_INCLUDED
+#define PRB_FLAG_CALLBACK_HPP_INCLUDED
+
+#include "detail/flag_listener.hpp"
+#include "detail/flag_state.hpp"
+#include "detail/state_access.hpp"
+#include "detail/state_ptr.hpp"
+#include "compact_shared_flag_reader.hpp"
+#include "shared_flag_reader.hpp"
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+namespace prb
+{
+    /**
+     * Registers a function to be called when a shared flag is set.
+     * This is the equivalent of std::stop_callback. It lets code react to a flag being set without
+     *  dedicating a thread to waiting on it.
+     *
+     * The function is called exactly once:
+     *  - If the flag has already been set, it's called immediately by the constructor.
+     *  - Otherwise, it's called by the thread which sets the flag, before set() returns.
+     *  - If this object is destroyed before the flag is set, the function is never called.
+     *
+     * The function must not throw. If it does then std::terminate() is called. It should also be
+     *  quick, as it delays set() returning, and any other callbacks on the same flag.
+     *
+     * Registering a callback doesn't allocate memory. The list node is stored inside this object.
+     *
+     * Destroying this object deregisters the callback. If the callback is being run by another
+     *  thread at the time, the destructor waits for it to finish. This means it's always safe to
+     *  destroy resources used by the callback once the destructor has returned. The callback may
+     *  also destroy its own flag_callback object.
+     *
+     * Example of interrupting a blocking operation if the flag is set while it's in progress:
+     *
+     * @code
+     *      void receive(socket & sock, shared_flag_reader cancelled)
+     *      {
+     *          flag_callback on_cancel{ cancelled, [&sock] { sock.shutdown(); } };
+     *          sock.read(buffer);
+     *      }
+     * @endcode
+     *
+     * @tparam Callback The type of function to call. It must be invocable with no arguments.
+     */
+    template <class Callback>
+    class flag_callback : private detail::flag_listener
+    {
+        static_assert(std::is_invocable_v<Callback>, "The callback must be invocable with no arguments.");
+        static_assert(std::is_destructible_v<Callback>, "The callback must be destructible.");
+
+    public:
+        /// The type of function which is called when the flag is set.
+        using callback_type = Callback;
+
+        //------------------------------------------------------------------------------------------
+        // Construction / destruction.
+
+        /**
+         * Register a function to be called when a flag is set.
+         * If the flag has already been set then the function is called before this returns.
+         *
+         * @param flag The flag to observe. This can be an instance of shared_flag or
+         *  shared_flag_reader.
+         * @param callback The function to call. It's moved or copied into this object.
+         * @throw std::logic_error The flag does not have a reference to a shared state. This
+         *  happens if it has been moved away.
+         */
+        template <class C, std::enable_if_t<std::is_constructible_v<Callback, C>, int> = 0>
+        explicit flag_callback(const shared_flag_reader & flag, C && callback) :
+            flag_callback{ detail::state_access::get(flag), std::forward<C>(callback) }
+        {
+        }
+
+        /**
+         * Register a function to be called when a flag is set.
+         * If the flag has already been set then the function is called before this returns.
+         *
+         * @param flag The flag to observe. This can be an instance of compact_shared_flag or
+         *  compact_shared_flag_reader.
+         * @param callback The function to call. It's moved or copied into this object.
+         * @throw std::logic_error The flag does not have a reference to a shared state. This
+         *  happens if it has been moved away.
+         */
+        template <class C, std::enable_if_t<std::is_constructible_v<Callback, C>, int> = 0>
+        explicit flag_callback(const compact_shared_flag_reader & flag, C && callback) :
+            flag_callback{ detail::state_access::get(flag), std::forward<C>(callback) }
+        {
+        }
+
+        flag_callback(const flag_callback &) = delete;
+        flag_callback & operator=(const flag_callback &) = delete;
+        flag_callback(flag_callback &&) = delete;
+        flag_callback & operator=(flag_callback &&) = delete;
+
+        /**
+         * The destructor deregisters the callback.
+         * If another thread is running the callback at the same time, this blocks until it has
+         *  finished.
+         */
+        ~flag_callback()
+        {
+            m_state->remove_listener(*this);
+        }
+
+    private:
+        //------------------------------------------------------------------------------------------
+        // Internal operations.
+
+        /// Store the callback, and register it with the shared state.
+        template <class C>
+        flag_callback(detail::state_ptr state, C && callback) :
+            detail::flag_listener{ &invoke },
+            m_state{ std::move(state) },
+            m_callback(std::forward<C>(callback))
+        {
+            if (!m_state->add_listener(*this))
+                invoke(*this);
+        }
+
+        /// Called by the shared state when the flag is set, or by the constructor if it already was.
+        static void invoke(detail::flag_listener & listener) noexcept
+        {
+            std::invoke(std::move(static_cast<flag_callback &>(listener).m_callback));
+        }
+
+
+        //------------------------------------------------------------------------------------------
+        // Data.
+
+        /// Keeps the shared state alive while the callback is registered.
+        detail::state_ptr m_state;
+
+        /// The function to call when the flag is set.
+        Callback m_callback;
+    };
+
+    // Deduce the callback type from the constructor argument.
+    template <class Callback>
+    flag_callback(const shared_flag_reader &, Callback) -> flag_callback<Callback>;
+
+    template <class Callback>
+    flag_callback(const compact_shared_flag_reader &, Callback) -> flag_callback<Callback>;
+}
+
+#endif
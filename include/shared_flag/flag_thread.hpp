@@ -0,0 +1,198 @@
+/**
+ * @file flag_thread.hpp
+ * @brief Declares a thread which owns a shared flag, and stops and joins itself when destroyed.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_FLAG_THREAD_HPP_INCLUDED
+#define PRB_FLAG_THREAD_HPP_INCLUDED
+
+#include "detail/state_access.hpp"
+#include "detail/state_ptr.hpp"
+#include "shared_flag_reader.hpp"
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace prb
+{
+    /**
+     * A thread which owns a stop flag, like std::jthread but with a shared_flag_reader instead of
+     *  a std::stop_token.
+     *
+     * If the function can be called with a shared_flag_reader as its first argument then it
+     *  receives a reader for the thread's stop flag, followed by any other arguments. Otherwise it
+     *  only receives the other arguments. The destructor sets the flag and joins the thread, so
+     *  a worker can't outlive the object which started it:
+     *
+     * @code
+     *      flag_thread worker{ [](shared_flag_reader stop)
+     *      {
+     *          while (!stop.wait_for(1s))
+     *              do_regular_work();
+     *      } };
+     * @endcode
+     *
+     * The flag is an ordinary shared state, so the reader can be waited on with other flags,
+     *  passed to a child flag, or used with periodic(). Starting a thread makes one allocation for
+     *  the flag, in addition to whatever std::thread needs. The function and its arguments are
+     *  stored in the std::thread's own allocation, without any type erasure.
+     *
+     * @note Like std::thread, an instance can be moved but not copied. Other threads may call
+     *  request_stop() and get_stop_flag() at the same time, but join(), detach(), and assignment
+     *  must not be called concurrently with anything else.
+     */
+    class flag_thread
+    {
+    public:
+        /// The type of the underlying thread's native handle.
+        using native_handle_type = std::thread::native_handle_type;
+
+        //------------------------------------------------------------------------------------------
+        // Construction / destruction.
+
+        /// Default constructor -- creates an object which doesn't represent a thread or a flag.
+        flag_thread() noexcept = default;
+
+        /**
+         * Constructor -- creates a new stop flag and starts a thread which runs a function.
+         *
+         * @param function The function to run. It's decayed and copied or moved into the new
+         *  thread, like std::thread does.
+         * @param args Arguments to pass to the function. They're also decayed and copied or moved
+         *  into the new thread. If the function accepts a shared_flag_reader before these, then
+         *  that's passed first.
+         * @throw std::bad_alloc The stop flag could not be allocated.
+         * @throw std::system_error The thread could not be started.
+         */
+        template <
+            class Function,
+            class... Args,
+            std::enable_if_t<!std::is_same_v<std::decay_t<Function>, flag_thread>, int> = 0
+        >
+        explicit flag_thread(Function && function, Args &&... args) :
+            m_state{ detail::make_state() }
+        {
+            if constexpr (std::is_invocable_v<std::decay_t<Function>, shared_flag_reader, std::decay_t<Args>...>)
+            {
+                m_thread = std::thread{
+                    std::forward<Function>(function),
+                    detail::state_access::make_reader(m_state),
+                    std::forward<Args>(args)...
+                };
+            }
+            else
+            {
+                m_thread = std::thread{ std::forward<Function>(function), std::forward<Args>(args)... };
+            }
+        }
+
+        flag_thread(const flag_thread &) = delete;
+        flag_thread & operator=(const flag_thread &) = delete;
+
+        /**
+         * Move constructor -- takes the thread and stop flag from another instance.
+         * The other instance no longer represents a thread or a flag afterwards.
+         */
+        flag_thread(flag_thread && other) noexcept = default;
+
+        /**
+         * Move assignment -- takes the thread and stop flag from another instance.
+         * If this instance already represented a joinable thread then it's stopped and joined first.
+         *
+         * @return Returns a reference to this instance.
+         */
+        flag_thread & operator=(flag_thread && other) noexcept;
+
+        /// The destructor sets the stop flag and joins the thread, if it's joinable.
+        ~flag_thread();
+
+
+        //------------------------------------------------------------------------------------------
+        // Accessors / operations.
+
+        /// Check if this represents a thread which hasn't been joined or detached yet.
+        bool joinable() const noexcept;
+
+        /**
+         * Block until the thread has finished.
+         * This doesn't set the stop flag, so the thread must be finishing anyway.
+         *
+         * @throw std::system_error The thread isn't joinable, or would join itself.
+         */
+        void join();
+
+        /**
+         * Let the thread run independently of this object.
+         * The stop flag is kept, so request_stop() can still ask the thread to finish.
+         *
+         * @throw std::system_error The thread isn't joinable.
+         */
+        void detach();
+
+        /// Get the ID of the thread, or a default ID if this doesn't represent a thread.
+        std::thread::id get_id() const noexcept;
+
+        /// Get the underlying thread's native handle.
+        native_handle_type native_handle();
+
+        /**
+         * Get a read-only handle to the thread's stop flag.
+         *
+         * @return Returns a reader for the stop flag. If this instance doesn't have a flag, because
+         *  it was default-constructed or moved away, then the reader isn't valid.
+         */
+        shared_flag_reader get_stop_flag() const noexcept;
+
+        /**
+         * Set the thread's stop flag, without waiting for the thread to finish.
+         * This does nothing if the flag was already set, or if this instance doesn't have a flag.
+         */
+        void request_stop() noexcept;
+
+        /// Exchange the threads and stop flags of two instances.
+        void swap(flag_thread & other) noexcept;
+
+    private:
+        //------------------------------------------------------------------------------------------
+        // Data.
+
+        /// The thread's stop flag. This is empty if the instance doesn't represent a thread.
+        detail::state_ptr m_state;
+
+        /// The thread which runs the function.
+        std::thread m_thread;
+    };
+
+    /**
+     * Stop a group of threads, and wait for them all to finish.
+     * Every thread's stop flag is set before any of them is joined. The threads therefore wind down
+     *  in parallel, and the total time taken is roughly that of the slowest one, rather than the
+     *  sum of them all.
+     *
+     * @code
+     *      std::vector<flag_thread> workers;
+     *      ...
+     *      stop_all(workers);
+     * @endcode
+     *
+     * @param threads A range of flag_thread instances, such as a std::vector<flag_thread>. Threads
+     *  which aren't joinable are skipped.
+     * @throw std::system_error One of the threads is the calling thread. Every flag has still been
+     *  set, but the remaining threads haven't been joined.
+     */
+    template <class Range>
+    void stop_all(Range & threads)
+    {
+        for (flag_thread & thread : threads)
+            thread.request_stop();
+        for (flag_thread & thread : threads)
+        {
+            if (thread.joinable())
+                thread.join();
+        }
+    }
+}
+
+#endif
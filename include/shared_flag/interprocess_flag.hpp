@@ -0,0 +1,178 @@
+/**
+ * @file interprocess_flag.hpp
+ * @brief Declares a one-shot flag which can be placed in memory shared between processes.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_INTERPROCESS_FLAG_HPP_INCLUDED
+#define PRB_INTERPROCESS_FLAG_HPP_INCLUDED
+
+#if !defined(__linux__)
+#   error "interprocess_flag is only available on Linux."
+#endif
+
+#include "detail/deadline.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace prb
+{
+    /**
+     * A one-shot flag which can be set, queried, and waited on by several processes at once.
+     * This is useful for signalling shutdown from a supervisor process to its workers, without
+     *  polling.
+     *
+     * Unlike shared_flag, this isn't a handle to a state on the heap. The object itself is the
+     *  state, and it contains nothing but a single 32-bit word. Construct it in memory which is
+     *  mapped into each process, such as a region created with shm_open() or a memory-mapped
+     *  file. Processes may map the region at different addresses.
+     *
+     * Threads which wait on the flag block on the word using process-shared futexes. As with
+     *  shared_flag, get() is a single atomic load, and set() is a single atomic read-modify-write
+     *  if no thread is blocked on the flag.
+     *
+     * Nothing is locked, so a process which crashes can't leave the flag in a state which blocks
+     *  other processes.
+     *
+     * Example of creating a flag in a named shared memory region:
+     *
+     * @code
+     *      // In the supervisor:
+     *      const int fd{ shm_open("/my_app_shutdown", O_CREAT | O_RDWR, 0600) };
+     *      ftruncate(fd, sizeof(interprocess_flag));
+     *      void * memory{ mmap(nullptr, sizeof(interprocess_flag), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) };
+     *      auto * shutdown{ new (memory) interprocess_flag{} };
+     *
+     *      // In each worker, after mapping the same region:
+     *      auto * shutdown{ static_cast<interprocess_flag *>(memory) };
+     *      shutdown->wait();
+     * @endcode
+     *
+     * The flag must be constructed exactly once, before any other process uses it. Zero-filled
+     *  memory (such as a newly truncated file) is also a valid flag which hasn't been set.
+     *
+     * @note All operations are thread-safe and process-safe.
+     */
+    class interprocess_flag
+    {
+    public:
+        //------------------------------------------------------------------------------------------
+        // Construction / destruction.
+
+        /// Default constructor -- creates a flag which hasn't been set.
+        constexpr interprocess_flag() noexcept = default;
+
+        interprocess_flag(const interprocess_flag &) = delete;
+        interprocess_flag & operator=(const interprocess_flag &) = delete;
+        interprocess_flag(interprocess_flag &&) = delete;
+        interprocess_flag & operator=(interprocess_flag &&) = delete;
+
+        /**
+         * The destructor does nothing. The flag doesn't own any resources, so it's safe to simply
+         *  unmap the memory it's stored in.
+         */
+        ~interprocess_flag() = default;
+
+
+        //------------------------------------------------------------------------------------------
+        // Accessors / operations.
+
+        /**
+         * Set the flag and wake any threads which are waiting on it, in any process.
+         * This does nothing if the flag was already set.
+         */
+        void set() noexcept;
+
+        /**
+         * Check if the flag has been set.
+         * This is a single acquire load, so it synchronises with the modification made by set().
+         *
+         * @return Returns true if the flag has been set. Returns false otherwise.
+         */
+        bool get() const noexcept
+        {
+            return (m_flag.load(std::memory_order_acquire) & set_bit) != 0U;
+        }
+
+        /**
+         * Check if the flag has been set.
+         * This is a convenience wrapper around get().
+         *
+         * @return Returns true if the flag has been set. Returns false otherwise.
+         */
+        operator bool() const noexcept
+        {
+            return get();
+        }
+
+        /**
+         * Block the current thread until the flag has been set.
+         * This will return immediately if the flag was already set.
+         */
+        void wait() noexcept;
+
+        /**
+         * Block the current thread until the flag has been set or the specified time has elapsed.
+         * This will return immediately if the flag was already set.
+         *
+         * @param timeout_duration The maximum period of time to block for.
+         * @return Returns true if the flag has been set. Returns false if the flag had not been set
+         *  when the timeout expired.
+         */
+        template <class Rep, class Period>
+        bool wait_for(const std::chrono::duration<Rep, Period> & timeout_duration)
+        {
+            if (get())
+                return true;
+            return wait_until(detail::deadline_after(timeout_duration));
+        }
+
+        /**
+         * Block the current thread until the flag has been set or the specified time is reached.
+         * This will return immediately if the flag was already set.
+         *
+         * @param deadline The maximum time point to block until. A value of
+         *  std::chrono::steady_clock::time_point::max() means there is no time limit.
+         * @return Returns true if the flag has been set. Returns false if the flag had not been set
+         *  when the deadline was reached.
+         */
+        bool wait_until(std::chrono::steady_clock::time_point deadline) noexcept;
+
+        /**
+         * Block the current thread until the flag has been set or the specified time is reached.
+         * If the time point is not measured by the steady clock then the clock is re-checked each
+         *  time the thread wakes up, in case it has been adjusted.
+         *
+         * @param timeout_time The maximum time point to block until.
+         * @return Returns true if the flag has been set. Returns false otherwise.
+         */
+        template <class Clock, class Duration>
+        bool wait_until(const std::chrono::time_point<Clock, Duration> & timeout_time)
+        {
+            return detail::wait_until_deadline(timeout_time, [this](std::chrono::steady_clock::time_point deadline)
+            {
+                return wait_until(deadline);
+            });
+        }
+
+    private:
+        //------------------------------------------------------------------------------------------
+        // Data.
+
+        /// Bit in m_flag indicating that the flag has been set.
+        static constexpr std::uint32_t set_bit{ 1U };
+
+        /// Bit in m_flag indicating that at least one thread has blocked on the flag.
+        static constexpr std::uint32_t waiting_bit{ 2U };
+
+        /**
+         * Holds the flag value, and a record of whether any thread has ever blocked on it.
+         * This is used directly as a process-shared futex.
+         */
+        std::atomic<std::uint32_t> m_flag{ 0U };
+    };
+}
+
+#endif
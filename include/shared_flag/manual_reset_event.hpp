@@ -0,0 +1,288 @@
+/**
+ * @file manual_reset_event.hpp
+ * @brief Declares handles to a shared event which can be set and reset repeatedly.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_MANUAL_RESET_EVENT_HPP_INCLUDED
+#define PRB_MANUAL_RESET_EVENT_HPP_INCLUDED
+
+#include "detail/deadline.hpp"
+#include "detail/event_state.hpp"
+#include "detail/state_ptr.hpp"
+#include <chrono>
+#include <stdexcept>
+
+namespace prb
+{
+    /**
+     * A handle which can query and wait on a shared manual-reset event.
+     * This is the resettable counterpart of compact_shared_flag_reader. Where a flag is set once
+     *  and stays set, a manual-reset event can be set and reset any number of times. That lets one
+     *  event be reused for every cycle of work, instead of creating a new flag and handing it out
+     *  to every worker each time.
+     *
+     * While the event is set, every thread which waits on it is released. A thread which is
+     *  already waiting when the event is set is released even if the event is reset again before
+     *  the thread gets a chance to run. That's because the event counts how many times it has been
+     *  set, and a waiting thread watches for that count to change. A pulse can't be missed.
+     *
+     * This follows the same thread-safety rules as compact_shared_flag_reader. Any number of
+     *  threads can use different instances which refer to the same event. If one thread modifies
+     *  an instance (e.g. by assigning to it) then no other thread may access that instance at the
+     *  same time.
+     *
+     * Example of workers which process one batch each time the event is set:
+     *
+     * @code
+     *      auto worker = [](manual_reset_event_reader batch_ready, compact_shared_flag_reader stop)
+     *      {
+     *          while (!stop)
+     *          {
+     *              batch_ready.wait();
+     *              // Process the batch here.
+     *          }
+     *      };
+     * @endcode
+     *
+     * This class can only wait on the event. It must be copied from an instance of
+     *  manual_reset_event.
+     */
+    class manual_reset_event_reader
+    {
+    public:
+        //------------------------------------------------------------------------------------------
+        // Construction / destruction.
+
+        /**
+         * Copy constructor -- copies a reference to the shared state of an existing instance.
+         *
+         * @param other An existing instance to copy a shared state reference from. This can be an
+         *  instance of manual_reset_event or manual_reset_event_reader.
+         */
+        manual_reset_event_reader(const manual_reset_event_reader & other) noexcept = default;
+
+        /// Copy assignment -- copies a reference to the shared state of an existing instance.
+        manual_reset_event_reader & operator=(const manual_reset_event_reader & other) noexcept = default;
+
+        /**
+         * Move constructor -- acquires the shared state reference from another instance.
+         * Afterwards, the other instance will no longer have a reference to the shared state.
+         */
+        manual_reset_event_reader(manual_reset_event_reader && other) noexcept = default;
+
+        /// Move assignment -- acquires the shared state reference from another instance.
+        manual_reset_event_reader & operator=(manual_reset_event_reader && other) noexcept = default;
+
+        /**
+         * The destructor releases this instance's reference to the shared state, if it has one.
+         * This is deliberately not virtual, as with compact_shared_flag_reader.
+         */
+        ~manual_reset_event_reader() = default;
+
+
+        //------------------------------------------------------------------------------------------
+        // Accessors / operations.
+
+        /**
+         * Check if this instance contains a reference to a shared state.
+         *
+         * @return Returns true if this object contains a reference to a shared state. Returns false
+         *  if the reference has been moved away.
+         */
+        bool valid() const noexcept
+        {
+            return static_cast<bool>(m_state);
+        }
+
+        /**
+         * Check if the event is currently set.
+         *
+         * @return Returns true if the event is set. Returns false otherwise.
+         * @throw std::logic_error This instance does not contain a reference to a shared state.
+         *  This happens if the contents of this object have been moved away.
+         */
+        bool get() const
+        {
+            return checked_state().is_set();
+        }
+
+        /**
+         * Check if the event is currently set.
+         * This is a convenience wrapper around get().
+         *
+         * @return Returns true if the event is set. Returns false otherwise.
+         * @throw std::logic_error This instance does not contain a reference to a shared state.
+         */
+        operator bool() const
+        {
+            return get();
+        }
+
+        /**
+         * Block the current thread until the event is set.
+         * This will return immediately if the event is already set. Otherwise, it returns as soon
+         *  as the event is set, even if it's reset again straight away.
+         *
+         * @throw std::logic_error This instance does not contain a reference to a shared state.
+         *  This happens if the contents of this object have been moved away.
+         */
+        void wait() const;
+
+        /**
+         * Block the current thread until the event is set or the specified time has elapsed.
+         * This will return immediately if the event is already set.
+         *
+         * @param timeout_duration The maximum period of time to block for.
+         * @return Returns true if the event was set. Returns false if the event had not been set
+         *  when the timeout expired.
+         * @throw std::logic_error This instance does not contain a reference to a shared state.
+         *  This happens if the contents of this object have been moved away.
+         */
+        template <class Rep, class Period>
+        bool wait_for(const std::chrono::duration<Rep, Period> & timeout_duration) const
+        {
+            auto & state{ checked_state() };
+            return state.wait_until(detail::deadline_after(timeout_duration), state.generation());
+        }
+
+        /**
+         * Block the current thread until the event is set or the specified time is reached.
+         * This will return immediately if the event is already set. If the time point is not
+         *  measured by the steady clock then the clock is re-checked each time the thread wakes
+         *  up, in case it has been adjusted.
+         *
+         * @param timeout_time The maximum time point to block until.
+         * @return Returns true if the event was set. Returns false if the event had not been set
+         *  when the time point was reached.
+         * @throw std::logic_error This instance does not contain a reference to a shared state.
+         *  This happens if the contents of this object have been moved away.
+         */
+        template <class Clock, class Duration>
+        bool wait_until(const std::chrono::time_point<Clock, Duration> & timeout_time) const
+        {
+            // The generation is noted once, so that a pulse between two attempts isn't missed.
+            auto & state{ checked_state() };
+            const auto start_generation{ state.generation() };
+            return detail::wait_until_deadline(timeout_time, [&](std::chrono::steady_clock::time_point deadline)
+            {
+                return state.wait_until(deadline, start_generation);
+            });
+        }
+
+    protected:
+        //------------------------------------------------------------------------------------------
+        // Internal operations.
+
+        /**
+         * Construct an instance which refers to the specified shared state.
+         * This is used by manual_reset_event to create new states.
+         */
+        explicit manual_reset_event_reader(detail::event_state_ptr state) noexcept;
+
+        /**
+         * Get the shared state referenced by this instance.
+         *
+         * @throw std::logic_error This instance does not contain a reference to a shared state.
+         */
+        detail::event_state & checked_state() const
+        {
+            if (!m_state)
+                throw std::logic_error{ "Shared state has been moved away." };
+            return *m_state;
+        }
+
+
+        //------------------------------------------------------------------------------------------
+        // Data.
+
+        /**
+         * A pointer to the shared state referenced by this instance.
+         * This will be null if the shared state was moved away.
+         */
+        detail::event_state_ptr m_state;
+    };
+
+    /**
+     * A handle which can set, reset, query, and wait on a shared manual-reset event.
+     * See manual_reset_event_reader for details.
+     *
+     * Example of releasing a group of workers for each batch of work:
+     *
+     * @code
+     *      manual_reset_event batch_ready;
+     *      // Give each worker a copy of batch_ready.
+     *
+     *      for (;;)
+     *      {
+     *          prepare_batch();
+     *          batch_ready.set();
+     *          wait_for_workers_to_start();
+     *          batch_ready.reset();
+     *      }
+     * @endcode
+     */
+    class manual_reset_event final : public manual_reset_event_reader
+    {
+    public:
+        //------------------------------------------------------------------------------------------
+        // Construction / destruction.
+
+        /**
+         * Constructor -- generates and stores a reference to a new shared state.
+         *
+         * @param initially_set Determines whether the event starts off set.
+         */
+        explicit manual_reset_event(bool initially_set = false);
+
+        /// Copy constructor -- copies a reference to the shared state of an existing instance.
+        manual_reset_event(const manual_reset_event & other) noexcept = default;
+
+        /// Copy assignment -- copies a reference to the shared state of an existing instance.
+        manual_reset_event & operator=(const manual_reset_event & other) noexcept = default;
+
+        /// Move constructor -- acquires the shared state reference from another instance.
+        manual_reset_event(manual_reset_event && other) noexcept = default;
+
+        /// Move assignment -- acquires the shared state reference from another instance.
+        manual_reset_event & operator=(manual_reset_event && other) noexcept = default;
+
+        // A reader converts to bool, so make sure it can't be mistaken for the initial value.
+        manual_reset_event(const manual_reset_event_reader &) = delete;
+        manual_reset_event & operator=(const manual_reset_event_reader &) = delete;
+
+        /// The destructor releases this instance's reference to the shared state, if it has one.
+        ~manual_reset_event() = default;
+
+
+        //------------------------------------------------------------------------------------------
+        // Accessors / operations.
+
+        /**
+         * Set the event and wake any threads which are waiting on it.
+         * This does nothing if the event was already set.
+         *
+         * @throw std::logic_error This instance does not have a reference to a shared state. This
+         *  happens if it has been moved away.
+         */
+        void set()
+        {
+            checked_state().set();
+        }
+
+        /**
+         * Reset the event, so that threads which wait on it will block until it's set again.
+         * Threads which were already waiting when the event was last set are still released.
+         *
+         * @throw std::logic_error This instance does not have a reference to a shared state. This
+         *  happens if it has been moved away.
+         */
+        void reset()
+        {
+            checked_state().reset();
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,287 @@
+/**
+ * @file parallel.hpp
+ * @brief Declares parallel algorithms which stop between chunks of work when a flag is set.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_PARALLEL_HPP_INCLUDED
+#define PRB_PARALLEL_HPP_INCLUDED
+
+#include "detail/handle_traits.hpp"
+#include "detail/parallel_job.hpp"
+#include "detail/state_access.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace prb
+{
+    /// Options which control how a parallel algorithm splits its work.
+    struct parallel_options
+    {
+        /**
+         * The target time for processing each chunk of elements.
+         * This bounds how long each thread can take to notice that the flag has been set. Shorter
+         *  chunks respond sooner, but check the flag and claim work more often.
+         */
+        std::chrono::steady_clock::duration chunk_duration{ std::chrono::microseconds{ 100 } };
+    };
+}
+
+namespace prb::detail
+{
+    /**
+     * Do a share of a parallel job's work, if there is any left.
+     * The participant is only called if a chunk is claimed, which means the thread which started the
+     *  job is still waiting for it. A helper which starts too late therefore never touches it.
+     *
+     * This is noexcept so that an exception from the user's function terminates the program, on
+     *  whichever thread it's thrown. Otherwise the calling thread could unwind the participant
+     *  while helpers were still using it.
+     *
+     * @param job The job to work on. The current thread must have entered it.
+     * @param participant Processes the claimed chunk, then claims more until there are none left.
+     */
+    template <class Participant>
+    void do_share(parallel_job & job, Participant & participant) noexcept
+    {
+        chunk_cursor cursor;
+        if (job.next_chunk(cursor))
+            participant(job, cursor);
+    }
+
+    /// Take part in a parallel job from a helper thread. See do_share().
+    template <class Participant>
+    void take_part(parallel_job & job, Participant * participant) noexcept
+    {
+        job.enter();
+        do_share(job, *participant);
+        job.leave();
+    }
+
+    /**
+     * Share a range of indices between the calling thread and the workers in a pool.
+     * This doesn't return until every thread which claimed some of the work has finished.
+     *
+     * @param pool Provides the helper threads.
+     * @param cancel The flag which stops the job between chunks.
+     * @param count The number of indices in the range.
+     * @param options Controls how the range is split.
+     * @param participant Called by each thread which claims a chunk. See do_share().
+     * @return Returns true if every index was processed, or false if the flag was set first.
+     */
+    template <class Handle, class Participant>
+    bool run_parallel(
+        thread_pool & pool,
+        const Handle & cancel,
+        std::size_t count,
+        const parallel_options & options,
+        Participant & participant
+    )
+    {
+        auto state{ state_access::get(cancel) };
+        if (count == 0U)
+            return true;
+        if (state->is_set())
+            return false;
+
+        // The calling thread takes part too, so it only needs help with the rest of the range.
+        const auto helpers{ std::min(pool.thread_count(), count - 1U) };
+        const auto job{
+            std::make_shared<parallel_job>(std::move(state), count, helpers + 1U, options.chunk_duration)
+        };
+
+        // Entering first stops the job finishing before the calling thread has started.
+        job->enter();
+        try
+        {
+            // Queued helpers are discarded by the pool if the flag is set before they start.
+            for (std::size_t i{ 0U }; i < helpers; ++i)
+                pool.submit(cancel, [job, participant = &participant] { take_part(*job, participant); });
+        }
+        catch (const std::bad_alloc &)
+        {
+            // Carry on with the helpers which were queued. The calling thread can do all of the
+            //  work itself if necessary.
+        }
+
+        do_share(*job, participant);
+        job->leave();
+        return job->wait();
+    }
+}
+
+namespace prb
+{
+    /**
+     * Call a function for each index in a range, using a thread pool, until a flag is set.
+     *
+     * The range is shared between the calling thread and the pool's workers in chunks. Each
+     *  thread checks the flag before claiming a chunk, so the function stops being called within
+     *  about one chunk of the flag being set. Chunks start with a single index, and grow while
+     *  they take less than the target duration, so the overhead per index stays small however
+     *  cheap the function is.
+     *
+     * @code
+     *      const auto process_row{ [&](std::size_t row) { process(rows[row]); } };
+     *      const bool finished{ parallel_for(pool, cancel, std::size_t{ 0U }, rows.size(), process_row) };
+     * @endcode
+     *
+     * The function may be called concurrently, and in any order. It must not throw exceptions. If
+     *  it does then std::terminate() is called. This can be called from inside one of the pool's
+     *  tasks, as the calling thread does some of the work itself.
+     *
+     * @param pool The thread pool which helps with the work.
+     * @param cancel The flag which stops the work. This can be any type of shared flag handle.
+     * @param first The first index in the range.
+     * @param last One past the last index in the range. This must have the same type as first.
+     * @param function The function to call. It's passed each index in the range.
+     * @param options Controls how the range is split into chunks.
+     * @return Returns true if the function was called for every index. Returns false if the flag
+     *  was set first, in which case it may have been called for some of them.
+     * @throw std::logic_error The flag does not have a reference to a shared state. This happens
+     *  if it has been moved away.
+     * @throw std::bad_alloc The job could not be allocated.
+     */
+    template <
+        class Handle,
+        class Index,
+        class Function,
+        std::enable_if_t<detail::is_flag_handle_v<Handle> && std::is_integral_v<Index>, int> = 0>
+    bool parallel_for(
+        thread_pool & pool,
+        const Handle & cancel,
+        Index first,
+        Index last,
+        Function && function,
+        const parallel_options & options = {}
+    )
+    {
+        using unsigned_index = std::make_unsigned_t<Index>;
+        const auto count{
+            last > first
+                ? static_cast<std::size_t>(static_cast<unsigned_index>(last) - static_cast<unsigned_index>(first))
+                : std::size_t{ 0U }
+        };
+
+        auto participant{ [first, &function](detail::parallel_job & job, detail::chunk_cursor & cursor)
+        {
+            do
+            {
+                const auto end{ cursor.end };
+                for (auto index{ cursor.begin }; index < end; ++index)
+                    std::invoke(function, static_cast<Index>(static_cast<unsigned_index>(first) + index));
+            }
+            while (job.next_chunk(cursor));
+        } };
+        return detail::run_parallel(pool, cancel, count, options, participant);
+    }
+
+    /**
+     * Transform each element in a range, and combine the results, using a thread pool, until a flag
+     *  is set.
+     *
+     * This works like std::transform_reduce(), and shares the range between threads in the same way
+     *  as parallel_for(). Each thread combines the elements it processes into its own partial
+     *  result, so the threads only synchronise when they claim a chunk and when they finish.
+     *
+     * @code
+     *      const auto total{ parallel_transform_reduce(pool, cancel, orders.begin(), orders.end(),
+     *          0.0, std::plus<>{}, [](const order & o) { return o.price * o.quantity; }) };
+     *      if (!total)
+     *          return; // Cancelled.
+     * @endcode
+     *
+     * The elements may be combined in any order, so the reduce function must be associative and
+     *  commutative. Neither function may throw exceptions. If one does then std::terminate() is
+     *  called.
+     *
+     * @param pool The thread pool which helps with the work.
+     * @param cancel The flag which stops the work. This can be any type of shared flag handle.
+     * @param first An iterator to the first element in the range.
+     * @param last An iterator to one past the last element in the range.
+     * @param init The initial value, which is combined with the result.
+     * @param reduce Combines two values into one.
+     * @param transform Converts each element to a value which can be combined.
+     * @param options Controls how the range is split into chunks.
+     * @return Returns the combined result if every element was processed. Returns an empty
+     *  optional if the flag was set first.
+     * @throw std::logic_error The flag does not have a reference to a shared state. This happens
+     *  if it has been moved away.
+     * @throw std::bad_alloc The job could not be allocated.
+     */
+    template <
+        class Handle,
+        class RandomIt,
+        class T,
+        class Reduce,
+        class Transform,
+        std::enable_if_t<detail::is_flag_handle_v<Handle>, int> = 0>
+    std::optional<T> parallel_transform_reduce(
+        thread_pool & pool,
+        const Handle & cancel,
+        RandomIt first,
+        RandomIt last,
+        T init,
+        Reduce reduce,
+        Transform transform,
+        const parallel_options & options = {}
+    )
+    {
+        static_assert(
+            std::is_base_of_v<
+                std::random_access_iterator_tag,
+                typename std::iterator_traits<RandomIt>::iterator_category>,
+            "The range must have random access iterators."
+        );
+        using difference_type = typename std::iterator_traits<RandomIt>::difference_type;
+        const auto distance{ std::distance(first, last) };
+        const auto count{ distance > 0 ? static_cast<std::size_t>(distance) : std::size_t{ 0U } };
+
+        std::mutex mtx;
+        std::optional<T> combined;
+        auto participant{ [&](detail::parallel_job & job, detail::chunk_cursor & cursor)
+        {
+            const auto element{ [first](std::size_t index) -> decltype(auto)
+            {
+                return first[static_cast<difference_type>(index)];
+            } };
+
+            // Start from the first element, so that the inner loop doesn't need to check for it.
+            auto index{ cursor.begin };
+            T partial(std::invoke(transform, element(index++)));
+            for (;;)
+            {
+                for (const auto end{ cursor.end }; index < end; ++index)
+                    partial = std::invoke(reduce, std::move(partial), std::invoke(transform, element(index)));
+                if (!job.next_chunk(cursor))
+                    break;
+                index = cursor.begin;
+            }
+
+            const std::lock_guard<std::mutex> lock{ mtx };
+            if (combined)
+                combined = std::invoke(reduce, std::move(*combined), std::move(partial));
+            else
+                combined.emplace(std::move(partial));
+        } };
+
+        if (!detail::run_parallel(pool, cancel, count, options, participant))
+            return std::nullopt;
+        if (combined)
+            return std::invoke(reduce, std::move(init), std::move(*combined));
+        return init;
+    }
+}
+
+#endif
@@ -0,0 +1,289 @@
+/**
+ * @file periodic.hpp
+ * @brief Declares a range which repeats at a fixed period until a shared flag is set.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_PERIODIC_HPP_INCLUDED
+#define PRB_PERIODIC_HPP_INCLUDED
+
+#include "detail/handle_traits.hpp"
+#include "detail/state_access.hpp"
+#include "detail/state_ptr.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+namespace prb
+{
+    /// Specifies what a periodic range does if the loop body takes longer than a period.
+    enum class missed_tick_policy
+    {
+        /// Skip the ticks which were missed, and wait for the next one which is still due.
+        skip,
+
+        /// Deliver each missed tick straight away, until the loop has caught up.
+        catch_up
+    };
+
+    /**
+     * Options which control when a periodic range wakes up.
+     *
+     * Example of a ticker which doesn't mind waking up to 5ms late:
+     *
+     * @code
+     *      periodic_options options;
+     *      options.slack = 5ms;
+     *      for (const auto & tick : periodic(stop, 100ms, options))
+     *          poll_device();
+     * @endcode
+     */
+    struct periodic_options
+    {
+        /// What to do if the loop body takes longer than a period.
+        missed_tick_policy missed_ticks{ missed_tick_policy::skip };
+
+        /**
+         * How late each wake-up is allowed to be.
+         * If this isn't zero then each wake-up is delayed to the next multiple of the slack,
+         *  measured from the steady clock's epoch. Tickers with different periods then tend to
+         *  wake at the same instants, so the kernel can handle their timers together. Zero means
+         *  each wake-up is at the tick itself.
+         */
+        std::chrono::steady_clock::duration slack{ 0 };
+
+        /**
+         * Offsets the ticks from the steady clock's epoch.
+         * By default, ticks are at whole multiples of the period, so tickers with the same period
+         *  wake together. A phase can be used to spread them out instead.
+         */
+        std::chrono::steady_clock::duration phase{ 0 };
+    };
+
+    /// Describes one iteration of a periodic range.
+    struct periodic_tick
+    {
+        /// The time at which this tick was due. The loop body never runs before this.
+        std::chrono::steady_clock::time_point scheduled;
+
+        /**
+         * The number of ticks which were skipped immediately before this one, because the loop
+         *  body ran past them by more than the slack. This is always zero with
+         *  missed_tick_policy::catch_up.
+         */
+        std::uint64_t missed{ 0U };
+    };
+
+    /**
+     * An input range which yields a tick at regular intervals until a flag is set.
+     * Construct this via periodic(), and iterate over it with a range-based for loop.
+     *
+     * Unlike calling wait_for() in a loop, the ticks don't drift. Each one is due at an absolute
+     *  time point, so the time spent in the loop body and the time taken to wake up aren't added to
+     *  the next wait. Ticks are aligned to whole multiples of the period since the steady clock's
+     *  epoch (plus an optional phase). That means every ticker with the same period wakes at the
+     *  same instants, even in different threads, so the kernel can coalesce their wake-ups.
+     *
+     * Iteration stops as soon as the flag is set. That includes while the range is waiting for the
+     *  next tick, so setting the flag doesn't have to wait for the rest of the period.
+     *
+     * @note A range can only be iterated once, by one thread at a time. It can't be copied. Moving
+     *  it invalidates any iterators which refer to it.
+     */
+    class periodic_range
+    {
+    public:
+        /// Iterates over the ticks of a periodic range. Incrementing it waits for the next tick.
+        class iterator
+        {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = periodic_tick;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const periodic_tick *;
+            using reference = const periodic_tick &;
+
+            /// Construct an end iterator.
+            iterator() noexcept = default;
+
+            /// Get the current tick.
+            reference operator*() const noexcept
+            {
+                return m_range->m_tick;
+            }
+
+            /// Get the current tick.
+            pointer operator->() const noexcept
+            {
+                return &m_range->m_tick;
+            }
+
+            /// Wait for the next tick, or until the flag is set.
+            iterator & operator++()
+            {
+                m_range->advance();
+                return *this;
+            }
+
+            /// Wait for the next tick, or until the flag is set.
+            void operator++(int)
+            {
+                ++*this;
+            }
+
+            /// Two iterators are equal if they have both finished, or refer to the same range.
+            friend bool operator==(const iterator & lhs, const iterator & rhs) noexcept
+            {
+                return lhs.is_finished() ? rhs.is_finished() : lhs.m_range == rhs.m_range;
+            }
+
+            friend bool operator!=(const iterator & lhs, const iterator & rhs) noexcept
+            {
+                return !(lhs == rhs);
+            }
+
+        private:
+            friend class periodic_range;
+
+            explicit iterator(periodic_range * range) noexcept :
+                m_range{ range }
+            {
+            }
+
+            /// Check if this is an end iterator, or its range has stopped.
+            bool is_finished() const noexcept
+            {
+                return !m_range || m_range->m_finished;
+            }
+
+            /// The range being iterated, or null for an end iterator.
+            periodic_range * m_range{ nullptr };
+        };
+
+        //------------------------------------------------------------------------------------------
+        // Construction / destruction.
+
+        /**
+         * Constructor -- prepares to tick until a flag is set.
+         * Prefer calling periodic(), which accepts any type of flag handle.
+         *
+         * @param state The shared state of the flag which stops the ticks.
+         * @param period The time between ticks.
+         * @param options Controls the alignment of the ticks, and how missed ticks are handled.
+         * @throw std::logic_error The state is null.
+         * @throw std::invalid_argument The period isn't positive, or the slack is negative.
+         */
+        periodic_range(
+            detail::state_ptr state,
+            std::chrono::steady_clock::duration period,
+            const periodic_options & options
+        );
+
+        periodic_range(const periodic_range &) = delete;
+        periodic_range & operator=(const periodic_range &) = delete;
+        periodic_range(periodic_range &&) noexcept = default;
+        periodic_range & operator=(periodic_range &&) noexcept = default;
+        ~periodic_range() = default;
+
+
+        //------------------------------------------------------------------------------------------
+        // Accessors / operations.
+
+        /**
+         * Wait for the first tick, which is the first one due after this is first called.
+         * Calling this again doesn't restart the range. It returns an iterator to the current tick.
+         *
+         * @return Returns an iterator to the first tick. If the flag is set first then this is
+         *  equal to end().
+         */
+        iterator begin();
+
+        /// Get an iterator which marks the end of the range.
+        iterator end() noexcept
+        {
+            return iterator{};
+        }
+
+    private:
+        //------------------------------------------------------------------------------------------
+        // Internal operations.
+
+        /// Work out when the next tick is due, and wait for it or for the flag to be set.
+        void advance();
+
+        /// Get the first tick which is due strictly after the given time point.
+        std::chrono::steady_clock::time_point next_tick_after(std::chrono::steady_clock::time_point time) const noexcept;
+
+        /**
+         * Wait until the current tick is due, plus any slack.
+         * This marks the range as finished if the flag is set first.
+         */
+        void wait_for_tick();
+
+
+        //------------------------------------------------------------------------------------------
+        // Data.
+
+        /// The shared state of the flag which stops the ticks.
+        detail::state_ptr m_state;
+
+        /// The time between ticks.
+        std::chrono::steady_clock::duration m_period;
+
+        /// Controls the alignment of the ticks, and how missed ticks are handled.
+        periodic_options m_options;
+
+        /// The current tick.
+        periodic_tick m_tick{};
+
+        /// Indicates that begin() has waited for the first tick.
+        bool m_started{ false };
+
+        /// Indicates that the flag has been set, so there are no more ticks.
+        bool m_finished{ false };
+    };
+
+    /**
+     * Iterate at a regular period until a flag is set.
+     * This is a drift-free replacement for calling wait_for() in a loop:
+     *
+     * @code
+     *      void task(shared_flag_reader stop)
+     *      {
+     *          for (const auto & tick : periodic(stop, 1s))
+     *          {
+     *              // Do regular work in the background here.
+     *          }
+     *      }
+     * @endcode
+     *
+     * The first tick is the next one due after iteration begins. See periodic_range for details.
+     *
+     * @param flag The flag which stops the ticks. This can be any type of shared flag handle. The
+     *  range keeps its own reference to the shared state.
+     * @param period The time between ticks. It's rounded up to the resolution of the steady clock.
+     * @param options Controls the alignment of the ticks, and how missed ticks are handled.
+     * @return Returns a range which yields a periodic_tick each time a tick is due.
+     * @throw std::logic_error The flag does not have a reference to a shared state. This happens if
+     *  it has been moved away.
+     * @throw std::invalid_argument The period isn't positive, or the slack is negative.
+     */
+    template <class Handle, class Rep, class Period, std::enable_if_t<detail::is_flag_handle_v<Handle>, int> = 0>
+    periodic_range periodic(
+        const Handle & flag,
+        const std::chrono::duration<Rep, Period> & period,
+        const periodic_options & options = {}
+    )
+    {
+        return periodic_range{
+            detail::state_access::get(flag),
+            std::chrono::ceil<std::chrono::steady_clock::duration>(period),
+            options
+        };
+    }
+}
+
+#endif
@@ -8,7 +8,12 @@
 #ifndef PRB_SHARED_FLAG_HPP_INCLUDED
 #define PRB_SHARED_FLAG_HPP_INCLUDED
 
+#include "detail/handle_traits.hpp"
+#include "detail/state_access.hpp"
+#include "detail/state_ptr.hpp"
+#include "child_of.hpp"
 #include "shared_flag_reader.hpp"
+#include <type_traits>
 
 namespace prb
 {
@@ -66,6 +71,45 @@ namespace prb
          */
         shared_flag();
 
+        /**
+         * Constructor -- generates and stores a reference to a new shared state, with a specific
+         *  default spin policy.
+         * The spin policy is used by every wait on the new flag which doesn't specify its own. This
+         *  makes it possible for all waits on a latency-critical flag to spin briefly before
+         *  blocking, without every waiting thread having to opt in.
+         * 
+         * @param policy Determines how long threads waiting on the flag busy-wait before blocking.
+         */
+        explicit shared_flag(const spin_policy & policy);
+
+        /**
+         * Constructor -- generates a new shared state which is a child of one or more other flags.
+         * The new flag is set automatically when any of its parents are set, including when their
+         *  own parents are set. If a parent has already been set then the new flag is set straight
+         *  away. The new flag can also be set by itself, which doesn't affect its parents.
+         *
+         * Propagation is synchronous, and doesn't use any threads: a parent's set() function
+         *  doesn't return until all of its descendants have been set. The links are removed
+         *  automatically when the new shared state is destroyed. Until then, they keep the parents'
+         *  shared states alive.
+         *
+         * Example of a flag which is set if either of two other flags is set:
+         *
+         * @code
+         *      shared_flag child{ child_of, parent1, parent2 };
+         * @endcode
+         *
+         * @param parents The flags to link to. Any mixture of shared_flag, shared_flag_reader,
+         *  compact_shared_flag, and compact_shared_flag_reader can be used.
+         * @throw std::logic_error One of the parents does not have a reference to a shared state.
+         *  This happens if it has been moved away.
+         */
+        template <class... Parents, std::enable_if_t<detail::are_flag_handles_v<Parents...>, int> = 0>
+        shared_flag(child_of_t, const Parents &... parents) :
+            shared_flag_reader{ detail::make_child_state({ detail::state_access::get(parents)... }) }
+        {
+        }
+
         /**
          * Copy constructor -- copies a reference to the shared state of an existing instance.
          * Afterwards, this instance and the other instance will both have a reference to the same
@@ -95,9 +139,8 @@ namespace prb
          * @throw std::logic_error The other instance does not have a reference to a shared state.
          *  This happens if it has been moved away.
          * 
-         * @warning If another thread is waiting on this instance (by calling one of the wait*()
-         *  functions) then this function will block until the wait has finished.
-         * @note This will not block if another thread is waiting on the other instance.
+         * @note This will not block if another thread is waiting on either instance. Any wait which
+         *  is already in progress continues to wait on the flag it started with.
          */
         shared_flag & operator=(const shared_flag & other);
 
@@ -108,15 +151,13 @@ namespace prb
          *  that unless another reference is copied or assigned into it.
          * 
          * @param other An existing instance to move a shared state reference from. This must be an
-         *  instance of shared_flag, not shared_flag_reader. It must contain a reference to a shared
-         *  state; i.e. it must not have been moved away.
-         * @throw std::logic_error The other instance does not have a reference to a shared state.
-         *  This happens if it has already been moved away.
+         *  instance of shared_flag, not shared_flag_reader. If it does not contain a reference to a
+         *  shared state (i.e. it has already been moved away) then neither will this instance.
          * 
-         * @warning If another thread is waiting on the existing instance (by calling one of the
-         *  wait*() functions) then this function will block until the wait has finished.
+         * @note This will not block if another thread is waiting on the other instance. Any wait
+         *  which is already in progress continues to wait on the same flag.
          */
-        shared_flag(shared_flag && other);
+        shared_flag(shared_flag && other) noexcept;
 
         /**
          * Move assignment -- acquires the shared state reference from another instance.
@@ -127,16 +168,14 @@ namespace prb
          *  released first.
          * 
          * @param other An existing instance to move a shared state reference from. This must be an
-         *  instance of shared_flag, not shared_flag_reader. It must contain a reference to a shared
-         *  state; i.e. it must not have been moved away.
+         *  instance of shared_flag, not shared_flag_reader. If it does not contain a reference to a
+         *  shared state (i.e. it has already been moved away) then neither will this instance.
          * @return Returns a reference to this instance.
-         * @throw std::logic_error The other instance does not have a reference to a shared state.
-         *  This happens if it has already been moved away.
          * 
-         * @warning If another thread is waiting on the existing instance (by calling one of the
-         *  wait*() functions) then this function will block until the wait has finished.
+         * @note This will not block if another thread is waiting on either instance. Any wait which
+         *  is already in progress continues to wait on the flag it started with.
          */
-        shared_flag & operator=(shared_flag && other);
+        shared_flag & operator=(shared_flag && other) noexcept;
 
         /// Promoting a shared_flag_reader to a shared_flag is not permitted.
         shared_flag(const shared_flag_reader &) = delete;
@@ -171,6 +210,32 @@ namespace prb
          *  a reference to the same shared state.
          */
         void set();
+
+        /**
+         * Set the flag with a reason, and wake any threads which are waiting on it.
+         * The reason is stored in the shared state and published in the same atomic operation as
+         *  the flag. Readers can get it from reason() as soon as they see the flag set.
+         *
+         * Only the first reason is kept. If the flag has already been set, with or without a
+         *  reason, then this does nothing. Child flags inherit the reason from their parents.
+         *
+         * Example of telling workers why they're being stopped:
+         *
+         * @code
+         *      enum class stop_reason { shutdown, deadline, error };
+         *      stop.set(stop_reason::deadline);
+         * @endcode
+         *
+         * @param reason A trivially copyable value, no bigger than detail::max_reason_size (16
+         *  bytes). Enumerators, std::error_code, and small structs are all suitable.
+         * @throw std::logic_error This instance does not have a reference to a shared state. This
+         *  happens if it has been moved away.
+         */
+        template <class T>
+        void set(const T & reason)
+        {
+            checked_state()->set(reason);
+        }
     };
 }
 
@@ -8,11 +8,13 @@
 #ifndef PRB_SHARED_FLAG_READER_HPP_INCLUDED
 #define PRB_SHARED_FLAG_READER_HPP_INCLUDED
 
+#include "detail/atomic_state_ptr.hpp"
+#include "detail/flag_state.hpp"
+#include "detail/state_access.hpp"
+#include "detail/state_ptr.hpp"
+#include "spin_policy.hpp"
 #include <chrono>
-#include <condition_variable>
-#include <memory>
-#include <mutex>
-#include <shared_mutex>
+#include <optional>
 #include <stdexcept>
 
 namespace prb
@@ -92,9 +94,8 @@ namespace prb
          * @throw std::logic_error The other instance does not have a reference to a shared state.
          *  This happens if it has been moved away.
          * 
-         * @warning If another thread is waiting on this instance (by calling one of the wait*()
-         *  functions) then this function will block until the wait has finished.
-         * @note This will not block if another thread is waiting on the other instance.
+         * @note This will not block if another thread is waiting on either instance. Any wait which
+         *  is already in progress continues to wait on the flag it started with.
          */
         shared_flag_reader & operator=(const shared_flag_reader & other);
 
@@ -105,15 +106,13 @@ namespace prb
          *  that unless another reference is copied or assigned into it.
          * 
          * @param other An existing instance to move a shared state reference from. This can be an
-         *  instance of shared_flag or shared_flag_reader. It must contain a reference to a shared
-         *  state; i.e. it must not have been moved away.
-         * @throw std::logic_error The other instance does not have a reference to a shared state.
-         *  This happens if it has already been moved away.
+         *  instance of shared_flag or shared_flag_reader. If it does not contain a reference to a
+         *  shared state (i.e. it has already been moved away) then neither will this instance.
          * 
-         * @warning If another thread is waiting on the existing instance (by calling one of the
-         *  wait*() functions) then this function will block until the wait has finished.
+         * @note This will not block if another thread is waiting on the other instance. Any wait
+         *  which is already in progress continues to wait on the same flag.
          */
-        shared_flag_reader(shared_flag_reader && other);
+        shared_flag_reader(shared_flag_reader && other) noexcept;
 
         /**
          * Move assignment -- acquires the shared state reference from another instance.
@@ -124,16 +123,14 @@ namespace prb
          *  released first.
          * 
          * @param other An existing instance to move a shared state reference from. This can be an
-         *  instance of shared_flag or shared_flag_reader. It must contain a reference to a shared
-         *  state; i.e. it must not have been moved away.
+         *  instance of shared_flag or shared_flag_reader. If it does not contain a reference to a
+         *  shared state (i.e. it has already been moved away) then neither will this instance.
          * @return Returns a reference to this instance.
-         * @throw std::logic_error The other instance does not have a reference to a shared state.
-         *  This happens if it has already been moved away.
          * 
-         * @warning If another thread is waiting on the existing instance (by calling one of the
-         *  wait*() functions) then this function will block until the wait has finished.
+         * @note This will not block if another thread is waiting on either instance. Any wait which
+         *  is already in progress continues to wait on the flag it started with.
          */
-        shared_flag_reader & operator=(shared_flag_reader && other);
+        shared_flag_reader & operator=(shared_flag_reader && other) noexcept;
 
         /**
          * The destructor releases this instance's reference to the shared state, if it has one.
@@ -188,6 +185,56 @@ namespace prb
          */
         operator bool() const;
 
+        /**
+         * Get the reason the flag was set, if it was set with one.
+         * The reason is published atomically with the flag, so no further synchronisation is
+         *  needed. If the flag is seen to be set then its reason is already available.
+         *
+         * Example usage:
+         *
+         * @code
+         *      if (auto why = flag.reason<shutdown_reason>(); why && *why == shutdown_reason::error)
+         *          rollback();
+         * @endcode
+         *
+         * @tparam T The type of reason which was passed to shared_flag::set().
+         * @return Returns a copy of the reason. Returns an empty optional if the flag hasn't been
+         *  set yet, if it was set without a reason, or if the reason was of a different type.
+         * @throw std::logic_error This instance does not contain a reference to a shared state.
+         *  This happens if the contents of this object have been moved away.
+         */
+        template <class T>
+        std::optional<T> reason() const;
+
+#if defined(__linux__)
+        /// The type of handle returned by native_handle().
+        using native_handle_type = int;
+
+        /**
+         * Get a file descriptor which becomes readable when the flag is set.
+         * This lets an event loop based on epoll(), poll(), or select() watch the flag without a
+         *  separate thread. The descriptor is a Linux eventfd, which is created the first time it's
+         *  requested for a particular flag. It stays readable once the flag has been set.
+         *
+         * Example of waiting for either a socket or the flag:
+         *
+         * @code
+         *      pollfd fds[]{ { sock, POLLIN, 0 }, { flag.native_handle(), POLLIN, 0 } };
+         *      poll(fds, 2, -1);
+         * @endcode
+         *
+         * @return Returns the descriptor. Every instance referring to the same shared state gets
+         *  the same one. It remains valid for as long as the shared state exists. It must not be
+         *  read from or closed.
+         * @throw std::logic_error This instance does not contain a reference to a shared state.
+         *  This happens if the contents of this object have been moved away.
+         * @throw std::system_error The eventfd could not be created.
+         *
+         * @note This is only available on Linux.
+         */
+        native_handle_type native_handle() const;
+#endif
+
         /**
          * Block the current thread until the flag has been set.
          * This will return immediately if the flag was already set.
@@ -202,6 +249,19 @@ namespace prb
          */
         void wait() const;
 
+        /**
+         * Block the current thread until the flag has been set, using a specific spin policy.
+         * This will return immediately if the flag was already set.
+         * 
+         * @param policy Determines how long the thread busy-waits before blocking. This overrides
+         *  the flag's default spin policy for this call only.
+         * @throw std::logic_error This instance does not contain a reference to a shared state.
+         *  This happens if the contents of this object have been moved away.
+         * 
+         * @note It is safe to have multiple theads waiting on the same instance at the same time.
+         */
+        void wait(const spin_policy & policy) const;
+
         /**
          * Block the current thread until the flag has been set or the specified time has elapsed.
          * This will return immediately if the flag was already set.
@@ -218,6 +278,29 @@ namespace prb
         template <class Rep, class Period>
         bool wait_for(const std::chrono::duration<Rep, Period> & timeout_duration) const;
 
+        /**
+         * Block the current thread until the flag has been set or the specified time has elapsed,
+         *  using a specific spin policy.
+         * This will return immediately if the flag was already set.
+         * 
+         * @param timeout_duration The maximum period of time to block for. If this time elapses
+         *  before the flag has been set then the function will return false.
+         * @param policy Determines how long the thread busy-waits before blocking. This overrides
+         *  the flag's default spin policy for this call only. The thread never spins for longer
+         *  than the timeout.
+         * @return Returns true if the flag has been set. Returns false if the flag had not been set
+         *  when the timeout expired.
+         * @throw std::logic_error This instance does not contain a reference to a shared state.
+         *  This happens if the contents of this object have been moved away.
+         * 
+         * @note It is safe to have multiple theads waiting on the same instance at the same time.
+         */
+        template <class Rep, class Period>
+        bool wait_for(
+            const std::chrono::duration<Rep, Period> & timeout_duration,
+            const spin_policy & policy
+        ) const;
+
         /**
          * Block the current thread until the flag has been set or the specified time is reached.
          * This will return immediately if the flag was already set.
@@ -234,6 +317,29 @@ namespace prb
         template <class Clock, class Duration>
         bool wait_until(const std::chrono::time_point<Clock,Duration> & timeout_time) const;
 
+        /**
+         * Block the current thread until the flag has been set or the specified time is reached,
+         *  using a specific spin policy.
+         * This will return immediately if the flag was already set.
+         * 
+         * @param timeout_time The maximum time point to block until. If this time point is reached
+         *  before the flag has been set then the function will return false.
+         * @param policy Determines how long the thread busy-waits before blocking. This overrides
+         *  the flag's default spin policy for this call only. The thread never spins beyond the
+         *  timeout.
+         * @return Returns true if the flag has been set. Returns false if the flag had not been set
+         *  when the time point was reached.
+         * @throw std::logic_error This instance does not contain a reference to a shared state.
+         *  This happens if the contents of this object have been moved away.
+         * 
+         * @note It is safe to have multiple theads waiting on the same instance at the same time.
+         */
+        template <class Clock, class Duration>
+        bool wait_until(
+            const std::chrono::time_point<Clock,Duration> & timeout_time,
+            const spin_policy & policy
+        ) const;
+
     protected:
         //------------------------------------------------------------------------------------------
         // Internal operations.
@@ -246,91 +352,94 @@ namespace prb
          */
         shared_flag_reader() = default;
 
+        /**
+         * Construct an instance which refers to the specified shared state.
+         * This is used by sub-classes to create new states.
+         */
+        explicit shared_flag_reader(detail::state_ptr state) noexcept;
+
+        /**
+         * Get a new reference to the shared state referenced by this instance.
+         * The returned pointer keeps the state alive even if this instance is reassigned, e.g. for
+         *  the duration of a wait.
+         * 
+         * @return Returns a pointer to the shared state.
+         * @throw std::logic_error This instance does not contain a reference to a shared state.
+         */
+        detail::state_ptr checked_state() const;
+
 
         //------------------------------------------------------------------------------------------
         // Data.
 
-        /**
-         * This mutex protects access to the m_state pointer.
-         * It must be locked whenever anything uses or changes the pointer.
-         * To avoid deadlock, instances must lock this mutex before locking the mutex within the
-         *  shared state.
-         * If an instance is waiting on the flag then it must retain a shared lock on this mutex
-         *  until it has finished waiting. This ensures the state is not destroyed during the wait.
-         */
-        mutable std::shared_mutex m_state_ptr_mtx;
+        // Allow library components to access the shared state.
+        friend struct detail::state_access;
 
-        // Forward declaration to the shared state structure.
-        struct state;
+        /// The shared state structure which contains the flag.
+        using state = detail::flag_state;
 
         /**
          * A pointer to the shared state referenced by this instance.
          * This will be null if this instance has no shared state. This can happen if a
          *  shared_flag_reader was default-constructed, or the shared state was moved away.
          * 
-         * Access to this variable is protected by m_state_ptr_mtx.
+         * This can safely be read and replaced by multiple threads at the same time. Waiting
+         *  threads take their own reference to the state, so they don't prevent the pointer from
+         *  being replaced.
          * 
          * @todo Manage this manually in future so that we can count the number of remaining writers
          */
-        std::shared_ptr<state> m_state;
-    };
-
-    /**
-     * Contains the shared state referenced by shared_flag_reader and shared_flag instances.
-     * This contains the flag value and the synchronisation primitives which are waited-upon.
-     */
-    struct shared_flag_reader::state
-    {
-        /**
-         * Protects access to m_cond_var and m_flag.
-         * To avoid deadlock, instances of shared_flag_reader and shared_flag must always lock
-         *  their own m_state_ptr_mtx before locking m_state_data_mtx.
-         */
-        mutable std::mutex m_state_data_mtx;
-
-        /**
-         * Allows threads to wait on the flag value and be notified when it changes.
-         * 
-         * This is protected by m_state_data_mtx. Threads waiting on this must lock that
-         *  mutex.
-         */
-        std::condition_variable m_cond_var;
-
-        /**
-         * Indicates if the flag is has been set.
-         * When this has been set to true, it should never return to false.
-         * 
-         * This is protected by m_state_data_mtx.
-         */
-        bool m_flag{ false };
+        detail::atomic_state_ptr m_state;
     };
 
 
     //----------------------------------------------------------------------------------------------
     // Template implementations.
 
+    template <class T>
+    std::optional<T> shared_flag_reader::reason() const
+    {
+        // Like get(), this reads the state while holding the pointer's lock.
+        bool has_state{ false };
+        auto result{ m_state.visit([&has_state](const state * s)
+        {
+            has_state = (s != nullptr);
+            return has_state ? s->reason<T>() : std::optional<T>{};
+        }) };
+
+        if (!has_state)
+            throw std::logic_error{ "Shared state has been moved away." };
+        return result;
+    }
+
     template <class Rep, class Period>
     bool shared_flag_reader::wait_for(const std::chrono::duration<Rep, Period> & timeout_duration) const
     {
-        std::shared_lock outerLock{ m_state_ptr_mtx };
-        if (!m_state)
-            throw std::logic_error{ "Shared state has been moved away." };
+        return checked_state()->wait_for(timeout_duration);
+    }
 
-        std::unique_lock innerLock{ m_state->m_state_data_mtx };
-        m_state->m_cond_var.wait_for(innerLock, timeout_duration, [this]{ return m_state->m_flag; });
-        return m_state->m_flag;
+    template <class Rep, class Period>
+    bool shared_flag_reader::wait_for(
+        const std::chrono::duration<Rep, Period> & timeout_duration,
+        const spin_policy & policy
+    ) const
+    {
+        return checked_state()->wait_for(timeout_duration, policy);
     }
 
     template <class Clock, class Duration>
     bool shared_flag_reader::wait_until(const std::chrono::time_point<Clock,Duration> & timeout_time) const
     {
-        std::shared_lock outerLock{ m_state_ptr_mtx };
-        if (!m_state)
-            throw std::logic_error{ "Shared state has been moved away." };
+        return checked_state()->wait_until(timeout_time);
+    }
 
-        std::unique_lock innerLock{ m_state->m_state_data_mtx };
-        m_state->m_cond_var.wait_until(innerLock, timeout_time, [this]{ return m_state->m_flag; });
-        return m_state->m_flag;
+    template <class Clock, class Duration>
+    bool shared_flag_reader::wait_until(
+        const std::chrono::time_point<Clock,Duration> & timeout_time,
+        const spin_policy & policy
+    ) const
+    {
+        return checked_state()->wait_until(timeout_time, policy);
     }
 }
 
@@ -0,0 +1,164 @@
+/**
+ * @file shared_latch_flag.hpp
+ * @brief Declares a shared flag which is set when a number of parties have counted down.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_SHARED_LATCH_FLAG_HPP_INCLUDED
+#define PRB_SHARED_LATCH_FLAG_HPP_INCLUDED
+
+#include "shared_flag_reader.hpp"
+#include "spin_policy.hpp"
+#include <cstddef>
+
+namespace prb
+{
+    /**
+     * A shared flag which is set automatically when a counter reaches zero.
+     * This works like std::latch. The count is specified on construction, and each party calls
+     *  count_down() when it's finished. The last call sets the flag, and wakes any threads which
+     *  are waiting on it.
+     *
+     * This class is derived from shared_flag_reader, so it can be used anywhere a reader can be
+     *  used: it can be waited on, copied into a shared_flag_reader, passed to wait_any(), used as the
+     *  parent of a child flag, and so on. Code which consumes readers doesn't need to know that the
+     *  flag is a latch. The flag can't be set directly though. It's only set by counting down.
+     *
+     * The count is stored in the flag's shared state, so creating a latch is a single allocation.
+     *  Copies of this class share the same count as well as the same flag. Readers copied from it
+     *  refer to the same state, but can't count down.
+     *
+     * Waiting on and querying the flag follow the same thread-safety rules as shared_flag_reader.
+     *  Counting down is thread-safe as long as no other thread is modifying the same instance (e.g.
+     *  by assigning to it) at the same time. The same rule applies to std::shared_ptr.
+     *
+     * Example of waiting for several subsystems to stop:
+     *
+     * @code
+     *      shared_latch_flag all_stopped{ 3 };
+     *      network.stop_async([all_stopped]() mutable { all_stopped.count_down(); });
+     *      storage.stop_async([all_stopped]() mutable { all_stopped.count_down(); });
+     *      ui.stop_async([all_stopped]() mutable { all_stopped.count_down(); });
+     *
+     *      if (!all_stopped.wait_for(5s))
+     *          log_warning("Some subsystems did not stop in time.");
+     * @endcode
+     */
+    class shared_latch_flag final : public shared_flag_reader
+    {
+    public:
+        //------------------------------------------------------------------------------------------
+        // Construction / destruction.
+
+        /**
+         * Constructor -- generates a new shared state, which holds the count.
+         * If the count is zero then the flag is set straight away.
+         *
+         * @param count The number of times count_down() must be called before the flag is set.
+         * @throw std::invalid_argument The count is negative.
+         */
+        explicit shared_latch_flag(std::ptrdiff_t count);
+
+        /**
+         * Constructor -- generates a new shared state, which holds the count, with a specific
+         *  default spin policy.
+         * See the equivalent shared_flag constructor for details of the spin policy.
+         *
+         * @param count The number of times count_down() must be called before the flag is set.
+         * @param policy Determines how long threads waiting on the flag busy-wait before blocking.
+         * @throw std::invalid_argument The count is negative.
+         */
+        shared_latch_flag(std::ptrdiff_t count, const spin_policy & policy);
+
+        /**
+         * Copy constructor -- copies a reference to the shared state of an existing instance.
+         * Afterwards, counting down on either instance affects both of them.
+         *
+         * @param other An existing instance to copy a reference from. It must not have been moved
+         *  away.
+         * @throw std::logic_error The other instance does not have a reference to a shared state.
+         *  This happens if it has been moved away.
+         */
+        shared_latch_flag(const shared_latch_flag & other);
+
+        /**
+         * Copy assignment -- copies a reference to the shared state of an existing instance.
+         * If this instance previously had a reference to a shared state then it will have been
+         *  released first.
+         *
+         * @param other An existing instance to copy a reference from. It must not have been moved
+         *  away.
+         * @return Returns a reference to this instance.
+         * @throw std::logic_error The other instance does not have a reference to a shared state.
+         *  This happens if it has been moved away.
+         */
+        shared_latch_flag & operator=(const shared_latch_flag & other);
+
+        /**
+         * Move constructor -- acquires the shared state reference from another instance.
+         * Afterwards, the other instance cannot be used unless another instance is assigned to it.
+         *
+         * @param other An existing instance to move references from.
+         */
+        shared_latch_flag(shared_latch_flag && other) noexcept;
+
+        /**
+         * Move assignment -- acquires the shared state reference from another instance.
+         * Afterwards, the other instance cannot be used unless another instance is assigned to it.
+         *
+         * @param other An existing instance to move references from.
+         * @return Returns a reference to this instance.
+         */
+        shared_latch_flag & operator=(shared_latch_flag && other) noexcept;
+
+        /// Promoting a shared_flag_reader to a shared_latch_flag is not permitted.
+        shared_latch_flag(const shared_flag_reader &) = delete;
+
+        /// Promoting a shared_flag_reader to a shared_latch_flag is not permitted.
+        shared_latch_flag & operator=(const shared_flag_reader &) = delete;
+
+        /// Promoting a shared_flag_reader to a shared_latch_flag is not permitted.
+        shared_latch_flag(shared_flag_reader &&) = delete;
+
+        /// Promoting a shared_flag_reader to a shared_latch_flag is not permitted.
+        shared_latch_flag & operator=(shared_flag_reader &&) = delete;
+
+        /**
+         * The destructor releases this instance's reference to the shared state.
+         * Destroying the last instance which can count down doesn't set the flag.
+         */
+        ~shared_latch_flag() override;
+
+
+        //------------------------------------------------------------------------------------------
+        // Accessors / operations.
+
+        /**
+         * Decrement the shared count, and set the flag if it reaches zero.
+         * This reads this instance's pointer to the state without locking it, then decrements the
+         *  count with a single atomic operation. Only the call which reaches zero touches anything
+         *  else. Everything which a thread did before counting down is visible to threads which
+         *  have seen the flag set.
+         * Counting down after the count has reached zero has no further effect.
+         *
+         * @param update The amount to decrement the count by. This must not be negative.
+         * @throw std::invalid_argument The update is negative.
+         * @throw std::logic_error This instance does not have a reference to a shared state. This
+         *  happens if it has been moved away.
+         */
+        void count_down(std::ptrdiff_t update = 1);
+
+        /**
+         * Get the number of times count_down() must still be called before the flag is set.
+         * This is only a snapshot. Other threads may count down at any time.
+         *
+         * @return Returns the remaining count, or zero if the count has been reached.
+         * @throw std::logic_error This instance does not have a reference to a shared state. This
+         *  happens if it has been moved away.
+         */
+        std::ptrdiff_t remaining() const;
+    };
+}
+
+#endif
@@ -0,0 +1,67 @@
+/**
+ * @file signal_flag.hpp
+ * @brief Declares functions for setting flags when the process receives a signal.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_SIGNAL_FLAG_HPP_INCLUDED
+#define PRB_SIGNAL_FLAG_HPP_INCLUDED
+
+#if !defined(__linux__)
+#   error "Setting flags from signal handlers is only available on Linux."
+#endif
+
+#include "shared_flag_reader.hpp"
+#include <csignal>
+#include <initializer_list>
+
+namespace prb
+{
+    /**
+     * Start the background thread which finishes the work of compact_shared_flag::set_from_signal().
+     * A signal handler can only do a limited amount of work safely, so listeners (such as callbacks
+     *  and child flags) are notified by this thread instead. Call this before installing a signal
+     *  handler which sets a flag.
+     *
+     * This does nothing if the thread has already been started. The thread sleeps until it's
+     *  needed, and runs until the program exits.
+     *
+     * @throw std::system_error The thread could not be started.
+     */
+    void start_signal_dispatch();
+
+    /**
+     * Get a flag which is set when the process receives any of the specified signals.
+     * This is intended for shutting down gracefully, without needing a self-pipe or a dedicated
+     *  thread to watch for signals.
+     *
+     * A handler is installed for each of the signals, replacing any previous handler. It sets the
+     *  flag in an async-signal-safe way, via compact_shared_flag::set_from_signal(). The handlers
+     *  stay installed, so the signals have no other effect. If the process must remain
+     *  interruptible, it should exit (or restore the default handlers) once it sees the flag.
+     *
+     * There is one shutdown flag per process. Each call returns a reader for the same flag, and
+     *  can add more signals to it. The flag can't be cleared.
+     *
+     * Example:
+     *
+     * @code
+     *      int main()
+     *      {
+     *          const auto shutdown{ prb::shutdown_on_signals() };
+     *          std::thread worker{ run_worker, shutdown };
+     *          shutdown.wait();
+     *          worker.join();
+     *      }
+     * @endcode
+     *
+     * @param signals The signals which should set the flag. SIGKILL and SIGSTOP can't be handled.
+     * @return Returns a reader for the process-wide shutdown flag.
+     * @throw std::system_error A signal handler could not be installed, or the background thread
+     *  could not be started. Handlers which were installed before the failure are left in place.
+     */
+    shared_flag_reader shutdown_on_signals(std::initializer_list<int> signals = { SIGINT, SIGTERM });
+}
+
+#endif
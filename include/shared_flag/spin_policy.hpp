@@ -0,0 +1,48 @@
+/**
+ * @file spin_policy.hpp
+ * @brief Declares a structure which controls how long a thread busy-waits before blocking.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_SPIN_POLICY_HPP_INCLUDED
+#define PRB_SPIN_POLICY_HPP_INCLUDED
+
+#include <cstdint>
+
+namespace prb
+{
+    /**
+     * Controls how a thread waiting on a flag behaves before it blocks in the kernel.
+     *
+     * A waiting thread goes through up to three phases:
+     *  1. Spin: poll the flag up to spin_count times. Between polls, it executes a CPU pause
+     *      instruction a number of times which doubles after each poll (up to a fixed limit).
+     *  2. Yield: poll the flag up to yield_count times, yielding the rest of its time slice between
+     *      polls.
+     *  3. Park: block until the flag is set or the timeout expires.
+     *
+     * A timed wait never spins or yields beyond its timeout.
+     *
+     * The default policy skips straight to parking. That's the best choice for most threads, as
+     *  spinning burns CPU time which other threads could use. Spinning is mainly useful for threads
+     *  pinned to their own cores, which expect the flag to be set within a few microseconds.
+     *
+     * Example of waiting with a short spin phase:
+     *
+     * @code
+     *      shared_flag_reader flag{ ... };
+     *      flag.wait_for(100us, spin_policy{ 1000, 10 });
+     * @endcode
+     */
+    struct spin_policy
+    {
+        /// The maximum number of times to poll the flag in the spin phase.
+        std::uint32_t spin_count{ 0U };
+
+        /// The maximum number of times to poll the flag in the yield phase.
+        std::uint32_t yield_count{ 0U };
+    };
+}
+
+#endif
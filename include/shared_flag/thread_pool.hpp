@@ -0,0 +1,411 @@
+/**
+ * @file thread_pool.hpp
+ * @brief Declares a work-stealing thread pool whose tasks can be cancelled by shared flags.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_THREAD_POOL_HPP_INCLUDED
+#define PRB_THREAD_POOL_HPP_INCLUDED
+
+#include "detail/handle_traits.hpp"
+#include "detail/state_access.hpp"
+#include "detail/state_ptr.hpp"
+#include "child_of.hpp"
+#include "flag_callback.hpp"
+#include "shared_flag.hpp"
+#include "shared_flag_reader.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace prb::detail
+{
+    /**
+     * A task which has been submitted to a thread_pool, along with the flag which cancels it.
+     * The pool owns each task until it has been run or discarded.
+     */
+    class pool_task
+    {
+    public:
+        //------------------------------------------------------------------------------------------
+        // Construction / destruction.
+
+        /**
+         * Constructor -- stores the task's cancellation flag.
+         *
+         * @param cancel The shared state of the task's own flag. This is empty if the task is only
+         *  cancelled by the pool's flag.
+         */
+        explicit pool_task(state_ptr cancel) noexcept :
+            m_cancel{ std::move(cancel) }
+        {
+        }
+
+        pool_task(const pool_task &) = delete;
+        pool_task & operator=(const pool_task &) = delete;
+        pool_task(pool_task &&) = delete;
+        pool_task & operator=(pool_task &&) = delete;
+        virtual ~pool_task() = default;
+
+
+        //------------------------------------------------------------------------------------------
+        // Accessors / operations.
+
+        /// Check if the task's own flag has been set. This is a single atomic load.
+        bool is_cancelled() const noexcept
+        {
+            return m_cancel && m_cancel->is_set();
+        }
+
+        /**
+         * Run the task.
+         *
+         * @param pool_flag The pool's stop flag. It's passed to the task if the task doesn't have
+         *  a flag of its own.
+         */
+        virtual void run(const shared_flag_reader & pool_flag) noexcept = 0;
+
+    protected:
+        //------------------------------------------------------------------------------------------
+        // Data.
+
+        /// The shared state of the task's own flag, if it has one.
+        state_ptr m_cancel;
+    };
+
+    /// Stores a function which has been submitted to a thread_pool.
+    template <class Function>
+    class pool_task_impl final : public pool_task
+    {
+    public:
+        /**
+         * Store a function, and the flags which cancel it.
+         *
+         * @param cancel The shared state of the task's own flag, if it has one.
+         * @param flag The shared state of the flag to pass to the function, if it isn't the pool's.
+         *  Its parents must have been prepared, but not registered.
+         * @param function The function to run.
+         */
+        template <class F>
+        pool_task_impl(state_ptr cancel, state_ptr flag, F && function) :
+            pool_task{ std::move(cancel) },
+            m_flag{ std::move(flag) },
+            m_function(std::forward<F>(function))
+        {
+        }
+
+        void run(const shared_flag_reader & pool_flag) noexcept override
+        {
+            if constexpr (std::is_invocable_v<Function &, const shared_flag_reader &>)
+            {
+                // The flag is only linked to its parents now, so that queueing and discarding tasks
+                //  never touches the pool's stop flag. The task won't be run again, so its
+                //  reference can be handed over.
+                if (m_flag)
+                {
+                    m_flag->register_parents();
+                    std::invoke(m_function, state_access::make_reader(std::move(m_flag)));
+                }
+                else
+                {
+                    std::invoke(m_function, pool_flag);
+                }
+            }
+            else
+            {
+                std::invoke(m_function);
+            }
+        }
+
+    private:
+        /**
+         * The shared state of the flag passed to the function, if the task has its own flag.
+         * It's a child of both the task's flag and the pool's stop flag, but it isn't registered
+         *  with them until the task runs.
+         */
+        state_ptr m_flag;
+
+        /// The function to run.
+        Function m_function;
+    };
+}
+
+namespace prb
+{
+    /**
+     * A fixed group of worker threads which run tasks, and which can be stopped by a shared flag.
+     *
+     * Each worker has its own queue. Tasks submitted by a worker go into its own queue, and other
+     *  tasks are spread between the queues in turn. A worker takes the newest task from its own
+     *  queue, and steals the oldest one from another queue when its own is empty. This keeps each
+     *  queue's lock mostly uncontended.
+     *
+     * Every task is passed a shared_flag_reader, if it accepts one. A task can be given its own
+     *  flag when it's submitted. A task whose own flag has been set by the time a worker takes it
+     *  is destroyed without running, which costs a single atomic load. The reader passed to the
+     *  task is set when either its own flag or the pool's stop flag is set, so the task can check
+     *  it while it runs to stop part way. A task without its own flag receives the pool's stop
+     *  flag.
+     *
+     * Setting the pool's stop flag, via stop() or via a parent flag, wakes every idle worker. Each
+     *  worker exits as soon as its current task returns, and tasks which are still queued are
+     *  discarded when the pool is destroyed:
+     *
+     * @code
+     *      thread_pool pool{ 4U, child_of, shutdown };
+     *      for (auto & request : requests)
+     *      {
+     *          pool.submit(request.cancel, [&request](const shared_flag_reader & cancelled)
+     *          {
+     *              handle(request, cancelled);
+     *          });
+     *      }
+     * @endcode
+     *
+     * Tasks must not throw exceptions. If one does then std::terminate() is called.
+     *
+     * @note submit(), stop(), and the accessors are thread-safe, and can be called from inside a
+     *  task. The pool must not be destroyed by one of its own tasks.
+     */
+    class thread_pool
+    {
+    public:
+        //------------------------------------------------------------------------------------------
+        // Construction / destruction.
+
+        /**
+         * Constructor -- starts the worker threads.
+         *
+         * @param thread_count The number of worker threads to start. By default, this is the
+         *  number of threads which the hardware can run concurrently.
+         * @throw std::invalid_argument The thread count is zero.
+         * @throw std::system_error A worker thread could not be started.
+         */
+        explicit thread_pool(std::size_t thread_count = default_thread_count());
+
+        /**
+         * Constructor -- starts the worker threads, and stops them when any parent flag is set.
+         *
+         * @param thread_count The number of worker threads to start.
+         * @param parents The flags which stop the pool. Any mixture of shared_flag,
+         *  shared_flag_reader, compact_shared_flag, and compact_shared_flag_reader can be used.
+         * @throw std::invalid_argument The thread count is zero.
+         * @throw std::logic_error One of the parents does not have a reference to a shared state.
+         *  This happens if it has been moved away.
+         * @throw std::system_error A worker thread could not be started.
+         */
+        template <class... Parents, std::enable_if_t<detail::are_flag_handles_v<Parents...>, int> = 0>
+        thread_pool(std::size_t thread_count, child_of_t, const Parents &... parents) :
+            thread_pool{ thread_count, shared_flag{ child_of, parents... } }
+        {
+        }
+
+        thread_pool(const thread_pool &) = delete;
+        thread_pool & operator=(const thread_pool &) = delete;
+        thread_pool(thread_pool &&) = delete;
+        thread_pool & operator=(thread_pool &&) = delete;
+
+        /**
+         * The destructor stops the pool, and waits for the workers to finish their current tasks.
+         * Tasks which are still queued are destroyed without running.
+         */
+        ~thread_pool();
+
+
+        //------------------------------------------------------------------------------------------
+        // Accessors / operations.
+
+        /// Get the number of threads which the hardware can run concurrently, or 1 if it's unknown.
+        static std::size_t default_thread_count() noexcept;
+
+        /// Get the number of worker threads.
+        std::size_t thread_count() const noexcept;
+
+        /**
+         * Get a read-only handle to the pool's stop flag.
+         * This can be used as a parent for per-task flags, so that they're cancelled with the pool.
+         */
+        shared_flag_reader get_stop_flag() const;
+
+        /**
+         * Set the pool's stop flag, without waiting for the workers to finish.
+         * This does nothing if the pool has already been stopped.
+         */
+        void stop() noexcept;
+
+        /**
+         * Get the number of tasks which have been destroyed without running, because their flag
+         *  was set before they were started. This doesn't include tasks discarded when the pool is
+         *  destroyed.
+         */
+        std::size_t discarded_count() const noexcept;
+
+        /**
+         * Queue a task, which is cancelled only when the pool is stopped.
+         *
+         * @param function The function to run. It can accept a const reference to a
+         *  shared_flag_reader, which refers to the pool's stop flag, or no arguments.
+         * @return Returns true if the task was queued. Returns false if the pool has already been
+         *  stopped, in which case the function is destroyed straight away.
+         * @throw std::bad_alloc The task could not be allocated.
+         */
+        template <class Function>
+        bool submit(Function && function)
+        {
+            return push(make_task(detail::state_ptr{}, detail::state_ptr{}, std::forward<Function>(function)));
+        }
+
+        /**
+         * Queue a task which can be cancelled by its own flag.
+         * If the flag is set before a worker starts the task then the task is destroyed without
+         *  running.
+         *
+         * @param cancel The flag which cancels the task. This can be any type of shared flag handle.
+         * @param function The function to run. It can accept a const reference to a
+         *  shared_flag_reader, or no arguments. The reader is set when either the task's flag or
+         *  the pool's stop flag is set.
+         * @return Returns true if the task was queued. Returns false if the pool has already been
+         *  stopped or the flag has already been set, in which case the function is destroyed
+         *  straight away.
+         * @throw std::logic_error The flag does not have a reference to a shared state. This
+         *  happens if it has been moved away.
+         * @throw std::bad_alloc The task could not be allocated.
+         */
+        template <class Handle, class Function, std::enable_if_t<detail::is_flag_handle_v<Handle>, int> = 0>
+        bool submit(const Handle & cancel, Function && function)
+        {
+            auto state{ detail::state_access::get(cancel) };
+            detail::state_ptr flag;
+            if constexpr (std::is_invocable_v<std::decay_t<Function> &, const shared_flag_reader &>)
+            {
+                // The task's own flag is checked before it runs, but while it runs, it also needs to
+                //  hear about the pool stopping. Otherwise the pool's destructor could wait forever.
+                //  The links are only registered when the task runs. See pool_task_impl::run().
+                const detail::state_ptr parents[]{ state, m_stop_state };
+                flag = detail::make_state();
+                flag->prepare_parents(parents, 2U);
+            }
+            return push(make_task(std::move(state), std::move(flag), std::forward<Function>(function)));
+        }
+
+    private:
+        //------------------------------------------------------------------------------------------
+        // Internal operations.
+
+        /// A worker's queue of tasks.
+        struct worker_queue;
+
+        /// Wakes every idle worker when the pool's stop flag is set.
+        struct wake_workers
+        {
+            void operator()() const noexcept;
+
+            thread_pool * pool;
+        };
+
+        /// Store the stop flag, and start the worker threads.
+        thread_pool(std::size_t thread_count, shared_flag stop_flag);
+
+        /// Wrap a function in a task.
+        template <class Function>
+        static std::unique_ptr<detail::pool_task> make_task(
+            detail::state_ptr cancel,
+            detail::state_ptr flag,
+            Function && function
+        )
+        {
+            using function_type = std::decay_t<Function>;
+            static_assert(
+                std::is_invocable_v<function_type &, const shared_flag_reader &> ||
+                    std::is_invocable_v<function_type &>,
+                "The task must be invocable with a shared_flag_reader, or with no arguments."
+            );
+            return std::make_unique<detail::pool_task_impl<function_type>>(
+                std::move(cancel),
+                std::move(flag),
+                std::forward<Function>(function)
+            );
+        }
+
+        /**
+         * Queue a task, and wake an idle worker if there is one.
+         *
+         * @return Returns true if the task was queued, or false if it was discarded.
+         * @throw std::bad_alloc The queue could not grow.
+         */
+        bool push(std::unique_ptr<detail::pool_task> task);
+
+        /// Run tasks on a worker thread until the pool is stopped.
+        void run(std::size_t index) noexcept;
+
+        /**
+         * Take a task which hasn't been cancelled from the worker's own queue, or steal one from
+         *  another queue. Cancelled tasks which are found along the way are discarded.
+         *
+         * @return Returns the task, or null if every queue is empty.
+         */
+        std::unique_ptr<detail::pool_task> find_task(std::size_t index) noexcept;
+
+        /**
+         * Take a task which hasn't been cancelled from one end of a queue, discarding any which
+         *  have been.
+         *
+         * @return Returns the task, or null if the queue is empty.
+         */
+        std::unique_ptr<detail::pool_task> take_task(worker_queue & queue, bool newest) noexcept;
+
+
+        //------------------------------------------------------------------------------------------
+        // Data.
+
+        /// The pool's stop flag.
+        shared_flag m_stop;
+
+        /// The shared state of the stop flag, so that workers can check it without copying it.
+        detail::state_ptr m_stop_state;
+
+        /// The number of worker threads, which is also the number of queues.
+        std::size_t m_thread_count;
+
+        /// One queue for each worker.
+        std::unique_ptr<worker_queue[]> m_queues;
+
+        /// Selects the queue for the next task submitted from outside the pool.
+        std::atomic<std::size_t> m_next_queue{ 0U };
+
+        /// Counts the tasks which were discarded because their flag was set.
+        std::atomic<std::size_t> m_discarded{ 0U };
+
+        /**
+         * Incremented each time a task is queued. An idle worker only goes to sleep if this hasn't
+         *  changed since it last looked for a task, so it can't miss one.
+         */
+        std::atomic<std::uint64_t> m_epoch{ 0U };
+
+        /// The number of workers which are asleep, or about to go to sleep.
+        std::atomic<std::size_t> m_sleepers{ 0U };
+
+        /// Protects the idle workers' condition variable.
+        std::mutex m_idle_mtx;
+
+        /// Wakes idle workers when a task is queued or the pool is stopped.
+        std::condition_variable m_idle_cond_var;
+
+        /// Wakes every idle worker when the stop flag is set, however it's set.
+        flag_callback<wake_workers> m_wake_on_stop;
+
+        /// The worker threads.
+        std::vector<std::thread> m_threads;
+    };
+}
+
+#endif
@@ -0,0 +1,453 @@
+/**
+ * @file wait_multiple.hpp
+ * @brief Declares functions which block the current thread on several shared flags at once.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_WAIT_MULTIPLE_HPP_INCLUDED
+#define PRB_WAIT_MULTIPLE_HPP_INCLUDED
+
+#include "detail/deadline.hpp"
+#include "detail/handle_traits.hpp"
+#include "detail/multi_wait.hpp"
+#include "detail/state_access.hpp"
+#include "compact_shared_flag_reader.hpp"
+#include "shared_flag_reader.hpp"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/*
+ * These functions block the current thread until any or all of a set of flags have been set. The
+ *  flags can be given as separate arguments, or as a range (such as a std::vector). Any mixture of
+ *  shared_flag, shared_flag_reader, compact_shared_flag, and compact_shared_flag_reader can be
+ *  used.
+ *
+ * The thread blocks once, no matter how many flags are involved. Nothing polls the flags, and no
+ *  helper threads are used. Waiting on separate arguments doesn't allocate memory; waiting on a
+ *  range allocates a single block.
+ *
+ * Example of stopping an I/O thread if either the whole application or a single connection is
+ *  cancelled:
+ *
+ * @code
+ *      void handle_connection(shared_flag_reader shutdown, shared_flag_reader cancelled)
+ *      {
+ *          // This gets 0 if shutdown was set, or 1 if cancelled was set.
+ *          std::optional<std::size_t> stopped;
+ *          while (!(stopped = wait_any_for(100ms, shutdown, cancelled)))
+ *          {
+ *              // Do some periodic work here.
+ *          }
+ *      }
+ * @endcode
+ */
+
+namespace prb
+{
+    namespace detail
+    {
+        /// Storage for the entries needed to wait on a fixed number of flags.
+        template <std::size_t Count>
+        using wait_entry_array = std::array<multi_wait_entry, Count>;
+
+        /**
+         * Get the state of each handle, ready to pass to wait_any_state() or wait_all_states().
+         *
+         * @param entries The entries to store the states in. There must be one for each handle.
+         * @param handles The handles to get the states from.
+         * @throw std::logic_error One of the handles does not have a reference to a shared state.
+         */
+        template <class... Handles>
+        void fill_wait_entries(multi_wait_entry * entries, const Handles &... handles)
+        {
+            ((entries++->state = state_access::get(handles)), ...);
+        }
+
+        /// A dynamically allocated array of wait entries.
+        struct wait_entry_list
+        {
+            std::unique_ptr<multi_wait_entry[]> entries;
+            std::size_t count{ 0U };
+
+            multi_wait_entry * data() const noexcept
+            {
+                return entries.get();
+            }
+
+            std::size_t size() const noexcept
+            {
+                return count;
+            }
+        };
+
+        /**
+         * Allocate an entry for each handle in a range, and get the handle's state.
+         *
+         * @throw std::logic_error One of the handles does not have a reference to a shared state.
+         */
+        template <class Range>
+        wait_entry_list make_wait_entries_from_range(const Range & handles)
+        {
+            const auto count{ static_cast<std::size_t>(
+                std::distance(std::begin(handles), std::end(handles))
+            ) };
+            wait_entry_list result{ std::make_unique<multi_wait_entry[]>(count), count };
+
+            std::size_t index{ 0U };
+            for (const auto & handle : handles)
+                result.entries[index++].state = state_access::get(handle);
+            return result;
+        }
+
+        /**
+         * Implements the timed "any" operations on a list of entries.
+         *
+         * @throw std::invalid_argument The list is empty.
+         */
+        template <class Entries, class Clock, class Duration>
+        std::optional<std::size_t> wait_any_entries_until(
+            Entries & entries,
+            const std::chrono::time_point<Clock, Duration> & timeout_time
+        )
+        {
+            if (entries.size() == 0U)
+                throw std::invalid_argument{ "There must be at least one flag to wait on." };
+            return wait_until_deadline(timeout_time, [&](std::chrono::steady_clock::time_point deadline)
+            {
+                return wait_any_state(entries.data(), entries.size(), deadline);
+            });
+        }
+
+        /// Implements the timed "all" operations on a list of entries.
+        template <class Entries, class Clock, class Duration>
+        bool wait_all_entries_until(
+            Entries & entries,
+            const std::chrono::time_point<Clock, Duration> & timeout_time
+        )
+        {
+            return wait_until_deadline(timeout_time, [&](std::chrono::steady_clock::time_point deadline)
+            {
+                return wait_all_states(entries.data(), entries.size(), deadline);
+            });
+        }
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // wait_any()
+
+    /**
+     * Block the current thread until any of several flags has been set.
+     * This will return immediately if any of the flags were already set.
+     *
+     * @param handles The flags to wait on. Each one can be any type of shared flag handle.
+     * @return Returns the zero-based position of a flag which has been set. If several flags were
+     *  already set, this is the lowest such position.
+     * @throw std::logic_error One of the handles does not have a reference to a shared state. This
+     *  happens if it has been moved away.
+     */
+    template <class... Handles, std::enable_if_t<detail::are_flag_handles_v<Handles...>, int> = 0>
+    std::size_t wait_any(const Handles &... handles)
+    {
+        detail::wait_entry_array<sizeof...(Handles)> entries;
+        detail::fill_wait_entries(entries.data(), handles...);
+        return *detail::wait_any_state(entries.data(), entries.size(), detail::no_deadline);
+    }
+
+    /**
+     * Block the current thread until any flag in a range has been set.
+     * This will return immediately if any of the flags were already set.
+     *
+     * @param handles A range of flags to wait on, such as a std::vector<shared_flag_reader>.
+     * @return Returns the zero-based position in the range of a flag which has been set. If
+     *  several flags were already set, this is the lowest such position.
+     * @throw std::invalid_argument The range is empty.
+     * @throw std::logic_error One of the handles does not have a reference to a shared state. This
+     *  happens if it has been moved away.
+     */
+    template <class Range, std::enable_if_t<detail::is_flag_handle_range_v<Range>, int> = 0>
+    std::size_t wait_any(const Range & handles)
+    {
+        auto entries{ detail::make_wait_entries_from_range(handles) };
+        if (entries.size() == 0U)
+            throw std::invalid_argument{ "There must be at least one flag to wait on." };
+        return *detail::wait_any_state(entries.data(), entries.size(), detail::no_deadline);
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // wait_any_until()
+
+    /**
+     * Block the current thread until any of several flags has been set, or the specified time is
+     *  reached.
+     * This will return immediately if any of the flags were already set.
+     *
+     * @param timeout_time The maximum time point to block until.
+     * @param handles The flags to wait on. Each one can be any type of shared flag handle.
+     * @return Returns the zero-based position of a flag which has been set. Returns an empty
+     *  optional if none of the flags had been set when the time point was reached.
+     * @throw std::logic_error One of the handles does not have a reference to a shared state. This
+     *  happens if it has been moved away.
+     */
+    template <
+        class Clock, class Duration, class... Handles,
+        std::enable_if_t<detail::are_flag_handles_v<Handles...>, int> = 0
+    >
+    std::optional<std::size_t> wait_any_until(
+        const std::chrono::time_point<Clock, Duration> & timeout_time,
+        const Handles &... handles
+    )
+    {
+        detail::wait_entry_array<sizeof...(Handles)> entries;
+        detail::fill_wait_entries(entries.data(), handles...);
+        return detail::wait_any_entries_until(entries, timeout_time);
+    }
+
+    /**
+     * Block the current thread until any flag in a range has been set, or the specified time is
+     *  reached.
+     * This will return immediately if any of the flags were already set.
+     *
+     * @param timeout_time The maximum time point to block until.
+     * @param handles A range of flags to wait on, such as a std::vector<shared_flag_reader>.
+     * @return Returns the zero-based position in the range of a flag which has been set. Returns
+     *  an empty optional if none of the flags had been set when the time point was reached.
+     * @throw std::invalid_argument The range is empty.
+     * @throw std::logic_error One of the handles does not have a reference to a shared state. This
+     *  happens if it has been moved away.
+     */
+    template <
+        class Clock, class Duration, class Range,
+        std::enable_if_t<detail::is_flag_handle_range_v<Range>, int> = 0
+    >
+    std::optional<std::size_t> wait_any_until(
+        const std::chrono::time_point<Clock, Duration> & timeout_time,
+        const Range & handles
+    )
+    {
+        auto entries{ detail::make_wait_entries_from_range(handles) };
+        return detail::wait_any_entries_until(entries, timeout_time);
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // wait_any_for()
+
+    /**
+     * Block the current thread until any of several flags has been set, or the specified time has
+     *  elapsed.
+     * This will return immediately if any of the flags were already set.
+     *
+     * @param timeout_duration The maximum period of time to block for.
+     * @param handles The flags to wait on. Each one can be any type of shared flag handle.
+     * @return Returns the zero-based position of a flag which has been set. Returns an empty
+     *  optional if none of the flags had been set when the timeout expired.
+     * @throw std::logic_error One of the handles does not have a reference to a shared state. This
+     *  happens if it has been moved away.
+     */
+    template <
+        class Rep, class Period, class... Handles,
+        std::enable_if_t<detail::are_flag_handles_v<Handles...>, int> = 0
+    >
+    std::optional<std::size_t> wait_any_for(
+        const std::chrono::duration<Rep, Period> & timeout_duration,
+        const Handles &... handles
+    )
+    {
+        detail::wait_entry_array<sizeof...(Handles)> entries;
+        detail::fill_wait_entries(entries.data(), handles...);
+        return detail::wait_any_state(
+            entries.data(), entries.size(), detail::deadline_after(timeout_duration)
+        );
+    }
+
+    /**
+     * Block the current thread until any flag in a range has been set, or the specified time has
+     *  elapsed.
+     * This will return immediately if any of the flags were already set.
+     *
+     * @param timeout_duration The maximum period of time to block for.
+     * @param handles A range of flags to wait on, such as a std::vector<shared_flag_reader>.
+     * @return Returns the zero-based position in the range of a flag which has been set. Returns
+     *  an empty optional if none of the flags had been set when the timeout expired.
+     * @throw std::invalid_argument The range is empty.
+     * @throw std::logic_error One of the handles does not have a reference to a shared state. This
+     *  happens if it has been moved away.
+     */
+    template <
+        class Rep, class Period, class Range,
+        std::enable_if_t<detail::is_flag_handle_range_v<Range>, int> = 0
+    >
+    std::optional<std::size_t> wait_any_for(
+        const std::chrono::duration<Rep, Period> & timeout_duration,
+        const Range & handles
+    )
+    {
+        auto entries{ detail::make_wait_entries_from_range(handles) };
+        if (entries.size() == 0U)
+            throw std::invalid_argument{ "There must be at least one flag to wait on." };
+        return detail::wait_any_state(
+            entries.data(), entries.size(), detail::deadline_after(timeout_duration)
+        );
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // wait_all()
+
+    /**
+     * Block the current thread until all of several flags have been set.
+     * This will return immediately if all of the flags were already set.
+     *
+     * @param handles The flags to wait on. Each one can be any type of shared flag handle.
+     * @throw std::logic_error One of the handles does not have a reference to a shared state. This
+     *  happens if it has been moved away.
+     */
+    template <class... Handles, std::enable_if_t<detail::are_flag_handles_v<Handles...>, int> = 0>
+    void wait_all(const Handles &... handles)
+    {
+        detail::wait_entry_array<sizeof...(Handles)> entries;
+        detail::fill_wait_entries(entries.data(), handles...);
+        detail::wait_all_states(entries.data(), entries.size(), detail::no_deadline);
+    }
+
+    /**
+     * Block the current thread until all of the flags in a range have been set.
+     * This will return immediately if all of the flags were already set, or if the range is empty.
+     *
+     * @param handles A range of flags to wait on, such as a std::vector<shared_flag_reader>.
+     * @throw std::logic_error One of the handles does not have a reference to a shared state. This
+     *  happens if it has been moved away.
+     */
+    template <class Range, std::enable_if_t<detail::is_flag_handle_range_v<Range>, int> = 0>
+    void wait_all(const Range & handles)
+    {
+        auto entries{ detail::make_wait_entries_from_range(handles) };
+        detail::wait_all_states(entries.data(), entries.size(), detail::no_deadline);
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // wait_all_until()
+
+    /**
+     * Block the current thread until all of several flags have been set, or the specified time is
+     *  reached.
+     * This will return immediately if all of the flags were already set.
+     *
+     * @param timeout_time The maximum time point to block until.
+     * @param handles The flags to wait on. Each one can be any type of shared flag handle.
+     * @return Returns true if all of the flags have been set. Returns false if at least one flag
+     *  had not been set when the time point was reached.
+     * @throw std::logic_error One of the handles does not have a reference to a shared state. This
+     *  happens if it has been moved away.
+     */
+    template <
+        class Clock, class Duration, class... Handles,
+        std::enable_if_t<detail::are_flag_handles_v<Handles...>, int> = 0
+    >
+    bool wait_all_until(
+        const std::chrono::time_point<Clock, Duration> & timeout_time,
+        const Handles &... handles
+    )
+    {
+        detail::wait_entry_array<sizeof...(Handles)> entries;
+        detail::fill_wait_entries(entries.data(), handles...);
+        return detail::wait_all_entries_until(entries, timeout_time);
+    }
+
+    /**
+     * Block the current thread until all of the flags in a range have been set, or the specified
+     *  time is reached.
+     * This will return immediately if all of the flags were already set, or if the range is empty.
+     *
+     * @param timeout_time The maximum time point to block until.
+     * @param handles A range of flags to wait on, such as a std::vector<shared_flag_reader>.
+     * @return Returns true if all of the flags have been set. Returns false if at least one flag
+     *  had not been set when the time point was reached.
+     * @throw std::logic_error One of the handles does not have a reference to a shared state. This
+     *  happens if it has been moved away.
+     */
+    template <
+        class Clock, class Duration, class Range,
+        std::enable_if_t<detail::is_flag_handle_range_v<Range>, int> = 0
+    >
+    bool wait_all_until(
+        const std::chrono::time_point<Clock, Duration> & timeout_time,
+        const Range & handles
+    )
+    {
+        auto entries{ detail::make_wait_entries_from_range(handles) };
+        return detail::wait_all_entries_until(entries, timeout_time);
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // wait_all_for()
+
+    /**
+     * Block the current thread until all of several flags have been set, or the specified time has
+     *  elapsed.
+     * This will return immediately if all of the flags were already set.
+     *
+     * @param timeout_duration The maximum period of time to block for.
+     * @param handles The flags to wait on. Each one can be any type of shared flag handle.
+     * @return Returns true if all of the flags have been set. Returns false if at least one flag
+     *  had not been set when the timeout expired.
+     * @throw std::logic_error One of the handles does not have a reference to a shared state. This
+     *  happens if it has been moved away.
+     */
+    template <
+        class Rep, class Period, class... Handles,
+        std::enable_if_t<detail::are_flag_handles_v<Handles...>, int> = 0
+    >
+    bool wait_all_for(
+        const std::chrono::duration<Rep, Period> & timeout_duration,
+        const Handles &... handles
+    )
+    {
+        detail::wait_entry_array<sizeof...(Handles)> entries;
+        detail::fill_wait_entries(entries.data(), handles...);
+        return detail::wait_all_states(
+            entries.data(), entries.size(), detail::deadline_after(timeout_duration)
+        );
+    }
+
+    /**
+     * Block the current thread until all of the flags in a range have been set, or the specified
+     *  time has elapsed.
+     * This will return immediately if all of the flags were already set, or if the range is empty.
+     *
+     * @param timeout_duration The maximum period of time to block for.
+     * @param handles A range of flags to wait on, such as a std::vector<shared_flag_reader>.
+     * @return Returns true if all of the flags have been set. Returns false if at least one flag
+     *  had not been set when the timeout expired.
+     * @throw std::logic_error One of the handles does not have a reference to a shared state. This
+     *  happens if it has been moved away.
+     */
+    template <
+        class Rep, class Period, class Range,
+        std::enable_if_t<detail::is_flag_handle_range_v<Range>, int> = 0
+    >
+    bool wait_all_for(
+        const std::chrono::duration<Rep, Period> & timeout_duration,
+        const Range & handles
+    )
+    {
+        auto entries{ detail::make_wait_entries_from_range(handles) };
+        return detail::wait_all_states(
+            entries.data(), entries.size(), detail::deadline_after(timeout_duration)
+        );
+    }
+}
+
+#endif
@@ -0,0 +1,36 @@
+/**
+ * @file auto_reset_event.cpp
+ * @brief Defines handles to a shared event which releases one waiting thread each time it's set.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include "shared_flag/auto_reset_event.hpp"
+#include <utility>
+
+namespace prb
+{
+    //----------------------------------------------------------------------------------------------
+    // Construction / destruction.
+
+    auto_reset_event_reader::auto_reset_event_reader(detail::event_state_ptr state) noexcept :
+        m_state{ std::move(state) }
+    {
+    }
+
+    auto_reset_event::auto_reset_event(bool initially_set) :
+        auto_reset_event_reader{
+            detail::event_state_ptr{ new detail::event_state(detail::event_reset::automatic, initially_set) }
+        }
+    {
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // Accessors / operations.
+
+    void auto_reset_event_reader::wait() const
+    {
+        checked_state().wait_until(detail::no_deadline, 0U);
+    }
+}
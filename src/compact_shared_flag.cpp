@@ -0,0 +1,30 @@
+/**
+ * @file compact_shared_flag.cpp
+ * @brief Defines a lightweight handle which can read and write the state of a shared flag.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include "shared_flag/compact_shared_flag.hpp"
+#include "shared_flag/shared_flag.hpp"
+
+namespace prb
+{
+    //----------------------------------------------------------------------------------------------
+    // Construction / destruction.
+
+    compact_shared_flag::compact_shared_flag() :
+        compact_shared_flag_reader{ detail::make_state() }
+    {
+    }
+
+    compact_shared_flag::compact_shared_flag(const spin_policy & policy) :
+        compact_shared_flag_reader{ detail::make_state(policy) }
+    {
+    }
+
+    compact_shared_flag::compact_shared_flag(const shared_flag & other) :
+        compact_shared_flag_reader{ detail::state_access::get(other) }
+    {
+    }
+}
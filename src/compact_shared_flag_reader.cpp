@@ -0,0 +1,40 @@
+/**
+ * @file compact_shared_flag_reader.cpp
+ * @brief Defines a lightweight handle which can read the state of a shared flag.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include "shared_flag/compact_shared_flag_reader.hpp"
+#include "shared_flag/shared_flag_reader.hpp"
+#include <utility>
+
+namespace prb
+{
+    //----------------------------------------------------------------------------------------------
+    // Construction / destruction.
+
+    compact_shared_flag_reader::compact_shared_flag_reader(const shared_flag_reader & other) :
+        m_state{ detail::state_access::get(other) }
+    {
+    }
+
+    compact_shared_flag_reader::compact_shared_flag_reader(detail::state_ptr state) noexcept :
+        m_state{ std::move(state) }
+    {
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // Accessors / operations.
+
+    void compact_shared_flag_reader::wait() const
+    {
+        checked_state().wait();
+    }
+
+    void compact_shared_flag_reader::wait(const spin_policy & policy) const
+    {
+        checked_state().wait(policy);
+    }
+}
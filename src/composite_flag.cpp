@@ -0,0 +1,73 @@
+/**
+ * @file composite_flag.cpp
+ * @brief Defines a read-only flag which is set when any of a changeable group of flags is set.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include "shared_flag/composite_flag.hpp"
+#include <utility>
+
+namespace prb
+{
+    //----------------------------------------------------------------------------------------------
+    // Construction / destruction.
+
+    composite_flag::composite_flag() :
+        shared_flag_reader{ detail::make_child_state({}) }
+    {
+    }
+
+    composite_flag::composite_flag(const composite_flag & other) : shared_flag_reader(other)
+    {
+    }
+
+    composite_flag & composite_flag::operator=(const composite_flag & other)
+    {
+        shared_flag_reader::operator=(other);
+        return *this;
+    }
+
+    composite_flag::composite_flag(composite_flag && other) noexcept :
+        shared_flag_reader(std::move(other))
+    {
+    }
+
+    composite_flag & composite_flag::operator=(composite_flag && other) noexcept
+    {
+        shared_flag_reader::operator=(std::move(other));
+        return *this;
+    }
+
+    composite_flag::~composite_flag()
+    {
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // Accessors / operations.
+
+    void composite_flag::attach(const shared_flag_reader & source)
+    {
+        auto source_state{ detail::state_access::get(source) };
+        checked_state()->attach_parent(std::move(source_state));
+    }
+
+    void composite_flag::attach(const compact_shared_flag_reader & source)
+    {
+        auto source_state{ detail::state_access::get(source) };
+        checked_state()->attach_parent(std::move(source_state));
+    }
+
+    bool composite_flag::detach(const shared_flag_reader & source)
+    {
+        const auto source_state{ detail::state_access::get(source) };
+        return checked_state()->detach_parent(*source_state);
+    }
+
+    bool composite_flag::detach(const compact_shared_flag_reader & source)
+    {
+        const auto source_state{ detail::state_access::get(source) };
+        return checked_state()->detach_parent(*source_state);
+    }
+}
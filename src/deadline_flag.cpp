@@ -0,0 +1,18 @@
+/**
+ * @file deadline_flag.cpp
+ * @brief Defines functions which create shared flags that set themselves at a deadline.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include "shared_flag/deadline_flag.hpp"
+
+namespace prb
+{
+    shared_flag make_deadline_flag(std::chrono::steady_clock::time_point deadline)
+    {
+        shared_flag flag;
+        detail::state_access::get(flag)->set_at(deadline);
+        return flag;
+    }
+}
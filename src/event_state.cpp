@@ -0,0 +1,133 @@
+/**
+ * @file event_state.cpp
+ * @brief Defines the shared state referenced by the resettable event handles.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include "shared_flag/detail/event_state.hpp"
+
+#if defined(PRB_SHARED_FLAG_USE_FUTEX)
+#   include "futex.hpp"
+#endif
+
+namespace prb::detail
+{
+    //----------------------------------------------------------------------------------------------
+    // Construction / destruction.
+
+    event_state::event_state(event_reset mode, bool initially_set) noexcept :
+        m_mode{ mode },
+        m_word{ initially_set ? set_bit : 0U }
+    {
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // Accessors / operations.
+
+    void event_state::set() noexcept
+    {
+        auto current{ m_word.load(std::memory_order_relaxed) };
+        do
+        {
+            if ((current & set_bit) != 0U)
+                return;
+        }
+        while (!m_word.compare_exchange_weak(current, (current | set_bit) + generation_increment));
+
+        if (m_waiters.load() == 0U)
+            return;
+
+        // An auto-reset event only needs to wake one thread, as only one of them can reset it.
+        //  The thread which is woken always tries to reset the event before giving up, even if its
+        //  deadline has passed, so the wake-up can't be lost.
+#if defined(PRB_SHARED_FLAG_USE_FUTEX)
+        if (m_mode == event_reset::manual)
+            futex_wake_all(m_word);
+        else
+            futex_wake_one(m_word);
+#else
+        // Briefly locking the mutex ensures that any thread which saw the event reset has finished
+        //  going to sleep before it's notified.
+        {
+            std::lock_guard lock{ m_mtx };
+        }
+        if (m_mode == event_reset::manual)
+            m_cond_var.notify_all();
+        else
+            m_cond_var.notify_one();
+#endif
+    }
+
+    void event_state::reset() noexcept
+    {
+        m_word.fetch_and(~set_bit, std::memory_order_release);
+    }
+
+    bool event_state::try_wait() noexcept
+    {
+        if (m_mode == event_reset::manual)
+            return is_set();
+        return try_release(0U);
+    }
+
+    bool event_state::wait_until(std::chrono::steady_clock::time_point deadline, std::uint32_t start_generation)
+    {
+        if (try_release(start_generation))
+            return true;
+
+        const bool has_deadline{ deadline != no_deadline };
+        if (has_deadline && std::chrono::steady_clock::now() >= deadline)
+            return false;
+
+        m_waiters.fetch_add(1U);
+#if defined(PRB_SHARED_FLAG_USE_FUTEX)
+        bool released{ false };
+        for (;;)
+        {
+            // If the event changes after this, the futex won't block.
+            const auto current{ m_word.load() };
+            if (try_release(start_generation))
+            {
+                released = true;
+                break;
+            }
+            if (has_deadline && std::chrono::steady_clock::now() >= deadline)
+                break;
+            futex_wait(m_word, current, deadline);
+        }
+#else
+        const auto predicate{ [&] { return try_release(start_generation); } };
+        bool released{ true };
+        {
+            std::unique_lock lock{ m_mtx };
+            if (has_deadline)
+                released = m_cond_var.wait_until(lock, deadline, predicate);
+            else
+                m_cond_var.wait(lock, predicate);
+        }
+#endif
+        m_waiters.fetch_sub(1U, std::memory_order_relaxed);
+        return released;
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // Internal operations.
+
+    bool event_state::try_release(std::uint32_t start_generation) noexcept
+    {
+        // This is sequentially consistent, as it may be the waiter's final check before blocking.
+        auto current{ m_word.load() };
+        if (m_mode == event_reset::manual)
+            return (current & set_bit) != 0U || (current >> generation_shift) != start_generation;
+
+        while ((current & set_bit) != 0U)
+        {
+            if (m_word.compare_exchange_weak(current, current & ~set_bit, std::memory_order_acq_rel))
+                return true;
+        }
+        return false;
+    }
+}
@@ -0,0 +1,729 @@
+/**
+ * @file flag_state.cpp
+ * @brief Defines the shared state referenced by instances of shared_flag and shared_flag_reader.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include "shared_flag/detail/flag_state.hpp"
+#include "shared_flag/detail/flag_listener.hpp"
+#include "shared_flag/detail/state_ptr.hpp"
+#include "shared_flag/detail/timer_service.hpp"
+#include "shared_flag/deadline_reached.hpp"
+#include <algorithm>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#   include <intrin.h>
+#endif
+
+#if defined(__linux__)
+#   include <cerrno>
+#   include <cstdint>
+#   include <sys/eventfd.h>
+#   include <system_error>
+#   include <unistd.h>
+#endif
+
+#if defined(PRB_SHARED_FLAG_USE_FUTEX)
+#   include "futex.hpp"
+#endif
+
+namespace prb::detail
+{
+    namespace
+    {
+        /// The maximum number of pause instructions executed between two polls of the flag.
+        constexpr std::uint32_t max_spin_backoff{ 64U };
+
+        /**
+         * Tell the CPU that the current thread is busy-waiting.
+         * This saves power, and avoids starving another hyper-thread on the same core.
+         */
+        inline void cpu_relax() noexcept
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+            _mm_pause();
+#elif defined(__aarch64__)
+            asm volatile("yield" ::: "memory");
+#endif
+        }
+
+#if !defined(PRB_SHARED_FLAG_PACKED_STATE)
+        // The flag word and the reference count must not share a cache line.
+        static_assert(alignof(flag_state) == cache_line_size);
+        static_assert(sizeof(flag_state) >= 2U * cache_line_size);
+#endif
+    }
+
+    /**
+     * Registers a child state with one of its parents, so that setting the parent sets the child.
+     * The child owns its links, and removes them from the parents before it's destroyed, so the
+     *  child pointer is always valid while the callback can be called.
+     */
+    class parent_link final : public flag_listener
+    {
+    public:
+        /**
+         * Construct a link which isn't registered yet.
+         *
+         * @param parent_state The state to link to.
+         * @param child_state The state to set when the parent is set.
+         */
+        parent_link(state_ptr parent_state, flag_state * child_state) noexcept :
+            flag_listener{ &on_parent_set },
+            parent{ std::move(parent_state) },
+            child{ child_state }
+        {
+        }
+
+        /// The parent state. This keeps it alive for as long as the link might be registered.
+        const state_ptr parent;
+
+        /// The state to set when the parent is set.
+        flag_state * const child;
+
+    private:
+        /**
+         * Called by the parent state when it's set.
+         * A reference to the child is held while setting it, in case one of its listeners releases
+         *  the last handle to it. If the child's destructor is already running, it's waiting for
+         *  this to return, so there's no point setting it.
+         */
+        static void on_parent_set(flag_listener & listener) noexcept
+        {
+            const auto child{ state_ptr::try_share(static_cast<parent_link &>(listener).child) };
+            if (child)
+                child->set_from(*static_cast<parent_link &>(listener).parent);
+        }
+    };
+
+    /**
+     * Sets a state when its deadline is reached, via the shared timer service.
+     * The state owns the timer, and cancels it before it's destroyed, so the state pointer is
+     *  always valid while the timer can fire. The timer also listens to the state, so that it can
+     *  leave the timer wheel as soon as the flag is set some other way.
+     */
+    class deadline_timer final : public flag_listener, public timer_entry
+    {
+    public:
+        /**
+         * Construct a timer which isn't scheduled yet.
+         *
+         * @param owner The state to set when the deadline is reached.
+         */
+        explicit deadline_timer(flag_state * owner) noexcept :
+            flag_listener{ &on_set },
+            timer_entry{ &on_deadline },
+            state{ owner }
+        {
+        }
+
+        /// The state to set when the deadline is reached.
+        flag_state * const state;
+
+    private:
+        /// Called by the state when it's set, whether by this timer or anything else.
+        static void on_set(flag_listener & listener) noexcept
+        {
+            timer_service::instance().cancel(static_cast<deadline_timer &>(listener));
+        }
+
+        /**
+         * Called by the timer service when the deadline is reached.
+         * As with parent_link, a reference is held while setting the state. If the state's
+         *  destructor is already running then it's waiting for this to return.
+         */
+        static void on_deadline(timer_entry & timer) noexcept
+        {
+            const auto state{ state_ptr::try_share(static_cast<deadline_timer &>(timer).state) };
+            if (state)
+                state->set(deadline_reached{});
+        }
+    };
+
+    /// The links from a child state to its parents.
+    class parent_set
+    {
+    public:
+        /**
+         * Protects the list of links.
+         * It's never held while registering a parent's listener could call back into user code.
+         */
+        std::mutex mtx;
+
+        /// The links to each parent. A list is used so that links don't move when others change.
+        std::list<parent_link> links;
+
+        /// Indicates if the links have been registered with their parents.
+        bool registered{ false };
+    };
+
+#if defined(__linux__)
+    namespace
+    {
+        /**
+         * Make an eventfd readable, by adding to its counter.
+         * The counter is never read, so it stays readable from then on.
+         */
+        void signal_eventfd(int eventfd) noexcept
+        {
+            const std::uint64_t increment{ 1U };
+            while (::write(eventfd, &increment, sizeof(increment)) < 0 && errno == EINTR)
+            {
+            }
+        }
+
+        // These are used in signal handlers, so they must not fall back to a lock.
+        static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+        static_assert(std::atomic<flag_state *>::is_always_lock_free);
+        static_assert(std::atomic<int>::is_always_lock_free);
+
+        /**
+         * The top of a stack of states which set_from_signal() has deferred to the dispatch thread.
+         * Each state is linked to the next via its own m_next_deferred member.
+         */
+        std::atomic<flag_state *> deferred_states{ nullptr };
+
+        /// The eventfd which wakes the signal dispatch thread, or -1 if it hasn't been started.
+        std::atomic<int> dispatch_eventfd{ -1 };
+    }
+#endif
+
+
+    //----------------------------------------------------------------------------------------------
+    // Construction / destruction.
+
+    flag_state::flag_state(const spin_policy & policy) noexcept :
+        m_spin_policy{ policy }
+    {
+    }
+
+    flag_state::~flag_state()
+    {
+        if (m_deadline_timer)
+        {
+            remove_listener(*m_deadline_timer);
+            timer_service::instance().cancel(*m_deadline_timer);
+            delete m_deadline_timer;
+        }
+
+        // Removing a link waits for its callback if a parent is being set on another thread, so
+        //  nothing touches this state after the links have been removed.
+        if (m_parents)
+        {
+            if (m_parents->registered)
+            {
+                for (auto & link : m_parents->links)
+                    link.parent->remove_listener(link);
+            }
+            delete m_parents;
+        }
+
+#if defined(__linux__)
+        const auto eventfd{ m_eventfd.load(std::memory_order_relaxed) };
+        if (eventfd != -1)
+            ::close(eventfd);
+#endif
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // Accessors / operations.
+
+    void flag_state::set() noexcept
+    {
+        const auto previous{ m_flag.fetch_or(set_bit, std::memory_order_acq_rel) };
+        if ((previous & set_bit) == 0U)
+            finish_set(previous);
+    }
+
+    void flag_state::set_from(const flag_state & source) noexcept
+    {
+        if ((source.m_flag.load(std::memory_order_acquire) & has_reason_bit) != 0U)
+            set_with_reason(source.m_reason, max_reason_size, source.m_reason_type);
+        else
+            set();
+    }
+
+    void flag_state::set_with_reason(const void * reason, std::size_t size, const void * type) noexcept
+    {
+        // Only one thread may write the reason, so it has to be claimed first.
+        auto previous{ m_flag.fetch_or(claimed_bit, std::memory_order_acquire) };
+        if ((previous & (claimed_bit | set_bit)) != 0U)
+        {
+            // Another thread is about to publish its own reason. It only has a few bytes to copy,
+            //  but the flag must be set by the time this returns.
+            while (!is_set())
+                std::this_thread::yield();
+            return;
+        }
+
+        std::memcpy(m_reason, reason, size);
+        m_reason_type = type;
+
+        // Publish the reason along with the flag, unless a plain set() got there first.
+        previous |= claimed_bit;
+        while (!m_flag.compare_exchange_weak(
+            previous,
+            previous | set_bit | has_reason_bit,
+            std::memory_order_acq_rel,
+            std::memory_order_relaxed
+        ))
+        {
+            if ((previous & set_bit) != 0U)
+                return;
+        }
+        finish_set(previous);
+    }
+
+    void flag_state::finish_set(std::uint32_t previous) noexcept
+    {
+#if defined(__linux__)
+        if ((previous & pollable_bit) != 0U)
+            signal_eventfd(m_eventfd.load(std::memory_order_acquire));
+#endif
+        if ((previous & listening_bit) != 0U)
+            notify_listeners();
+        if ((previous & waiting_bit) != 0U)
+            wake_waiters();
+    }
+
+    void flag_state::wait()
+    {
+        wait(m_spin_policy);
+    }
+
+    void flag_state::wait(const spin_policy & policy)
+    {
+        wait_until(std::chrono::steady_clock::time_point::max(), policy);
+    }
+
+    bool flag_state::wait_until(std::chrono::steady_clock::time_point deadline)
+    {
+        return wait_until(deadline, m_spin_policy);
+    }
+
+    bool flag_state::wait_until(std::chrono::steady_clock::time_point deadline, const spin_policy & policy)
+    {
+        if (is_set() || spin_until(deadline, policy))
+            return true;
+
+        // Don't block at all if the deadline has already passed. The kernel would still sleep for
+        //  its timer slack, and set() would have to issue a wake-up unnecessarily later.
+        const bool has_deadline{ deadline != std::chrono::steady_clock::time_point::max() };
+        if (has_deadline && std::chrono::steady_clock::now() >= deadline)
+            return is_set();
+
+#if defined(PRB_SHARED_FLAG_USE_FUTEX)
+        auto current{ m_flag.load(std::memory_order_acquire) };
+        while ((current & set_bit) == 0U)
+        {
+            // Make sure set() knows it has to wake somebody before going to sleep.
+            if ((current & waiting_bit) == 0U)
+            {
+                if (!m_flag.compare_exchange_weak(current, current | waiting_bit, std::memory_order_acq_rel))
+                    continue;
+                current |= waiting_bit;
+            }
+
+            if (!futex_wait(m_flag, current, deadline))
+                return is_set();
+            current = m_flag.load(std::memory_order_acquire);
+        }
+        return true;
+#else
+        const auto prepare_to_block{ [this]
+        {
+            return (m_flag.fetch_or(waiting_bit, std::memory_order_acq_rel) & set_bit) != 0U;
+        } };
+
+        std::unique_lock lock{ m_mtx };
+        if (!has_deadline)
+        {
+            m_cond_var.wait(lock, prepare_to_block);
+            return true;
+        }
+        return m_cond_var.wait_until(lock, deadline, prepare_to_block);
+#endif
+    }
+
+    bool flag_state::add_listener(flag_listener & listener) noexcept
+    {
+        if (is_set())
+        {
+            listener.m_complete.store(true, std::memory_order_relaxed);
+            return false;
+        }
+
+        lock_listeners();
+
+        // Once set() has seen listening_bit, it will take the lock and drain the list. Checking
+        //  set_bit under the lock ensures that the listener either goes into the list before that
+        //  happens, or isn't added at all.
+        auto current{ m_flag.load(std::memory_order_acquire) };
+        if ((current & listening_bit) == 0U)
+            current = m_flag.fetch_or(listening_bit, std::memory_order_acq_rel);
+        if ((current & set_bit) != 0U)
+        {
+            unlock_listeners();
+            listener.m_complete.store(true, std::memory_order_relaxed);
+            return false;
+        }
+
+        listener.m_complete.store(false, std::memory_order_relaxed);
+        listener.m_executor = std::thread::id{};
+        listener.m_linked = true;
+        listener.m_prev = nullptr;
+        listener.m_next = m_listeners;
+        if (m_listeners)
+            m_listeners->m_prev = &listener;
+        m_listeners = &listener;
+
+        unlock_listeners();
+        return true;
+    }
+
+    void flag_state::remove_listener(flag_listener & listener) noexcept
+    {
+        lock_listeners();
+        if (listener.m_linked)
+        {
+            if (listener.m_prev)
+                listener.m_prev->m_next = listener.m_next;
+            else
+                m_listeners = listener.m_next;
+            if (listener.m_next)
+                listener.m_next->m_prev = listener.m_prev;
+            listener.m_linked = false;
+            unlock_listeners();
+            return;
+        }
+        const bool is_executor{ listener.m_executor == std::this_thread::get_id() };
+        unlock_listeners();
+
+        // The listener has already been taken out of the list by set(). If its callback is
+        //  removing it, then there's nothing to wait for. The thread which set the flag just needs
+        //  to know not to touch it again.
+        if (is_executor)
+        {
+            if (listener.m_destroyed)
+                *listener.m_destroyed = true;
+            return;
+        }
+
+        // Otherwise, the callback may still be running on another thread, so wait for it to finish
+        //  before the listener is destroyed.
+        while (!listener.m_complete.load(std::memory_order_acquire))
+            std::this_thread::yield();
+    }
+
+
+    void flag_state::link_to_parents(const state_ptr * parents, std::size_t count)
+    {
+        prepare_parents(parents, count);
+        register_parents();
+    }
+
+    void flag_state::prepare_parents(const state_ptr * parents, std::size_t count)
+    {
+        auto links{ std::make_unique<parent_set>() };
+        for (std::size_t index{ 0U }; index < count; ++index)
+            links->links.emplace_back(parents[index], this);
+        m_parents = links.release();
+    }
+
+    void flag_state::register_parents() noexcept
+    {
+        m_parents->registered = true;
+
+        // There's no need to register with the remaining parents once one of them has been set.
+        //  Links which were never registered can still be removed safely.
+        for (auto & link : m_parents->links)
+        {
+            if (!link.parent->add_listener(link))
+            {
+                set();
+                return;
+            }
+        }
+    }
+
+    void flag_state::attach_parent(state_ptr parent)
+    {
+        bool registered{ false };
+        {
+            const std::lock_guard<std::mutex> lock{ m_parents->mtx };
+            auto & link{ m_parents->links.emplace_back(std::move(parent), this) };
+            registered = link.parent->add_listener(link);
+        }
+
+        // Setting this state calls other listeners, which might try to attach or detach parents.
+        if (!registered)
+            set();
+    }
+
+    bool flag_state::detach_parent(const flag_state & parent) noexcept
+    {
+        std::list<parent_link> detached;
+        {
+            const std::lock_guard<std::mutex> lock{ m_parents->mtx };
+            auto & links{ m_parents->links };
+            const auto found{ std::find_if(links.begin(), links.end(), [&](const parent_link & link)
+            {
+                return link.parent.get() == &parent;
+            }) };
+            if (found == links.end())
+                return false;
+            detached.splice(detached.end(), links, found);
+        }
+
+        // The callback might be running on another thread. Waiting for it outside the lock means
+        //  it can attach or detach parents itself without deadlocking.
+        auto & link{ detached.front() };
+        link.parent->remove_listener(link);
+        return true;
+    }
+
+    void flag_state::set_at(std::chrono::steady_clock::time_point deadline)
+    {
+        if (deadline == no_deadline)
+            return;
+        if (deadline <= std::chrono::steady_clock::now())
+        {
+            set(deadline_reached{});
+            return;
+        }
+
+        // Scheduling first means the timer is guaranteed to be cancelled if the flag is set before
+        //  the listener is registered.
+        m_deadline_timer = new deadline_timer{ this };
+        timer_service::instance().schedule(*m_deadline_timer, deadline);
+        if (!add_listener(*m_deadline_timer))
+            timer_service::instance().cancel(*m_deadline_timer);
+    }
+
+#if defined(__linux__)
+    int flag_state::native_handle()
+    {
+        auto eventfd{ m_eventfd.load(std::memory_order_acquire) };
+        if (eventfd != -1)
+            return eventfd;
+
+        // If two threads get here at once, only one of them keeps the eventfd it created.
+        const auto created{ ::eventfd(0U, EFD_CLOEXEC | EFD_NONBLOCK) };
+        if (created == -1)
+            throw std::system_error{ errno, std::system_category(), "Failed to create eventfd" };
+        if (!m_eventfd.compare_exchange_strong(eventfd, created, std::memory_order_acq_rel))
+        {
+            ::close(created);
+            return eventfd;
+        }
+
+        // From now on, set() will signal the eventfd. If it has already been called, then it
+        //  didn't see pollable_bit, so it needs signalling here instead. Exactly one of the two
+        //  will observe the other's bit.
+        const auto previous{ m_flag.fetch_or(pollable_bit, std::memory_order_acq_rel) };
+        if ((previous & set_bit) != 0U)
+            signal_eventfd(created);
+        return created;
+    }
+
+    void flag_state::set_from_signal() noexcept
+    {
+        const auto previous{ m_flag.fetch_or(set_bit, std::memory_order_acq_rel) };
+        if ((previous & set_bit) != 0U)
+            return;
+
+        const auto saved_errno{ errno };
+        if ((previous & pollable_bit) != 0U)
+            signal_eventfd(m_eventfd.load(std::memory_order_acquire));
+
+#if defined(PRB_SHARED_FLAG_USE_FUTEX)
+        // Waking a futex is a single system call, so blocked threads can be woken from here.
+        if ((previous & waiting_bit) != 0U)
+            futex_wake_all(m_flag);
+        constexpr std::uint32_t deferred_bits{ listening_bit };
+#else
+        constexpr std::uint32_t deferred_bits{ listening_bit | waiting_bit };
+#endif
+
+        // Everything else is left to the dispatch thread. Only the caller which set the flag gets
+        //  this far, so each state is pushed at most once. The reference it holds is released by
+        //  the dispatch thread.
+        //
+        // The stack and the eventfd are both sequentially consistent. Either this sees the eventfd,
+        //  or the dispatch thread's first check of the stack sees this state.
+        if ((previous & deferred_bits) != 0U)
+        {
+            add_reference();
+            m_next_deferred = deferred_states.load(std::memory_order_relaxed);
+            while (!deferred_states.compare_exchange_weak(m_next_deferred, this))
+            {
+            }
+
+            const auto eventfd{ dispatch_eventfd.load() };
+            if (eventfd != -1)
+                signal_eventfd(eventfd);
+        }
+        errno = saved_errno;
+    }
+
+    void flag_state::start_signal_dispatch()
+    {
+        static std::once_flag started;
+        std::call_once(started, []
+        {
+            // If starting the thread failed last time, the eventfd has already been published.
+            auto eventfd{ dispatch_eventfd.load() };
+            if (eventfd == -1)
+            {
+                eventfd = ::eventfd(0U, EFD_CLOEXEC);
+                if (eventfd == -1)
+                    throw std::system_error{ errno, std::system_category(), "Failed to create eventfd" };
+                dispatch_eventfd.store(eventfd);
+            }
+
+            // The thread is detached so that it's still there if a signal arrives while the
+            //  program is exiting.
+            std::thread{ [eventfd]
+            {
+                for (;;)
+                {
+                    dispatch_deferred();
+                    std::uint64_t count{ 0U };
+                    while (::read(eventfd, &count, sizeof(count)) < 0 && errno == EINTR)
+                    {
+                    }
+                }
+            } }.detach();
+        });
+    }
+#endif
+
+
+    //----------------------------------------------------------------------------------------------
+    // Internal operations.
+
+    void flag_state::notify_listeners() noexcept
+    {
+        // The lock isn't held while calling each listener, so callbacks can safely remove any
+        //  listener, including their own. New listeners can't be added now that the flag has been
+        //  set.
+        const auto this_thread{ std::this_thread::get_id() };
+        lock_listeners();
+        while (m_listeners)
+        {
+            auto * const listener{ m_listeners };
+            m_listeners = listener->m_next;
+            if (m_listeners)
+                m_listeners->m_prev = nullptr;
+            listener->m_linked = false;
+            listener->m_executor = this_thread;
+            unlock_listeners();
+
+            bool destroyed{ false };
+            listener->m_destroyed = &destroyed;
+            listener->m_callback(*listener);
+
+            // The listener may be destroyed as soon as it's marked complete, so don't touch it
+            //  again after that. If the callback removed its own listener then it may already have
+            //  been destroyed.
+            if (!destroyed)
+            {
+                listener->m_destroyed = nullptr;
+                listener->m_complete.store(true, std::memory_order_release);
+            }
+
+            lock_listeners();
+        }
+        unlock_listeners();
+    }
+
+    void flag_state::wake_waiters() noexcept
+    {
+#if defined(PRB_SHARED_FLAG_USE_FUTEX)
+        futex_wake_all(m_flag);
+#else
+        // Briefly locking the mutex ensures that any thread which saw the flag unset has finished
+        //  going to sleep before it's notified.
+        {
+            std::lock_guard lock{ m_mtx };
+        }
+        m_cond_var.notify_all();
+#endif
+    }
+
+#if defined(__linux__)
+    void flag_state::dispatch_deferred() noexcept
+    {
+        auto * next{ deferred_states.exchange(nullptr) };
+        while (next)
+        {
+            // Adopt the reference which was added by set_from_signal().
+            const state_ptr state{ next };
+            next = state->m_next_deferred;
+
+            // The bits are never cleared, so they still show what set_from_signal() had to defer.
+            //  A bit which was set afterwards just causes a harmless extra notification.
+            const auto current{ state->m_flag.load(std::memory_order_acquire) };
+            if ((current & listening_bit) != 0U)
+                state->notify_listeners();
+#if !defined(PRB_SHARED_FLAG_USE_FUTEX)
+            if ((current & waiting_bit) != 0U)
+                state->wake_waiters();
+#endif
+        }
+    }
+#endif
+
+    void flag_state::lock_listeners() noexcept
+    {
+        while (m_listeners_lock.test_and_set(std::memory_order_acquire))
+            std::this_thread::yield();
+    }
+
+    void flag_state::unlock_listeners() noexcept
+    {
+        m_listeners_lock.clear(std::memory_order_release);
+    }
+
+    bool flag_state::spin_until(
+        std::chrono::steady_clock::time_point deadline,
+        const spin_policy & policy
+    ) const noexcept
+    {
+        const bool has_deadline{ deadline != std::chrono::steady_clock::time_point::max() };
+
+        std::uint32_t backoff{ 1U };
+        for (std::uint32_t i{ 0U }; i < policy.spin_count; ++i)
+        {
+            for (std::uint32_t j{ 0U }; j < backoff; ++j)
+                cpu_relax();
+            if (is_set())
+                return true;
+            if (has_deadline && std::chrono::steady_clock::now() >= deadline)
+                return false;
+            if (backoff < max_spin_backoff)
+                backoff *= 2U;
+        }
+
+        for (std::uint32_t i{ 0U }; i < policy.yield_count; ++i)
+        {
+            std::this_thread::yield();
+            if (is_set())
+                return true;
+            if (has_deadline && std::chrono::steady_clock::now() >= deadline)
+                return false;
+        }
+
+        return false;
+    }
+}
@@ -0,0 +1,84 @@
+/**
+ * @file flag_thread.cpp
+ * @brief Defines a thread which owns a shared flag, and stops and joins itself when destroyed.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include "shared_flag/flag_thread.hpp"
+
+namespace prb
+{
+    //----------------------------------------------------------------------------------------------
+    // Construction / destruction.
+
+    flag_thread & flag_thread::operator=(flag_thread && other) noexcept
+    {
+        if (this == &other)
+            return *this;
+
+        if (joinable())
+        {
+            request_stop();
+            m_thread.join();
+        }
+        m_state = std::move(other.m_state);
+        m_thread = std::move(other.m_thread);
+        return *this;
+    }
+
+    flag_thread::~flag_thread()
+    {
+        if (joinable())
+        {
+            request_stop();
+            m_thread.join();
+        }
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // Accessors / operations.
+
+    bool flag_thread::joinable() const noexcept
+    {
+        return m_thread.joinable();
+    }
+
+    void flag_thread::join()
+    {
+        m_thread.join();
+    }
+
+    void flag_thread::detach()
+    {
+        m_thread.detach();
+    }
+
+    std::thread::id flag_thread::get_id() const noexcept
+    {
+        return m_thread.get_id();
+    }
+
+    flag_thread::native_handle_type flag_thread::native_handle()
+    {
+        return m_thread.native_handle();
+    }
+
+    shared_flag_reader flag_thread::get_stop_flag() const noexcept
+    {
+        return detail::state_access::make_reader(m_state);
+    }
+
+    void flag_thread::request_stop() noexcept
+    {
+        if (m_state)
+            m_state->set();
+    }
+
+    void flag_thread::swap(flag_thread & other) noexcept
+    {
+        m_state.swap(other.m_state);
+        m_thread.swap(other.m_thread);
+    }
+}
@@ -0,0 +1,121 @@
+/**
+ * @file futex.hpp
+ * @brief Declares helpers which block and wake threads on a Linux futex word.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#ifndef PRB_DETAIL_FUTEX_HPP_INCLUDED
+#define PRB_DETAIL_FUTEX_HPP_INCLUDED
+
+#if !defined(__linux__)
+#   error "Futexes are only available on Linux."
+#endif
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace prb::detail
+{
+    static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t));
+    static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+
+    /**
+     * Specifies which threads can wake each other via a futex word.
+     * Private futexes are faster, but only work between threads of the same process. Shared
+     *  futexes also work between processes which have mapped the same memory, even at different
+     *  addresses.
+     */
+    enum class futex_scope
+    {
+        process_private,
+        process_shared
+    };
+
+    /**
+     * Block on a futex word until it is woken, or until the given steady clock deadline.
+     * This returns immediately if the word does not contain the expected value.
+     * Spurious wake-ups are possible, so the caller must re-check its condition.
+     *
+     * @param word The futex word to block on.
+     * @param expected The value which the word must contain for the thread to block.
+     * @param deadline The time point to block until. A value of
+     *  std::chrono::steady_clock::time_point::max() means there is no time limit.
+     * @param scope Must match the scope used to wake the word.
+     * @return Returns false if the deadline was reached. Returns true otherwise.
+     */
+    inline bool futex_wait(
+        std::atomic<std::uint32_t> & word,
+        std::uint32_t expected,
+        std::chrono::steady_clock::time_point deadline,
+        futex_scope scope = futex_scope::process_private
+    ) noexcept
+    {
+        const bool is_private{ scope == futex_scope::process_private };
+        auto * const address{ reinterpret_cast<std::uint32_t *>(&word) };
+        if (deadline == std::chrono::steady_clock::time_point::max())
+        {
+            const int operation{ is_private ? FUTEX_WAIT_PRIVATE : FUTEX_WAIT };
+            syscall(SYS_futex, address, operation, expected, nullptr, nullptr, 0);
+            return true;
+        }
+
+        // FUTEX_WAIT_BITSET takes an absolute CLOCK_MONOTONIC time, which is what the steady
+        //  clock measures on Linux. It's the same in every process, so deadlines can be shared.
+        const auto since_epoch{ deadline.time_since_epoch() };
+        const auto seconds{ std::chrono::duration_cast<std::chrono::seconds>(since_epoch) };
+        const auto nanoseconds{
+            std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch - seconds)
+        };
+        timespec absolute{};
+        absolute.tv_sec = static_cast<time_t>(seconds.count());
+        absolute.tv_nsec = static_cast<long>(nanoseconds.count());
+
+        const int operation{ is_private ? FUTEX_WAIT_BITSET_PRIVATE : FUTEX_WAIT_BITSET };
+        const auto result{ syscall(
+            SYS_futex, address, operation, expected, &absolute, nullptr, FUTEX_BITSET_MATCH_ANY
+        ) };
+        return result == 0 || errno != ETIMEDOUT;
+    }
+
+    /**
+     * Wake all threads blocked on a futex word.
+     *
+     * @param word The futex word to wake.
+     * @param scope Must match the scope used to block on the word.
+     */
+    inline void futex_wake_all(
+        std::atomic<std::uint32_t> & word,
+        futex_scope scope = futex_scope::process_private
+    ) noexcept
+    {
+        const int operation{ scope == futex_scope::process_private ? FUTEX_WAKE_PRIVATE : FUTEX_WAKE };
+        auto * const address{ reinterpret_cast<std::uint32_t *>(&word) };
+        syscall(SYS_futex, address, operation, INT_MAX, nullptr, nullptr, 0);
+    }
+
+    /**
+     * Wake at most one thread blocked on a futex word.
+     *
+     * @param word The futex word to wake.
+     * @param scope Must match the scope used to block on the word.
+     */
+    inline void futex_wake_one(
+        std::atomic<std::uint32_t> & word,
+        futex_scope scope = futex_scope::process_private
+    ) noexcept
+    {
+        const int operation{ scope == futex_scope::process_private ? FUTEX_WAKE_PRIVATE : FUTEX_WAKE };
+        auto * const address{ reinterpret_cast<std::uint32_t *>(&word) };
+        syscall(SYS_futex, address, operation, 1, nullptr, nullptr, 0);
+    }
+}
+
+#endif
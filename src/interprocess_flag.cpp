@@ -0,0 +1,59 @@
+/**
+ * @file interprocess_flag.cpp
+ * @brief Defines a one-shot flag which can be placed in memory shared between processes.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#if defined(__linux__)
+
+#include "shared_flag/interprocess_flag.hpp"
+#include "futex.hpp"
+#include <type_traits>
+
+namespace prb
+{
+    // The flag must be placeable in raw shared memory, and mean the same thing in every process.
+    static_assert(std::is_standard_layout_v<interprocess_flag>);
+    static_assert(sizeof(interprocess_flag) == sizeof(std::uint32_t));
+
+    //----------------------------------------------------------------------------------------------
+    // Accessors / operations.
+
+    void interprocess_flag::set() noexcept
+    {
+        const auto previous{ m_flag.fetch_or(set_bit, std::memory_order_acq_rel) };
+        if ((previous & (set_bit | waiting_bit)) == waiting_bit)
+            detail::futex_wake_all(m_flag, detail::futex_scope::process_shared);
+    }
+
+    void interprocess_flag::wait() noexcept
+    {
+        wait_until(detail::no_deadline);
+    }
+
+    bool interprocess_flag::wait_until(std::chrono::steady_clock::time_point deadline) noexcept
+    {
+        auto current{ m_flag.load(std::memory_order_acquire) };
+        while ((current & set_bit) == 0U)
+        {
+            if (deadline != detail::no_deadline && std::chrono::steady_clock::now() >= deadline)
+                return false;
+
+            // Make sure set() knows it has to wake somebody before going to sleep.
+            if ((current & waiting_bit) == 0U)
+            {
+                if (!m_flag.compare_exchange_weak(current, current | waiting_bit, std::memory_order_acq_rel))
+                    continue;
+                current |= waiting_bit;
+            }
+
+            if (!detail::futex_wait(m_flag, current, deadline, detail::futex_scope::process_shared))
+                return get();
+            current = m_flag.load(std::memory_order_acquire);
+        }
+        return true;
+    }
+}
+
+#endif
@@ -0,0 +1,37 @@
+/**
+ * @file manual_reset_event.cpp
+ * @brief Defines handles to a shared event which can be set and reset repeatedly.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include "shared_flag/manual_reset_event.hpp"
+#include <utility>
+
+namespace prb
+{
+    //----------------------------------------------------------------------------------------------
+    // Construction / destruction.
+
+    manual_reset_event_reader::manual_reset_event_reader(detail::event_state_ptr state) noexcept :
+        m_state{ std::move(state) }
+    {
+    }
+
+    manual_reset_event::manual_reset_event(bool initially_set) :
+        manual_reset_event_reader{
+            detail::event_state_ptr{ new detail::event_state(detail::event_reset::manual, initially_set) }
+        }
+    {
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // Accessors / operations.
+
+    void manual_reset_event_reader::wait() const
+    {
+        auto & state{ checked_state() };
+        state.wait_until(detail::no_deadline, state.generation());
+    }
+}
@@ -0,0 +1,146 @@
+/**
+ * @file multi_wait.cpp
+ * @brief Defines the internal operations which block a thread on several flags at once.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include "shared_flag/detail/multi_wait.hpp"
+#include <atomic>
+#include <limits>
+
+namespace prb::detail
+{
+    /**
+     * The shared data for a single multi-flag wait operation.
+     * This lives on the waiting thread's stack. The thread blocks on its own private flag, which
+     *  is set by the listeners when enough of the real flags have been set.
+     */
+    struct multi_wait_context
+    {
+        /// Indicates that no flag has been set yet.
+        static constexpr std::size_t none{ std::numeric_limits<std::size_t>::max() };
+
+        explicit multi_wait_context(std::size_t num_required) noexcept :
+            remaining{ num_required }
+        {
+        }
+
+        /// The flag which the waiting thread blocks on.
+        flag_state waker;
+
+        /// The number of flags which still need to be set before the waiting thread is woken.
+        std::atomic<std::size_t> remaining;
+
+        /// The index of the first flag which was seen to be set.
+        std::atomic<std::size_t> first{ none };
+    };
+
+    namespace
+    {
+        /// Record that the flag referred to by an entry has been set.
+        void on_flag_set(multi_wait_entry & entry) noexcept
+        {
+            auto & context{ *entry.context };
+
+            auto expected{ multi_wait_context::none };
+            context.first.compare_exchange_strong(expected, entry.index, std::memory_order_acq_rel);
+
+            if (context.remaining.fetch_sub(1U, std::memory_order_acq_rel) == 1U)
+                context.waker.set();
+        }
+
+        /// The callback registered with each flag.
+        void notify(flag_listener & listener) noexcept
+        {
+            on_flag_set(static_cast<multi_wait_entry &>(listener));
+        }
+
+        /**
+         * Register a listener with each flag, block until enough of them have been set, then
+         *  deregister the listeners.
+         * If a flag has already been set then its listener is not registered, and it's counted
+         *  immediately. In "any" mode, that ends the operation without blocking.
+         */
+        void wait_on_context(
+            multi_wait_context & context,
+            multi_wait_entry * entries,
+            std::size_t count,
+            std::chrono::steady_clock::time_point deadline
+        )
+        {
+            for (std::size_t i{ 0U }; i < count; ++i)
+            {
+                auto & entry{ entries[i] };
+                entry.context = &context;
+                entry.index = i;
+                entry.registered = entry.state->add_listener(entry);
+                if (!entry.registered)
+                    on_flag_set(entry);
+                if (context.waker.is_set())
+                    break;
+            }
+
+            context.waker.wait_until(deadline);
+
+            // Once every listener has been removed, none of them can still be running, so it's
+            //  safe for the context to go out of scope.
+            for (std::size_t i{ 0U }; i < count; ++i)
+            {
+                auto & entry{ entries[i] };
+                if (entry.registered)
+                    entry.state->remove_listener(entry);
+                entry.registered = false;
+            }
+        }
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // Construction / destruction.
+
+    multi_wait_entry::multi_wait_entry() noexcept :
+        flag_listener{ &notify }
+    {
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // Accessors / operations.
+
+    std::optional<std::size_t> wait_any_state(
+        multi_wait_entry * entries,
+        std::size_t count,
+        std::chrono::steady_clock::time_point deadline
+    )
+    {
+        // Prefer the lowest index if any flags have already been set.
+        for (std::size_t i{ 0U }; i < count; ++i)
+        {
+            if (entries[i].state->is_set())
+                return i;
+        }
+
+        multi_wait_context context{ 1U };
+        wait_on_context(context, entries, count, deadline);
+
+        const auto first{ context.first.load(std::memory_order_acquire) };
+        if (first == multi_wait_context::none)
+            return std::nullopt;
+        return first;
+    }
+
+    bool wait_all_states(
+        multi_wait_entry * entries,
+        std::size_t count,
+        std::chrono::steady_clock::time_point deadline
+    )
+    {
+        if (count == 0U)
+            return true;
+
+        multi_wait_context context{ count };
+        wait_on_context(context, entries, count, deadline);
+        return context.remaining.load(std::memory_order_acquire) == 0U;
+    }
+}
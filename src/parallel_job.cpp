@@ -0,0 +1,93 @@
+/**
+ * @file parallel_job.cpp
+ * @brief Defines the bookkeeping shared by the threads taking part in a parallel algorithm.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include "shared_flag/detail/parallel_job.hpp"
+#include <algorithm>
+
+namespace
+{
+    // Split the range so that each participant can claim several chunks, to balance the load.
+    constexpr std::size_t chunks_per_participant{ 4U };
+
+    // Get the largest chunk which still leaves enough chunks to go round.
+    std::size_t max_chunk_size(std::size_t count, std::size_t participants) noexcept
+    {
+        const auto chunks{ std::max<std::size_t>(participants, 1U) * chunks_per_participant };
+        return std::max<std::size_t>(count / chunks, 1U);
+    }
+}
+
+namespace prb::detail
+{
+    //----------------------------------------------------------------------------------------------
+    // Construction / destruction.
+
+    parallel_job::parallel_job(
+        state_ptr cancel,
+        std::size_t count,
+        std::size_t participants,
+        std::chrono::steady_clock::duration chunk_duration
+    ) noexcept :
+        m_cancel{ std::move(cancel) },
+        m_count{ count },
+        m_max_chunk{ max_chunk_size(count, participants) },
+        m_chunk_duration{ chunk_duration }
+    {
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // Accessors / operations.
+
+    void parallel_job::enter() noexcept
+    {
+        m_active.fetch_add(1U, std::memory_order_relaxed);
+    }
+
+    bool parallel_job::next_chunk(chunk_cursor & cursor) noexcept
+    {
+        // Record the chunk which has just finished, and use its duration to size the next one.
+        if (cursor.end > cursor.begin)
+        {
+            m_processed.fetch_add(cursor.end - cursor.begin, std::memory_order_relaxed);
+            const auto elapsed{ std::chrono::steady_clock::now() - cursor.started };
+            if (elapsed < m_chunk_duration / 2)
+                cursor.size = std::min(cursor.size * 2U, m_max_chunk);
+            else if (elapsed > m_chunk_duration * 2)
+                cursor.size = std::max<std::size_t>(cursor.size / 2U, 1U);
+            cursor.begin = cursor.end;
+        }
+
+        if (m_cancel->is_set())
+            return false;
+
+        // Stop claiming once the range is exhausted, so the counter can't overshoot by much.
+        if (m_next.load(std::memory_order_relaxed) >= m_count)
+            return false;
+        const auto begin{ m_next.fetch_add(cursor.size, std::memory_order_relaxed) };
+        if (begin >= m_count)
+            return false;
+
+        cursor.begin = begin;
+        cursor.end = begin + std::min(cursor.size, m_count - begin);
+        cursor.started = std::chrono::steady_clock::now();
+        return true;
+    }
+
+    void parallel_job::leave() noexcept
+    {
+        // The acq_rel ordering passes each participant's results on to whichever one leaves last.
+        if (m_active.fetch_sub(1U, std::memory_order_acq_rel) == 1U)
+            m_finished.set();
+    }
+
+    bool parallel_job::wait()
+    {
+        m_finished.wait();
+        return m_processed.load(std::memory_order_relaxed) == m_count;
+    }
+}
@@ -0,0 +1,113 @@
+/**
+ * @file periodic.cpp
+ * @brief Defines a range which repeats at a fixed period until a shared flag is set.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include "shared_flag/periodic.hpp"
+#include "shared_flag/detail/flag_state.hpp"
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+    // Reduce a duration to the range [0, divisor).
+    std::chrono::steady_clock::duration floor_mod(
+        std::chrono::steady_clock::duration value,
+        std::chrono::steady_clock::duration divisor
+    ) noexcept
+    {
+        const auto remainder{ value % divisor };
+        return remainder < remainder.zero() ? remainder + divisor : remainder;
+    }
+}
+
+namespace prb
+{
+    //----------------------------------------------------------------------------------------------
+    // Construction / destruction.
+
+    periodic_range::periodic_range(
+        detail::state_ptr state,
+        std::chrono::steady_clock::duration period,
+        const periodic_options & options
+    ) :
+        m_state{ std::move(state) },
+        m_period{ period },
+        m_options{ options }
+    {
+        if (!m_state)
+            throw std::logic_error{ "Shared state has been moved away." };
+        if (m_period <= m_period.zero())
+            throw std::invalid_argument{ "Period must be positive." };
+        if (m_options.slack < m_options.slack.zero())
+            throw std::invalid_argument{ "Timer slack must not be negative." };
+
+        m_options.phase = floor_mod(m_options.phase, m_period);
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // Accessors / operations.
+
+    periodic_range::iterator periodic_range::begin()
+    {
+        if (!m_started)
+        {
+            m_started = true;
+            m_tick.scheduled = next_tick_after(std::chrono::steady_clock::now());
+            wait_for_tick();
+        }
+        return iterator{ this };
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // Internal operations.
+
+    void periodic_range::advance()
+    {
+        const auto due{ m_tick.scheduled + m_period };
+        m_tick.scheduled = due;
+        m_tick.missed = 0U;
+
+        // A tick is only missed if it's later than the slack allows. Otherwise the body taking
+        //  slightly too long would throw away a whole period.
+        if (m_options.missed_ticks == missed_tick_policy::skip)
+        {
+            const auto now{ std::chrono::steady_clock::now() };
+            if (due + m_options.slack < now)
+            {
+                m_tick.scheduled = next_tick_after(now);
+                m_tick.missed = static_cast<std::uint64_t>((m_tick.scheduled - due) / m_period);
+            }
+        }
+
+        wait_for_tick();
+    }
+
+    std::chrono::steady_clock::time_point periodic_range::next_tick_after(
+        std::chrono::steady_clock::time_point time
+    ) const noexcept
+    {
+        // Ticks are at whole multiples of the period from the epoch, so that independent tickers
+        //  with the same period agree on them.
+        const auto offset{ floor_mod(time.time_since_epoch() - m_options.phase, m_period) };
+        return time - offset + m_period;
+    }
+
+    void periodic_range::wait_for_tick()
+    {
+        auto wake{ m_tick.scheduled };
+        if (m_options.slack > m_options.slack.zero())
+        {
+            const auto remainder{ floor_mod(wake.time_since_epoch(), m_options.slack) };
+            if (remainder != remainder.zero())
+                wake += m_options.slack - remainder;
+        }
+
+        if (m_state->wait_until(wake))
+            m_finished = true;
+    }
+}
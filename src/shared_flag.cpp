@@ -13,9 +13,14 @@ namespace prb
     //----------------------------------------------------------------------------------------------
     // Construction / destruction.
 
-    shared_flag::shared_flag()
+    shared_flag::shared_flag() :
+        shared_flag_reader(detail::make_state())
+    {
+    }
+
+    shared_flag::shared_flag(const spin_policy & policy) :
+        shared_flag_reader(detail::make_state(policy))
     {
-        m_state = std::make_shared<state>();
     }
 
     shared_flag::shared_flag(const shared_flag & other) : shared_flag_reader(other)
@@ -28,11 +33,11 @@ namespace prb
         return *this;
     }
 
-    shared_flag::shared_flag(shared_flag && other) : shared_flag_reader(std::move(other))
+    shared_flag::shared_flag(shared_flag && other) noexcept : shared_flag_reader(std::move(other))
     {
     }
 
-    shared_flag & shared_flag::operator=(shared_flag && other)
+    shared_flag & shared_flag::operator=(shared_flag && other) noexcept
     {
         shared_flag_reader::operator=(std::move(other));
         return *this;
@@ -48,16 +53,6 @@ namespace prb
 
     void shared_flag::set()
     {
-        std::shared_lock outerLock{ m_state_ptr_mtx };
-        if (!m_state)
-            throw std::logic_error{ "Shared state has been moved away." };
-
-        std::unique_lock innerLock{ m_state->m_state_data_mtx };
-        if (!m_state->m_flag)
-        {
-            m_state->m_flag = true;
-            innerLock.unlock();
-            m_state->m_cond_var.notify_all();
-        }
+        checked_state()->set();
     }
 }
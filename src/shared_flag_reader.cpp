@@ -6,6 +6,7 @@
  */
 
 #include "shared_flag/shared_flag_reader.hpp"
+#include <stdexcept>
 #include <utility>
 
 namespace prb
@@ -13,42 +14,33 @@ namespace prb
     //----------------------------------------------------------------------------------------------
     // Construction / destruction.
 
-    shared_flag_reader::shared_flag_reader(const shared_flag_reader & other)
+    shared_flag_reader::shared_flag_reader(detail::state_ptr state) noexcept :
+        m_state{ std::move(state) }
     {
-        *this = other;
     }
 
-    shared_flag_reader & shared_flag_reader::operator=(const shared_flag_reader & other)
+    shared_flag_reader::shared_flag_reader(const shared_flag_reader & other) :
+        m_state{ other.checked_state() }
     {
-        std::unique_lock thisLock{ m_state_ptr_mtx, std::defer_lock };
-        std::shared_lock otherLock{ other.m_state_ptr_mtx, std::defer_lock };
-        std::lock(thisLock, otherLock);
-
-        if (!other.m_state)
-            throw std::logic_error{ "Shared state has been moved away." };
+    }
 
-        m_state = other.m_state;
+    shared_flag_reader & shared_flag_reader::operator=(const shared_flag_reader & other)
+    {
+        m_state.store(other.checked_state());
         return *this;
     }
 
-    shared_flag_reader::shared_flag_reader(shared_flag_reader && other)
+    shared_flag_reader::shared_flag_reader(shared_flag_reader && other) noexcept :
+        m_state{ other.m_state.exchange(nullptr) }
     {
-        *this = std::move(other);
     }
 
-    shared_flag_reader & shared_flag_reader::operator=(shared_flag_reader && other)
+    shared_flag_reader & shared_flag_reader::operator=(shared_flag_reader && other) noexcept
     {
         if (this == &other)
             return *this;
 
-        std::unique_lock thisLock{ m_state_ptr_mtx, std::defer_lock };
-        std::unique_lock otherLock{ other.m_state_ptr_mtx, std::defer_lock };
-        std::lock(thisLock, otherLock);
-
-        if (!other.m_state)
-            throw std::logic_error{ "Shared state has been moved away." };
-
-        m_state = std::move(other.m_state);
+        m_state.store(other.m_state.exchange(nullptr));
         return *this;
     }
     
@@ -62,18 +54,22 @@ namespace prb
 
     bool shared_flag_reader::valid() const noexcept
     {
-        std::shared_lock lock{ m_state_ptr_mtx };
-        return m_state != nullptr;
+        return m_state.visit([](const state * s) { return s != nullptr; });
     }
 
     bool shared_flag_reader::get() const
     {
-        std::shared_lock outerLock{ m_state_ptr_mtx };
-        if (!m_state)
+        // Read the flag while holding the pointer's lock, to avoid touching the reference count.
+        bool has_state{ false };
+        const bool is_set{ m_state.visit([&has_state](const state * s)
+        {
+            has_state = (s != nullptr);
+            return has_state && s->is_set();
+        }) };
+
+        if (!has_state)
             throw std::logic_error{ "Shared state has been moved away." };
-
-        std::lock_guard innerLock{ m_state->m_state_data_mtx };
-        return m_state->m_flag;
+        return is_set;
     }
 
     shared_flag_reader::operator bool() const
@@ -81,13 +77,32 @@ namespace prb
         return get();
     }
 
+#if defined(__linux__)
+    shared_flag_reader::native_handle_type shared_flag_reader::native_handle() const
+    {
+        return checked_state()->native_handle();
+    }
+#endif
+
     void shared_flag_reader::wait() const
     {
-        std::shared_lock outerLock{ m_state_ptr_mtx };
-        if (!m_state)
-            throw std::logic_error{ "Shared state has been moved away." };
+        checked_state()->wait();
+    }
+
+    void shared_flag_reader::wait(const spin_policy & policy) const
+    {
+        checked_state()->wait(policy);
+    }
 
-        std::unique_lock innerLock{ m_state->m_state_data_mtx };
-        m_state->m_cond_var.wait(innerLock, [this]{ return m_state->m_flag; });
+
+    //----------------------------------------------------------------------------------------------
+    // Internal operations.
+
+    detail::state_ptr shared_flag_reader::checked_state() const
+    {
+        auto result{ m_state.load() };
+        if (!result)
+            throw std::logic_error{ "Shared state has been moved away." };
+        return result;
     }
 }
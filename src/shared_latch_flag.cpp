@@ -0,0 +1,87 @@
+/**
+ * @file shared_latch_flag.cpp
+ * @brief Defines a shared flag which is set when a number of parties have counted down.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include "shared_flag/shared_latch_flag.hpp"
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+    // Check that a latch count is valid.
+    std::ptrdiff_t checked_count(std::ptrdiff_t count)
+    {
+        if (count < 0)
+            throw std::invalid_argument{ "Latch count must not be negative." };
+        return count;
+    }
+}
+
+namespace prb
+{
+    //----------------------------------------------------------------------------------------------
+    // Construction / destruction.
+
+    shared_latch_flag::shared_latch_flag(std::ptrdiff_t count) :
+        shared_flag_reader(detail::make_state())
+    {
+        // The state hasn't been shared yet, so there's no need to lock the pointer.
+        m_state.get_unlocked()->start_latch(checked_count(count));
+    }
+
+    shared_latch_flag::shared_latch_flag(std::ptrdiff_t count, const spin_policy & policy) :
+        shared_flag_reader(detail::make_state(policy))
+    {
+        // The state hasn't been shared yet, so there's no need to lock the pointer.
+        m_state.get_unlocked()->start_latch(checked_count(count));
+    }
+
+    shared_latch_flag::shared_latch_flag(const shared_latch_flag & other) :
+        shared_flag_reader(other)
+    {
+    }
+
+    shared_latch_flag & shared_latch_flag::operator=(const shared_latch_flag & other)
+    {
+        shared_flag_reader::operator=(other);
+        return *this;
+    }
+
+    shared_latch_flag::shared_latch_flag(shared_latch_flag && other) noexcept :
+        shared_flag_reader(std::move(other))
+    {
+    }
+
+    shared_latch_flag & shared_latch_flag::operator=(shared_latch_flag && other) noexcept
+    {
+        shared_flag_reader::operator=(std::move(other));
+        return *this;
+    }
+
+    shared_latch_flag::~shared_latch_flag() = default;
+
+
+    //----------------------------------------------------------------------------------------------
+    // Accessors / operations.
+
+    void shared_latch_flag::count_down(std::ptrdiff_t update)
+    {
+        if (update < 0)
+            throw std::invalid_argument{ "Latch count cannot be increased." };
+
+        // Counting down mustn't race with reassigning this instance, so the pointer can't change
+        //  under us. That saves locking it and taking a reference just to decrement the count.
+        auto * const state{ m_state.get_unlocked() };
+        if (!state)
+            throw std::logic_error{ "Shared state has been moved away." };
+        state->count_down(update);
+    }
+
+    std::ptrdiff_t shared_latch_flag::remaining() const
+    {
+        return checked_state()->latch_count();
+    }
+}
@@ -0,0 +1,76 @@
+/**
+ * @file signal_flag.cpp
+ * @brief Defines functions for setting flags when the process receives a signal.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#if defined(__linux__)
+
+#include "shared_flag/signal_flag.hpp"
+#include "shared_flag/detail/state_access.hpp"
+#include "shared_flag/shared_flag.hpp"
+#include <atomic>
+#include <cerrno>
+#include <signal.h>
+#include <system_error>
+
+namespace prb
+{
+    namespace
+    {
+        /**
+         * The shared state of the shutdown flag, or null if it hasn't been created yet.
+         * This holds a reference which is never released, so the signal handler can still use it
+         *  while static objects are being destroyed.
+         */
+        std::atomic<detail::flag_state *> shutdown_state{ nullptr };
+
+        /// The handler installed by shutdown_on_signals().
+        void on_shutdown_signal(int) noexcept
+        {
+            if (auto * const state{ shutdown_state.load(std::memory_order_acquire) })
+                state->set_from_signal();
+        }
+
+        /// Get the process-wide shutdown flag, creating it if necessary.
+        const shared_flag & shutdown_flag()
+        {
+            static const shared_flag flag{ []
+            {
+                shared_flag result;
+                shutdown_state.store(detail::state_access::get(result).release(), std::memory_order_release);
+                return result;
+            }() };
+            return flag;
+        }
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // Accessors / operations.
+
+    void start_signal_dispatch()
+    {
+        detail::flag_state::start_signal_dispatch();
+    }
+
+    shared_flag_reader shutdown_on_signals(std::initializer_list<int> signals)
+    {
+        start_signal_dispatch();
+        const auto & flag{ shutdown_flag() };
+
+        struct sigaction action{};
+        action.sa_handler = &on_shutdown_signal;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_RESTART;
+        for (const auto signal_number : signals)
+        {
+            if (::sigaction(signal_number, &action, nullptr) != 0)
+                throw std::system_error{ errno, std::system_category(), "Failed to install signal handler" };
+        }
+        return flag;
+    }
+}
+
+#endif
@@ -0,0 +1,31 @@
+/**
+ * @file state_access.cpp
+ * @brief Defines an internal helper which can access the shared state held by flag handles.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include "shared_flag/detail/state_access.hpp"
+#include "shared_flag/compact_shared_flag_reader.hpp"
+#include "shared_flag/shared_flag_reader.hpp"
+#include <utility>
+
+namespace prb::detail
+{
+    state_ptr state_access::get(const shared_flag_reader & handle)
+    {
+        return handle.checked_state();
+    }
+
+    state_ptr state_access::get(const compact_shared_flag_reader & handle)
+    {
+        if (!handle.m_state)
+            throw std::logic_error{ "Shared state has been moved away." };
+        return handle.m_state;
+    }
+
+    shared_flag_reader state_access::make_reader(state_ptr state) noexcept
+    {
+        return shared_flag_reader{ std::move(state) };
+    }
+}
@@ -0,0 +1,220 @@
+/**
+ * @file thread_pool.cpp
+ * @brief Defines a work-stealing thread pool whose tasks can be cancelled by shared flags.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include "shared_flag/thread_pool.hpp"
+#include <deque>
+#include <stdexcept>
+
+namespace
+{
+    // The pool which owns the current thread, if it's a worker, and the index of its queue.
+    thread_local const prb::thread_pool * current_pool{ nullptr };
+    thread_local std::size_t current_queue{ 0U };
+
+    // Check that a pool will have at least one worker.
+    std::size_t checked_thread_count(std::size_t thread_count)
+    {
+        if (thread_count == 0U)
+            throw std::invalid_argument{ "Thread pool must have at least one thread." };
+        return thread_count;
+    }
+}
+
+namespace prb
+{
+    /// The tasks waiting to be run by one worker, or stolen by the others.
+    struct thread_pool::worker_queue
+    {
+        /// Protects the tasks.
+        std::mutex mtx;
+
+        /// The owner takes tasks from the back, and other workers steal them from the front.
+        std::deque<std::unique_ptr<detail::pool_task>> tasks;
+    };
+
+
+    //----------------------------------------------------------------------------------------------
+    // Construction / destruction.
+
+    thread_pool::thread_pool(std::size_t thread_count) :
+        thread_pool{ thread_count, shared_flag{} }
+    {
+    }
+
+    thread_pool::thread_pool(std::size_t thread_count, shared_flag stop_flag) :
+        m_stop{ std::move(stop_flag) },
+        m_stop_state{ detail::state_access::get(m_stop) },
+        m_thread_count{ checked_thread_count(thread_count) },
+        m_queues{ std::make_unique<worker_queue[]>(m_thread_count) },
+        m_wake_on_stop{ m_stop, wake_workers{ this } }
+    {
+        m_threads.reserve(m_thread_count);
+        try
+        {
+            for (std::size_t index{ 0U }; index < m_thread_count; ++index)
+                m_threads.emplace_back([this, index] { run(index); });
+        }
+        catch (...)
+        {
+            stop();
+            for (auto & thread : m_threads)
+                thread.join();
+            throw;
+        }
+    }
+
+    thread_pool::~thread_pool()
+    {
+        stop();
+        for (auto & thread : m_threads)
+            thread.join();
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // Accessors / operations.
+
+    std::size_t thread_pool::default_thread_count() noexcept
+    {
+        const auto count{ std::thread::hardware_concurrency() };
+        return count > 0U ? count : 1U;
+    }
+
+    std::size_t thread_pool::thread_count() const noexcept
+    {
+        return m_thread_count;
+    }
+
+    shared_flag_reader thread_pool::get_stop_flag() const
+    {
+        return m_stop;
+    }
+
+    void thread_pool::stop() noexcept
+    {
+        m_stop_state->set();
+    }
+
+    std::size_t thread_pool::discarded_count() const noexcept
+    {
+        return m_discarded.load(std::memory_order_relaxed);
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // Internal operations.
+
+    void thread_pool::wake_workers::operator()() const noexcept
+    {
+        // Taking the lock ensures that no worker is between checking the flag and going to sleep.
+        {
+            const std::lock_guard<std::mutex> lock{ pool->m_idle_mtx };
+        }
+        pool->m_idle_cond_var.notify_all();
+    }
+
+    bool thread_pool::push(std::unique_ptr<detail::pool_task> task)
+    {
+        if (m_stop_state->is_set())
+            return false;
+        if (task->is_cancelled())
+        {
+            m_discarded.fetch_add(1U, std::memory_order_relaxed);
+            return false;
+        }
+
+        // A worker keeps its own tasks, so that related work stays on the same core.
+        const auto index{
+            current_pool == this
+                ? current_queue
+                : m_next_queue.fetch_add(1U, std::memory_order_relaxed) % m_thread_count
+        };
+        {
+            auto & queue{ m_queues[index] };
+            const std::lock_guard<std::mutex> lock{ queue.mtx };
+            queue.tasks.push_back(std::move(task));
+        }
+
+        // This pairs with run(). Either a worker which is going to sleep sees the new epoch, or
+        //  this sees that it's going to sleep and wakes it.
+        m_epoch.fetch_add(1U, std::memory_order_seq_cst);
+        if (m_sleepers.load(std::memory_order_seq_cst) > 0U)
+        {
+            {
+                const std::lock_guard<std::mutex> lock{ m_idle_mtx };
+            }
+            m_idle_cond_var.notify_one();
+        }
+        return true;
+    }
+
+    void thread_pool::run(std::size_t index) noexcept
+    {
+        current_pool = this;
+        current_queue = index;
+
+        while (!m_stop_state->is_set())
+        {
+            const auto epoch{ m_epoch.load(std::memory_order_seq_cst) };
+            if (const auto task{ find_task(index) })
+            {
+                task->run(m_stop);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock{ m_idle_mtx };
+            m_sleepers.fetch_add(1U, std::memory_order_seq_cst);
+            m_idle_cond_var.wait(lock, [this, epoch]
+            {
+                return m_epoch.load(std::memory_order_seq_cst) != epoch || m_stop_state->is_set();
+            });
+            m_sleepers.fetch_sub(1U, std::memory_order_relaxed);
+        }
+
+        current_pool = nullptr;
+    }
+
+    std::unique_ptr<detail::pool_task> thread_pool::find_task(std::size_t index) noexcept
+    {
+        for (std::size_t offset{ 0U }; offset < m_thread_count; ++offset)
+        {
+            auto & queue{ m_queues[(index + offset) % m_thread_count] };
+            if (auto task{ take_task(queue, offset == 0U) })
+                return task;
+        }
+        return nullptr;
+    }
+
+    std::unique_ptr<detail::pool_task> thread_pool::take_task(worker_queue & queue, bool newest) noexcept
+    {
+        for (;;)
+        {
+            std::unique_ptr<detail::pool_task> task;
+            {
+                const std::lock_guard<std::mutex> lock{ queue.mtx };
+                if (queue.tasks.empty())
+                    return nullptr;
+                if (newest)
+                {
+                    task = std::move(queue.tasks.back());
+                    queue.tasks.pop_back();
+                }
+                else
+                {
+                    task = std::move(queue.tasks.front());
+                    queue.tasks.pop_front();
+                }
+            }
+
+            // A cancelled task is destroyed outside the lock, as its destructor runs user code.
+            if (!task->is_cancelled())
+                return task;
+            m_discarded.fetch_add(1U, std::memory_order_relaxed);
+            task.reset();
+        }
+    }
+}
@@ -0,0 +1,258 @@
+/**
+ * @file timer_service.cpp
+ * @brief Defines a background thread which calls functions when their deadlines are reached.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include "shared_flag/detail/timer_service.hpp"
+#include <algorithm>
+
+namespace prb::detail
+{
+    //----------------------------------------------------------------------------------------------
+    // Construction / destruction.
+
+    timer_service & timer_service::instance()
+    {
+        static timer_service service;
+        return service;
+    }
+
+    timer_service::timer_service() :
+        m_epoch{ std::chrono::steady_clock::now() },
+        m_thread{ [this] { run(); } }
+    {
+    }
+
+    timer_service::~timer_service()
+    {
+        {
+            const std::lock_guard<std::mutex> lock{ m_mtx };
+            m_stopping = true;
+        }
+        m_cond_var.notify_all();
+        m_thread.join();
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // Accessors / operations.
+
+    void timer_service::schedule(timer_entry & timer, std::chrono::steady_clock::time_point deadline) noexcept
+    {
+        bool is_sooner{ false };
+        {
+            const std::lock_guard<std::mutex> lock{ m_mtx };
+            timer.m_expiry = to_tick(deadline);
+            insert(timer);
+            ++m_count;
+            is_sooner = std::max(timer.m_expiry, m_current) < m_wake_tick;
+        }
+
+        // The service thread only needs to recalculate its wake-up time if this timer is due
+        //  before it would have woken up anyway.
+        if (is_sooner)
+            m_cond_var.notify_all();
+    }
+
+    void timer_service::cancel(timer_entry & timer) noexcept
+    {
+        std::unique_lock<std::mutex> lock{ m_mtx };
+        if (timer.m_slot)
+        {
+            unlink(timer);
+            --m_count;
+            return;
+        }
+
+        // If the timer's own callback is cancelling it, then the service thread just won't touch
+        //  it again. Otherwise, wait for the callback to finish before the timer is destroyed.
+        if (std::this_thread::get_id() == m_thread.get_id())
+            return;
+        m_cond_var.wait(lock, [&] { return m_firing != &timer; });
+    }
+
+
+    //----------------------------------------------------------------------------------------------
+    // Internal operations.
+
+    void timer_service::run() noexcept
+    {
+        std::unique_lock<std::mutex> lock{ m_mtx };
+        while (!m_stopping)
+        {
+            const auto elapsed{ std::chrono::steady_clock::now() - m_epoch };
+            const auto now_tick{ static_cast<std::uint64_t>(
+                std::chrono::floor<std::chrono::milliseconds>(elapsed) / timer_resolution
+            ) };
+
+            if (m_count == 0U)
+            {
+                // Nothing is scheduled, so the wheel can jump straight to the present.
+                m_current = std::max(m_current, now_tick + 1U);
+                m_wake_tick = never_wake;
+                m_cond_var.wait(lock);
+                m_wake_tick = 0U;
+                continue;
+            }
+
+            if (m_current > now_tick)
+            {
+                m_wake_tick = next_event();
+                const auto wake_time{ m_epoch + timer_resolution * static_cast<std::int64_t>(m_wake_tick) };
+                m_cond_var.wait_until(lock, wake_time);
+                m_wake_tick = 0U;
+                continue;
+            }
+
+            // Catch up with the present. Ticks with nothing to do are skipped.
+            while (m_count > 0U && !m_stopping)
+            {
+                const auto next{ next_event() };
+                if (next > now_tick)
+                {
+                    m_current = now_tick + 1U;
+                    break;
+                }
+
+                m_current = next;
+                cascade();
+                auto & slot{ m_near[m_current & near_mask] };
+                while (slot && !m_stopping)
+                {
+                    auto * const timer{ slot };
+                    unlink(*timer);
+                    --m_count;
+                    m_firing = timer;
+
+                    lock.unlock();
+                    timer->m_callback(*timer);
+                    lock.lock();
+
+                    m_firing = nullptr;
+                    m_cond_var.notify_all();
+                }
+                ++m_current;
+            }
+        }
+    }
+
+    std::uint64_t timer_service::to_tick(std::chrono::steady_clock::time_point deadline) const noexcept
+    {
+        if (deadline <= m_epoch)
+            return 0U;
+        const auto offset{ std::chrono::ceil<std::chrono::milliseconds>(deadline - m_epoch) };
+        return static_cast<std::uint64_t>(offset / timer_resolution);
+    }
+
+    void timer_service::insert(timer_entry & timer) noexcept
+    {
+        // A timer which is already due goes in the slot which is about to be processed.
+        auto expiry{ std::max(timer.m_expiry, m_current) };
+        auto delta{ expiry - m_current };
+
+        timer_entry ** slot{ nullptr };
+        if (delta < near_size)
+        {
+            slot = &m_near[expiry & near_mask];
+        }
+        else
+        {
+            // A timer beyond the horizon waits in the top level, and is re-sorted when that slot
+            //  is cascaded. Its real expiry is preserved.
+            if (delta >= horizon)
+            {
+                expiry = m_current + horizon - 1U;
+                delta = horizon - 1U;
+            }
+
+            std::size_t level{ 0U };
+            auto shift{ near_bits };
+            while (delta >= (std::uint64_t{ 1U } << (shift + far_bits)))
+            {
+                ++level;
+                shift += far_bits;
+            }
+            slot = &m_far[level][(expiry >> shift) & far_mask];
+        }
+
+        timer.m_slot = slot;
+        timer.m_prev = nullptr;
+        timer.m_next = *slot;
+        if (*slot)
+            (*slot)->m_prev = &timer;
+        *slot = &timer;
+    }
+
+    void timer_service::unlink(timer_entry & timer) noexcept
+    {
+        if (timer.m_prev)
+            timer.m_prev->m_next = timer.m_next;
+        else
+            *timer.m_slot = timer.m_next;
+        if (timer.m_next)
+            timer.m_next->m_prev = timer.m_prev;
+
+        timer.m_slot = nullptr;
+        timer.m_prev = nullptr;
+        timer.m_next = nullptr;
+    }
+
+    void timer_service::cascade() noexcept
+    {
+        // Each level only turns over when the level below it has completed a revolution.
+        auto shift{ near_bits };
+        for (std::size_t level{ 0U }; level < far_levels; ++level)
+        {
+            if ((m_current & ((std::uint64_t{ 1U } << shift) - 1U)) != 0U)
+                return;
+
+            auto & slot{ m_far[level][(m_current >> shift) & far_mask] };
+            auto * timer{ slot };
+            slot = nullptr;
+            while (timer)
+            {
+                auto * const next{ timer->m_next };
+                insert(*timer);
+                timer = next;
+            }
+            shift += far_bits;
+        }
+    }
+
+    std::uint64_t timer_service::next_event() const noexcept
+    {
+        auto result{ never_wake };
+        for (auto tick{ m_current }; tick < m_current + near_size; ++tick)
+        {
+            if (m_near[tick & near_mask])
+            {
+                result = tick;
+                break;
+            }
+        }
+
+        // A higher-level slot has to be woken for when it's cascaded, which is at the start of
+        //  the span of ticks it covers.
+        auto shift{ near_bits };
+        for (std::size_t level{ 0U }; level < far_levels; ++level)
+        {
+            const auto span{ std::uint64_t{ 1U } << shift };
+            const auto first{ (m_current + span - 1U) & ~(span - 1U) };
+            for (std::uint64_t index{ 0U }; index <= far_mask; ++index)
+            {
+                const auto tick{ first + index * span };
+                if (tick >= result)
+                    break;
+                if (m_far[level][(tick >> shift) & far_mask])
+                {
+                    result = tick;
+                    break;
+                }
+            }
+            shift += far_bits;
+        }
+        return result;
+    }
+}
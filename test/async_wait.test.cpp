@@ -0,0 +1,346 @@
+/**
+ * @file async_wait.test.cpp
+ * @brief Defines unit tests for the coroutine awaitables.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include "shared_flag/async_wait.hpp"
+#include "shared_flag/compact_shared_flag.hpp"
+#include "shared_flag/shared_flag.hpp"
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std::literals;
+using namespace prb;
+
+namespace
+{
+    // Short-hand alias to get the current steady clock time point.
+    constexpr auto now = std::chrono::steady_clock::now;
+
+    /**
+     * A minimal coroutine type which starts running immediately.
+     * The frame stays alive after the coroutine finishes, until this object is destroyed. Destroying
+     *  it while the coroutine is suspended cancels the coroutine.
+     */
+    class task
+    {
+    public:
+        struct promise_type
+        {
+            task get_return_object()
+            {
+                return task{ std::coroutine_handle<promise_type>::from_promise(*this) };
+            }
+
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            void return_void() noexcept {}
+            void unhandled_exception() { std::terminate(); }
+        };
+
+        explicit task(std::coroutine_handle<promise_type> handle) : m_handle{ handle } {}
+        task(task && other) noexcept : m_handle{ std::exchange(other.m_handle, nullptr) } {}
+        task & operator=(task &&) = delete;
+
+        ~task()
+        {
+            if (m_handle)
+                m_handle.destroy();
+        }
+
+        bool done() const
+        {
+            return m_handle.done();
+        }
+
+    private:
+        std::coroutine_handle<promise_type> m_handle;
+    };
+
+    /// An executor which queues coroutines to be resumed later by the test thread.
+    class queue_executor
+    {
+    public:
+        void operator()(std::coroutine_handle<> handle) noexcept
+        {
+            {
+                const std::lock_guard<std::mutex> lock{ m_mtx };
+                m_queue.push_back(handle);
+            }
+            m_cond_var.notify_all();
+        }
+
+        /// Resume all queued coroutines. Returns the number which were resumed.
+        std::size_t run()
+        {
+            std::deque<std::coroutine_handle<>> queue;
+            {
+                const std::lock_guard<std::mutex> lock{ m_mtx };
+                queue.swap(m_queue);
+            }
+            for (auto handle : queue)
+                handle.resume();
+            return queue.size();
+        }
+
+        /// Wait until a coroutine is queued, then resume it. Returns false if the timeout expires.
+        bool run_one_for(std::chrono::milliseconds timeout)
+        {
+            std::unique_lock<std::mutex> lock{ m_mtx };
+            if (!m_cond_var.wait_for(lock, timeout, [&] { return !m_queue.empty(); }))
+                return false;
+            const auto handle{ m_queue.front() };
+            m_queue.pop_front();
+            lock.unlock();
+            handle.resume();
+            return true;
+        }
+
+    private:
+        std::mutex m_mtx;
+        std::condition_variable m_cond_var;
+        std::deque<std::coroutine_handle<>> m_queue;
+    };
+
+    /// Refers to a queue_executor, so that the awaiters can copy it.
+    struct executor_ref
+    {
+        queue_executor * executor;
+
+        void operator()(std::coroutine_handle<> handle) const noexcept
+        {
+            (*executor)(handle);
+        }
+    };
+
+    task await_directly(shared_flag_reader flag, bool & resumed)
+    {
+        co_await flag;
+        resumed = true;
+    }
+
+    task await_via(shared_flag_reader flag, queue_executor & executor, std::thread::id & resumed_by)
+    {
+        co_await async_wait(flag, executor_ref{ &executor });
+        resumed_by = std::this_thread::get_id();
+    }
+
+    template <class Duration>
+    task await_for(shared_flag_reader flag, Duration timeout, queue_executor & executor, std::optional<bool> & result)
+    {
+        result = co_await async_wait_for(flag, timeout, executor_ref{ &executor });
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// operator co_await
+
+TEST(async_wait, coAwaitDoesNotSuspendIfFlagWasAlreadySet)
+{
+    shared_flag flag;
+    flag.set();
+    bool resumed{ false };
+    const auto coroutine{ await_directly(flag, resumed) };
+    ASSERT_TRUE(resumed);
+    ASSERT_TRUE(coroutine.done());
+}
+
+TEST(async_wait, coAwaitSuspendsUntilFlagIsSet)
+{
+    shared_flag flag;
+    bool resumed{ false };
+    const auto coroutine{ await_directly(flag, resumed) };
+    ASSERT_FALSE(resumed);
+    flag.set();
+    ASSERT_TRUE(resumed);
+    ASSERT_TRUE(coroutine.done());
+}
+
+TEST(async_wait, coAwaitSupportsCompactHandles)
+{
+    compact_shared_flag flag;
+    bool resumed{ false };
+    auto coroutine{ [](compact_shared_flag_reader reader, bool & result) -> task
+    {
+        co_await reader;
+        result = true;
+    }(flag, resumed) };
+    flag.set();
+    ASSERT_TRUE(resumed);
+}
+
+TEST(async_wait, destroyingSuspendedCoroutineCancelsTheWait)
+{
+    shared_flag flag;
+    bool resumed{ false };
+    {
+        const auto coroutine{ await_directly(flag, resumed) };
+    }
+    flag.set();
+    ASSERT_FALSE(resumed);
+}
+
+TEST(async_wait, oneThreadCanHaveManyWaitsOutstanding)
+{
+    shared_flag flag;
+    std::vector<task> coroutines;
+    std::vector<char> resumed(100'000, false);
+    coroutines.reserve(resumed.size());
+    for (auto & result : resumed)
+    {
+        coroutines.push_back([](shared_flag_reader reader, char & r) -> task
+        {
+            co_await reader;
+            r = true;
+        }(flag, result));
+    }
+
+    flag.set();
+    for (const auto & coroutine : coroutines)
+        ASSERT_TRUE(coroutine.done());
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// async_wait()
+
+TEST(async_wait, asyncWaitResumesViaTheExecutor)
+{
+    shared_flag flag;
+    queue_executor executor;
+    std::thread::id resumed_by{};
+    const auto coroutine{ await_via(flag, executor, resumed_by) };
+
+    std::thread{ [&] { flag.set(); } }.join();
+    ASSERT_FALSE(coroutine.done());
+    ASSERT_EQ(executor.run(), 1U);
+    ASSERT_TRUE(coroutine.done());
+    ASSERT_EQ(resumed_by, std::this_thread::get_id());
+}
+
+TEST(async_wait, asyncWaitDoesNotUseTheExecutorIfFlagWasAlreadySet)
+{
+    shared_flag flag;
+    flag.set();
+    queue_executor executor;
+    std::thread::id resumed_by{};
+    const auto coroutine{ await_via(flag, executor, resumed_by) };
+    ASSERT_TRUE(coroutine.done());
+    ASSERT_EQ(executor.run(), 0U);
+}
+
+TEST(async_wait, asyncWaitThrowsLogicErrorIfFlagHasNoSharedState)
+{
+    shared_flag flag1;
+    shared_flag flag2{ std::move(flag1) };
+    ASSERT_THROW(async_wait(flag1), std::logic_error);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// async_wait_for()
+
+TEST(async_wait, asyncWaitForReturnsTrueIfFlagIsSetBeforeTimeout)
+{
+    shared_flag flag;
+    queue_executor executor;
+    std::optional<bool> result;
+    const auto coroutine{ await_for(flag, 10s, executor, result) };
+    ASSERT_FALSE(result.has_value());
+
+    flag.set();
+    ASSERT_EQ(executor.run(), 1U);
+    ASSERT_EQ(result, true);
+}
+
+TEST(async_wait, asyncWaitForReturnsFalseIfTimeoutExpires)
+{
+    shared_flag flag;
+    queue_executor executor;
+    std::optional<bool> result;
+    const auto start{ now() };
+    const auto coroutine{ await_for(flag, 100ms, executor, result) };
+    ASSERT_TRUE(executor.run_one_for(10s));
+    ASSERT_GE(now() - start, 100ms);
+    ASSERT_EQ(result, false);
+}
+
+TEST(async_wait, asyncWaitForDoesNotSuspendIfTimeoutIsZero)
+{
+    shared_flag flag;
+    queue_executor executor;
+    std::optional<bool> result;
+    const auto coroutine{ await_for(flag, 0ms, executor, result) };
+    ASSERT_EQ(result, false);
+    ASSERT_TRUE(coroutine.done());
+}
+
+TEST(async_wait, asyncWaitForResumesOnlyOnceIfFlagIsSetAsTimeoutExpires)
+{
+    for (int i{ 0 }; i < 20; ++i)
+    {
+        shared_flag flag;
+        queue_executor executor;
+        std::optional<bool> result;
+        const auto coroutine{ await_for(flag, 5ms, executor, result) };
+        std::this_thread::sleep_for(5ms);
+        flag.set();
+        ASSERT_TRUE(executor.run_one_for(10s));
+        ASSERT_TRUE(coroutine.done());
+        ASSERT_FALSE(executor.run_one_for(20ms));
+    }
+}
+
+TEST(async_wait, destroyingSuspendedCoroutineCancelsTheTimeout)
+{
+    shared_flag flag;
+    queue_executor executor;
+    std::optional<bool> result;
+    {
+        const auto coroutine{ await_for(flag, 50ms, executor, result) };
+    }
+    ASSERT_FALSE(executor.run_one_for(150ms));
+    ASSERT_FALSE(result.has_value());
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// async_wait_until()
+
+TEST(async_wait, asyncWaitUntilReturnsFalseIfTimeIsReached)
+{
+    shared_flag flag;
+    queue_executor executor;
+    std::optional<bool> result;
+    auto coroutine{ [](shared_flag_reader reader, queue_executor & e, std::optional<bool> & r) -> task
+    {
+        r = co_await async_wait_until(reader, std::chrono::system_clock::now() + 50ms, executor_ref{ &e });
+    }(flag, executor, result) };
+    ASSERT_TRUE(executor.run_one_for(10s));
+    ASSERT_EQ(result, false);
+}
+
+TEST(async_wait, asyncWaitUntilWaitsIndefinitelyForMaximumTimePoint)
+{
+    shared_flag flag;
+    bool resumed{ false };
+    auto coroutine{ [](shared_flag_reader reader, bool & r) -> task
+    {
+        r = co_await async_wait_until(reader, std::chrono::steady_clock::time_point::max());
+    }(flag, resumed) };
+    std::this_thread::sleep_for(50ms);
+    ASSERT_FALSE(coroutine.done());
+    flag.set();
+    ASSERT_TRUE(resumed);
+}
@@ -0,0 +1,199 @@
+/**
+ * @file auto_reset_event.test.cpp
+ * @brief Defines unit tests for the auto_reset_event and auto_reset_event_reader classes.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include "shared_flag/auto_reset_event.hpp"
+#include <atomic>
+#include <future>
+#include <gtest/gtest.h>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace std::literals;
+using namespace prb;
+
+namespace
+{
+    // Short-hand alias to get the current steady clock time point.
+    constexpr auto now = std::chrono::steady_clock::now;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// type properties
+
+TEST(auto_reset_event, readerCannotBePromotedToAnEvent)
+{
+    ASSERT_FALSE((std::is_constructible_v<auto_reset_event, const auto_reset_event_reader &>));
+    ASSERT_FALSE((std::is_assignable_v<auto_reset_event &, const auto_reset_event_reader &>));
+}
+
+TEST(auto_reset_event, isNoBiggerThanAPointer)
+{
+    ASSERT_EQ(sizeof(auto_reset_event), sizeof(void *));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// constructor
+
+TEST(auto_reset_event, defaultConstructedEventIsNotSet)
+{
+    auto_reset_event event;
+    ASSERT_TRUE(event.valid());
+    ASSERT_FALSE(event.try_wait());
+}
+
+TEST(auto_reset_event, eventCanStartOffSet)
+{
+    auto_reset_event event{ true };
+    ASSERT_TRUE(event.try_wait());
+    ASSERT_FALSE(event.try_wait());
+}
+
+TEST(auto_reset_event, moveConstructorRemovesSharedStateReferenceFromSource)
+{
+    auto_reset_event event1;
+    auto_reset_event event2{ std::move(event1) };
+    ASSERT_FALSE(event1.valid());
+    ASSERT_TRUE(event2.valid());
+    ASSERT_THROW(event1.set(), std::logic_error);
+    ASSERT_THROW(event1.try_wait(), std::logic_error);
+    ASSERT_THROW(event1.wait(), std::logic_error);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// set() / reset() / try_wait()
+
+TEST(auto_reset_event, setStaysSetUntilConsumed)
+{
+    auto_reset_event event;
+    auto_reset_event_reader reader{ event };
+    event.set();
+    ASSERT_TRUE(reader.try_wait());
+    ASSERT_FALSE(reader.try_wait());
+    ASSERT_FALSE(event.try_wait());
+}
+
+TEST(auto_reset_event, repeatedSetsAreNotCounted)
+{
+    auto_reset_event event;
+    event.set();
+    event.set();
+    ASSERT_TRUE(event.try_wait());
+    ASSERT_FALSE(event.try_wait());
+}
+
+TEST(auto_reset_event, resetClearsEventWithoutReleasingAThread)
+{
+    auto_reset_event event;
+    event.set();
+    event.reset();
+    ASSERT_FALSE(event.try_wait());
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// wait()
+
+TEST(auto_reset_event, waitConsumesEventIfItWasAlreadySet)
+{
+    auto_reset_event event{ true };
+    event.wait();
+    ASSERT_FALSE(event.try_wait());
+}
+
+TEST(auto_reset_event, setReleasesOneWaitingThreadAtATime)
+{
+    auto_reset_event event;
+    std::atomic<int> released{ 0 };
+    std::vector<std::future<void>> tasks;
+    for (int i{ 0 }; i < 3; ++i)
+    {
+        tasks.push_back(std::async(std::launch::async, [&released](auto_reset_event_reader reader)
+        {
+            reader.wait();
+            ++released;
+        }, event));
+    }
+
+    std::this_thread::sleep_for(150ms);
+    for (int expected{ 1 }; expected <= 3; ++expected)
+    {
+        event.set();
+        std::this_thread::sleep_for(150ms);
+        ASSERT_EQ(released, expected);
+    }
+    for (auto & task : tasks)
+        ASSERT_EQ(task.wait_for(10s), std::future_status::ready);
+    ASSERT_FALSE(event.try_wait());
+}
+
+TEST(auto_reset_event, eventCanPassControlBackAndForthRepeatedly)
+{
+    constexpr int cycles{ 10'000 };
+    auto_reset_event ping;
+    auto_reset_event pong;
+    auto other{ std::async(std::launch::async, [ping, pong]() mutable
+    {
+        for (int i{ 0 }; i < cycles; ++i)
+        {
+            if (!ping.wait_for(10s))
+                return false;
+            pong.set();
+        }
+        return true;
+    }) };
+
+    for (int i{ 0 }; i < cycles; ++i)
+    {
+        ping.set();
+        ASSERT_TRUE(pong.wait_for(10s));
+    }
+    ASSERT_TRUE(other.get());
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// wait_for() / wait_until()
+
+TEST(auto_reset_event, waitForReturnsFalseIfTimeoutExpires)
+{
+    auto_reset_event event;
+    const auto start{ now() };
+    ASSERT_FALSE(event.wait_for(100ms));
+    ASSERT_GE(now() - start, 100ms);
+}
+
+TEST(auto_reset_event, setIsNotLostIfAWaiterTimesOut)
+{
+    // One thread times out while the other keeps waiting. Setting the event afterwards must still
+    //  release the remaining thread.
+    auto_reset_event event;
+    auto short_wait{ std::async(std::launch::async, [](auto_reset_event_reader reader)
+    {
+        return reader.wait_for(50ms);
+    }, event) };
+    auto long_wait{ std::async(std::launch::async, [](auto_reset_event_reader reader)
+    {
+        return reader.wait_for(10s);
+    }, event) };
+
+    ASSERT_FALSE(short_wait.get());
+    event.set();
+    ASSERT_TRUE(long_wait.get());
+}
+
+TEST(auto_reset_event, waitUntilSupportsOtherClocks)
+{
+    auto_reset_event event;
+    ASSERT_FALSE(event.wait_until(std::chrono::system_clock::now() + 50ms));
+    event.set();
+    ASSERT_TRUE(event.wait_until(std::chrono::system_clock::now() + 50ms));
+    ASSERT_FALSE(event.try_wait());
+}
@@ -0,0 +1,300 @@
+/**
+ * @file compact_shared_flag.test.hpp
+ * @brief Defines unit tests for the compact_shared_flag class.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include "shared_flag/compact_shared_flag.hpp"
+#include "shared_flag/flag_callback.hpp"
+#include "shared_flag/shared_flag.hpp"
+#include <future>
+#include <gtest/gtest.h>
+#include <thread>
+#include <type_traits>
+
+#if defined(__linux__)
+#   include "shared_flag/signal_flag.hpp"
+#   include <cerrno>
+#   include <poll.h>
+#   include <signal.h>
+#endif
+
+using namespace std::literals;
+using namespace prb;
+
+
+//--------------------------------------------------------------------------------------------------
+// type properties
+
+TEST(compact_shared_flag, isNotPolymorphic)
+{
+    ASSERT_FALSE(std::is_polymorphic_v<compact_shared_flag>);
+}
+
+TEST(compact_shared_flag, cannotBePromotedFromAReader)
+{
+    ASSERT_FALSE((std::is_constructible_v<compact_shared_flag, const compact_shared_flag_reader &>));
+    ASSERT_FALSE((std::is_assignable_v<compact_shared_flag &, const compact_shared_flag_reader &>));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// default constructor
+
+TEST(compact_shared_flag, defaultConstructorCreatesAnIndependentInstance)
+{
+    compact_shared_flag flag1;
+    compact_shared_flag flag2;
+    flag1.set();
+    ASSERT_FALSE(flag2.get());
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// spin policy constructor
+
+TEST(compact_shared_flag, spinPolicyConstructorCreatesAnIndependentInstance)
+{
+    compact_shared_flag flag1{ spin_policy{ 100, 10 } };
+    compact_shared_flag flag2{ spin_policy{ 100, 10 } };
+    flag1.set();
+    ASSERT_FALSE(flag2.get());
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// child constructor
+
+TEST(compact_shared_flag, childIsSetWhenAnyOfItsParentsIsSet)
+{
+    compact_shared_flag parent1;
+    shared_flag parent2;
+    compact_shared_flag child{ child_of, compact_shared_flag_reader{ parent1 }, parent2 };
+    ASSERT_FALSE(child.get());
+    parent2.set();
+    ASSERT_TRUE(child.get());
+    ASSERT_FALSE(parent1.get());
+}
+
+TEST(compact_shared_flag, childIsSetImmediatelyIfAParentWasAlreadySet)
+{
+    compact_shared_flag parent;
+    parent.set();
+    compact_shared_flag child{ child_of, parent };
+    ASSERT_TRUE(child.get());
+}
+
+TEST(compact_shared_flag, childConstructorThrowsLogicErrorIfParentHasNoSharedState)
+{
+    compact_shared_flag parent1;
+    compact_shared_flag parent2{ std::move(parent1) };
+    ASSERT_THROW((compact_shared_flag{ child_of, parent1 }), std::logic_error);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// conversion constructor
+
+TEST(compact_shared_flag, conversionConstructorCopiesReferenceToExistingSharedState)
+{
+    shared_flag flag1;
+    compact_shared_flag flag2{ flag1 };
+    flag2.set();
+    ASSERT_TRUE(flag1.get());
+}
+
+TEST(compact_shared_flag, conversionConstructorThrowsLogicErrorIfSourceHasNoSharedState)
+{
+    shared_flag flag1;
+    shared_flag flag2{ std::move(flag1) };
+    ASSERT_THROW(compact_shared_flag{ flag1 }, std::logic_error);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// copy / move
+
+TEST(compact_shared_flag, copyConstructorCopiesReferenceToExistingSharedState)
+{
+    compact_shared_flag flag1;
+    compact_shared_flag flag2{ flag1 };
+    flag1.set();
+    ASSERT_TRUE(flag2.get());
+}
+
+TEST(compact_shared_flag, moveConstructorRemovesSharedStateReferenceFromSource)
+{
+    compact_shared_flag flag1;
+    compact_shared_flag flag2{ std::move(flag1) };
+    ASSERT_FALSE(flag1.valid());
+    ASSERT_TRUE(flag2.valid());
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// set()
+
+TEST(compact_shared_flag, setUpdatesFlagInSharedState)
+{
+    compact_shared_flag flag1;
+    compact_shared_flag flag2{ flag1 };
+    flag1.set();
+    ASSERT_TRUE(flag2.get());
+}
+
+TEST(compact_shared_flag, setHasNoEffectIfFlagWasAlreadySet)
+{
+    compact_shared_flag flag;
+    flag.set();
+    ASSERT_NO_THROW(flag.set());
+    ASSERT_TRUE(flag.get());
+}
+
+TEST(compact_shared_flag, setWakesThreadsWaitingViaAshared_flag_reader)
+{
+    shared_flag flag1;
+    compact_shared_flag flag2{ flag1 };
+    auto function{ [](shared_flag_reader reader) { return reader.wait_for(2s); } };
+    auto task{ std::async(std::launch::async, function, flag1) };
+
+    std::this_thread::sleep_for(150ms);
+    flag2.set();
+    ASSERT_TRUE(task.get());
+}
+
+TEST(compact_shared_flag, setThrowsLogicErrorIfSharedStateHasBeenMovedAway)
+{
+    compact_shared_flag flag1;
+    compact_shared_flag flag2{ std::move(flag1) };
+    ASSERT_THROW(flag1.set(), std::logic_error);
+}
+
+TEST(compact_shared_flag, setWithReasonIsVisibleToAllHandles)
+{
+    shared_flag flag3;
+    compact_shared_flag flag1{ flag3 };
+    compact_shared_flag_reader flag2{ flag1 };
+    flag1.set(42);
+    ASSERT_TRUE(flag2.get());
+    ASSERT_EQ(flag2.reason<int>(), 42);
+    ASSERT_EQ(flag3.reason<int>(), 42);
+}
+
+TEST(compact_shared_flag, reasonThrowsLogicErrorIfSharedStateHasBeenMovedAway)
+{
+    compact_shared_flag flag1;
+    compact_shared_flag flag2{ std::move(flag1) };
+    ASSERT_THROW(flag1.set(42), std::logic_error);
+    ASSERT_THROW(flag1.reason<int>(), std::logic_error);
+}
+
+
+#if defined(__linux__)
+//--------------------------------------------------------------------------------------------------
+// set_from_signal()
+
+namespace
+{
+    // The flag set by the test signal handler.
+    compact_shared_flag * signal_target{ nullptr };
+
+    void set_signal_target(int) noexcept
+    {
+        signal_target->set_from_signal();
+    }
+}
+
+TEST(compact_shared_flag, setFromSignalUpdatesFlagInSharedState)
+{
+    compact_shared_flag flag;
+    compact_shared_flag_reader reader{ flag };
+    flag.set_from_signal();
+    ASSERT_TRUE(reader.get());
+}
+
+TEST(compact_shared_flag, setFromSignalDoesNothingIfSharedStateHasBeenMovedAway)
+{
+    compact_shared_flag flag1;
+    compact_shared_flag flag2{ std::move(flag1) };
+    ASSERT_TRUE(noexcept(flag1.set_from_signal()));
+    flag1.set_from_signal();
+    ASSERT_FALSE(flag2.get());
+}
+
+TEST(compact_shared_flag, setFromSignalPreservesErrno)
+{
+    compact_shared_flag flag;
+    flag.native_handle();
+    errno = EAGAIN;
+    flag.set_from_signal();
+    ASSERT_EQ(errno, EAGAIN);
+}
+
+TEST(compact_shared_flag, setFromSignalWakesBlockedThreads)
+{
+    compact_shared_flag flag;
+    auto task{ std::async(std::launch::async, [](compact_shared_flag_reader reader)
+    {
+        reader.wait();
+    }, flag) };
+
+    std::this_thread::sleep_for(150ms);
+    start_signal_dispatch();
+    flag.set_from_signal();
+    ASSERT_EQ(task.wait_for(10s), std::future_status::ready);
+}
+
+TEST(compact_shared_flag, setFromSignalMakesNativeHandleReadable)
+{
+    compact_shared_flag flag;
+    pollfd entry{ flag.native_handle(), POLLIN, 0 };
+    flag.set_from_signal();
+    ASSERT_EQ(poll(&entry, 1, 0), 1);
+}
+
+TEST(compact_shared_flag, setFromSignalNotifiesListenersOnTheDispatchThread)
+{
+    start_signal_dispatch();
+    compact_shared_flag flag;
+    shared_flag child{ child_of, flag };
+    std::promise<std::thread::id> called;
+    flag_callback callback{ flag, [&] { called.set_value(std::this_thread::get_id()); } };
+
+    flag.set_from_signal();
+    auto result{ called.get_future() };
+    ASSERT_EQ(result.wait_for(10s), std::future_status::ready);
+    ASSERT_NE(result.get(), std::this_thread::get_id());
+    ASSERT_TRUE(child.wait_for(10s));
+}
+
+TEST(compact_shared_flag, setFromSignalNotifiesListenersWhenDispatchIsStartedLater)
+{
+    compact_shared_flag flag;
+    shared_flag child{ child_of, flag };
+    flag.set_from_signal();
+    start_signal_dispatch();
+    ASSERT_TRUE(child.wait_for(10s));
+}
+
+TEST(compact_shared_flag, setFromSignalCanBeCalledFromASignalHandler)
+{
+    start_signal_dispatch();
+    compact_shared_flag flag;
+    shared_flag child{ child_of, flag };
+    signal_target = &flag;
+
+    struct sigaction action{};
+    struct sigaction previous{};
+    action.sa_handler = &set_signal_target;
+    sigemptyset(&action.sa_mask);
+    ASSERT_EQ(sigaction(SIGUSR1, &action, &previous), 0);
+
+    raise(SIGUSR1);
+    ASSERT_TRUE(flag.get());
+    ASSERT_TRUE(child.wait_for(10s));
+
+    sigaction(SIGUSR1, &previous, nullptr);
+    signal_target = nullptr;
+}
+#endif
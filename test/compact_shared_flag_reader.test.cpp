@@ -0,0 +1,372 @@
+/**
+ * @file compact_shared_flag_reader.test.hpp
+ * @brief Defines unit tests for the compact_shared_flag_reader class.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include "shared_flag/compact_shared_flag.hpp"
+#include "shared_flag/shared_flag.hpp"
+#include <future>
+#include <gtest/gtest.h>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if defined(__linux__)
+#   include <poll.h>
+#endif
+
+using namespace std::literals;
+using namespace prb;
+
+namespace
+{
+    // Short-hand alias to get the current steady clock time point.
+    constexpr auto now = std::chrono::steady_clock::now;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// type properties
+
+TEST(compact_shared_flag_reader, isNotPolymorphic)
+{
+    ASSERT_FALSE(std::is_polymorphic_v<compact_shared_flag_reader>);
+}
+
+TEST(compact_shared_flag_reader, isNoBiggerThanAPointer)
+{
+    ASSERT_EQ(sizeof(compact_shared_flag_reader), sizeof(void *));
+}
+
+TEST(compact_shared_flag_reader, isNothrowCopyableAndMovable)
+{
+    ASSERT_TRUE(std::is_nothrow_copy_constructible_v<compact_shared_flag_reader>);
+    ASSERT_TRUE(std::is_nothrow_copy_assignable_v<compact_shared_flag_reader>);
+    ASSERT_TRUE(std::is_nothrow_move_constructible_v<compact_shared_flag_reader>);
+    ASSERT_TRUE(std::is_nothrow_move_assignable_v<compact_shared_flag_reader>);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// conversion constructor
+
+TEST(compact_shared_flag_reader, conversionConstructorCopiesReferenceToExistingSharedStateInshared_flag)
+{
+    shared_flag flag;
+    compact_shared_flag_reader reader{ flag };
+    flag.set();
+    ASSERT_TRUE(reader.get());
+}
+
+TEST(compact_shared_flag_reader, conversionConstructorCopiesReferenceToExistingSharedStateInshared_flag_reader)
+{
+    shared_flag flag;
+    shared_flag_reader reader1{ flag };
+    compact_shared_flag_reader reader2{ reader1 };
+    flag.set();
+    ASSERT_TRUE(reader2.get());
+}
+
+TEST(compact_shared_flag_reader, conversionConstructorThrowsLogicErrorIfSourceHasNoSharedState)
+{
+    shared_flag flag1;
+    shared_flag flag2{ std::move(flag1) };
+    ASSERT_THROW(compact_shared_flag_reader{ static_cast<const shared_flag_reader &>(flag1) }, std::logic_error);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// copy constructor
+
+TEST(compact_shared_flag_reader, copyConstructorCopiesReferenceToExistingSharedStateIncompact_shared_flag)
+{
+    compact_shared_flag flag;
+    compact_shared_flag_reader reader{ flag };
+    flag.set();
+    ASSERT_TRUE(reader.get());
+}
+
+TEST(compact_shared_flag_reader, copyConstructorCopiesReferenceToExistingSharedStateIncompact_shared_flag_reader)
+{
+    compact_shared_flag flag;
+    compact_shared_flag_reader reader1{ flag };
+    compact_shared_flag_reader reader2{ reader1 };
+    flag.set();
+    ASSERT_TRUE(reader2.get());
+}
+
+TEST(compact_shared_flag_reader, copyConstructorCopiesEmptyReferenceIfSourceHasNoSharedState)
+{
+    compact_shared_flag flag;
+    compact_shared_flag_reader reader1{ flag };
+    compact_shared_flag_reader reader2{ std::move(reader1) };
+    compact_shared_flag_reader reader3{ reader1 };
+    ASSERT_FALSE(reader3.valid());
+}
+
+TEST(compact_shared_flag_reader, copyConstructorIsSafeWhenManyThreadsCopyTheSameFlag)
+{
+    compact_shared_flag flag;
+    auto function{ [](compact_shared_flag_reader reader)
+    {
+        for (int i{ 0 }; i < 100000; ++i)
+            compact_shared_flag_reader copy{ reader };
+    } };
+
+    {
+        auto task1{ std::async(std::launch::async, function, flag) };
+        auto task2{ std::async(std::launch::async, function, flag) };
+        auto task3{ std::async(std::launch::async, function, flag) };
+    }
+    flag.set();
+    ASSERT_TRUE(flag.get());
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// copy assignment
+
+TEST(compact_shared_flag_reader, copyAssignmentCopiesReferenceToExistingSharedState)
+{
+    compact_shared_flag flag;
+    compact_shared_flag_reader reader{ compact_shared_flag{} };
+    reader = flag;
+    flag.set();
+    ASSERT_TRUE(reader.get());
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// move constructor
+
+TEST(compact_shared_flag_reader, moveConstructorTransfersExistingSharedStateReferenceToDestination)
+{
+    compact_shared_flag flag;
+    compact_shared_flag_reader reader1{ flag };
+    compact_shared_flag_reader reader2{ std::move(reader1) };
+    flag.set();
+    ASSERT_TRUE(reader2.get());
+}
+
+TEST(compact_shared_flag_reader, moveConstructorRemovesSharedStateReferenceFromSource)
+{
+    compact_shared_flag flag;
+    compact_shared_flag_reader reader1{ flag };
+    compact_shared_flag_reader reader2{ std::move(reader1) };
+    ASSERT_FALSE(reader1.valid());
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// move assignment
+
+TEST(compact_shared_flag_reader, moveAssignmentTransfersExistingSharedStateReferenceToDestination)
+{
+    compact_shared_flag flag;
+    compact_shared_flag_reader reader1{ flag };
+    flag.set();
+    compact_shared_flag_reader reader2{ compact_shared_flag{} };
+    reader2 = std::move(reader1);
+    ASSERT_TRUE(reader2.get());
+    ASSERT_FALSE(reader1.valid());
+}
+
+TEST(compact_shared_flag_reader, moveAssignmentIsUsedWhenAVectorReallocates)
+{
+    compact_shared_flag flag;
+    std::vector<compact_shared_flag_reader> readers;
+    for (int i{ 0 }; i < 100; ++i)
+        readers.emplace_back(flag);
+    flag.set();
+    for (const auto & reader : readers)
+        ASSERT_TRUE(reader.get());
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// destructor
+
+TEST(compact_shared_flag_reader, destructorDoesNotAffectOtherInstancesReferringToTheSameSharedState)
+{
+    compact_shared_flag flag;
+    compact_shared_flag_reader reader1{ compact_shared_flag{} };
+    {
+        compact_shared_flag_reader reader2{ flag };
+        reader1 = reader2;
+    }
+    flag.set();
+    ASSERT_TRUE(reader1.valid());
+    ASSERT_TRUE(reader1.get());
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// get()
+
+TEST(compact_shared_flag_reader, getReturnsFalseIfFlagHasNotBeenSet)
+{
+    compact_shared_flag flag;
+    compact_shared_flag_reader reader{ flag };
+    ASSERT_FALSE(reader.get());
+    ASSERT_FALSE(static_cast<bool>(reader));
+}
+
+TEST(compact_shared_flag_reader, getReturnsTrueIfFlagHasBeenSet)
+{
+    compact_shared_flag flag;
+    compact_shared_flag_reader reader{ flag };
+    flag.set();
+    ASSERT_TRUE(reader.get());
+    ASSERT_TRUE(static_cast<bool>(reader));
+}
+
+TEST(compact_shared_flag_reader, getReturnsTrueIfFlagWasSetViaAshared_flag)
+{
+    shared_flag flag;
+    compact_shared_flag_reader reader{ flag };
+    flag.set();
+    ASSERT_TRUE(reader.get());
+}
+
+TEST(compact_shared_flag_reader, getThrowsLogicErrorIfSharedStateHasBeenMovedAway)
+{
+    compact_shared_flag flag;
+    compact_shared_flag_reader reader1{ flag };
+    compact_shared_flag_reader reader2{ std::move(reader1) };
+    ASSERT_THROW(reader1.get(), std::logic_error);
+}
+
+
+#if defined(__linux__)
+//--------------------------------------------------------------------------------------------------
+// native_handle()
+
+TEST(compact_shared_flag_reader, nativeHandleBecomesReadableWhenFlagIsSet)
+{
+    compact_shared_flag flag;
+    compact_shared_flag_reader reader{ flag };
+    pollfd entry{ reader.native_handle(), POLLIN, 0 };
+    ASSERT_EQ(poll(&entry, 1, 0), 0);
+    flag.set();
+    ASSERT_EQ(poll(&entry, 1, 0), 1);
+}
+
+TEST(compact_shared_flag_reader, nativeHandleIsSharedWithOtherHandleTypes)
+{
+    shared_flag flag;
+    compact_shared_flag_reader reader{ flag };
+    ASSERT_EQ(reader.native_handle(), flag.native_handle());
+}
+
+TEST(compact_shared_flag_reader, nativeHandleThrowsLogicErrorIfSharedStateHasBeenMovedAway)
+{
+    compact_shared_flag flag;
+    compact_shared_flag_reader reader1{ flag };
+    compact_shared_flag_reader reader2{ std::move(reader1) };
+    ASSERT_THROW(reader1.native_handle(), std::logic_error);
+}
+#endif
+
+
+//--------------------------------------------------------------------------------------------------
+// wait()
+
+TEST(compact_shared_flag_reader, waitReturnsImmediatelyIfFlagWasAlreadySet)
+{
+    compact_shared_flag flag;
+    compact_shared_flag_reader reader{ flag };
+    flag.set();
+    reader.wait();
+    reader.wait(spin_policy{ 100, 10 });
+    SUCCEED();
+}
+
+TEST(compact_shared_flag_reader, waitSupportsMultipleThreadsWaitingOnTheSameFlag)
+{
+    auto function{ [](compact_shared_flag_reader reader) { reader.wait(); } };
+
+    compact_shared_flag flag;
+    auto task1{ std::async(std::launch::async, function, flag) };
+    auto task2{ std::async(std::launch::async, function, flag) };
+    auto task3{ std::async(std::launch::async, function, flag) };
+
+    std::this_thread::sleep_for(150ms);
+    flag.set();
+
+    task1.wait();
+    task2.wait();
+    task3.wait();
+    SUCCEED();
+}
+
+TEST(compact_shared_flag_reader, waitThrowsLogicErrorIfSharedStateWasMovedAway)
+{
+    compact_shared_flag flag;
+    compact_shared_flag_reader reader1{ flag };
+    compact_shared_flag_reader reader2{ std::move(reader1) };
+    ASSERT_THROW(reader1.wait(), std::logic_error);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// wait_for()
+
+TEST(compact_shared_flag_reader, waitForReturnsFalseIfFlagHasNotBeenSetBeforeTimeout)
+{
+    compact_shared_flag flag;
+    compact_shared_flag_reader reader{ flag };
+    ASSERT_FALSE(reader.wait_for(10ms));
+    ASSERT_FALSE(reader.wait_for(10ms, spin_policy{ 100, 10 }));
+}
+
+TEST(compact_shared_flag_reader, waitForReturnsTrueIfFlagWasSetWhileWaiting)
+{
+    compact_shared_flag flag;
+    auto function{ [](compact_shared_flag_reader reader) { return reader.wait_for(2s); } };
+    auto task{ std::async(std::launch::async, function, flag) };
+
+    std::this_thread::sleep_for(150ms);
+    flag.set();
+    ASSERT_TRUE(task.get());
+}
+
+TEST(compact_shared_flag_reader, waitForThrowsLogicErrorIfSharedStateWasMovedAway)
+{
+    compact_shared_flag flag;
+    compact_shared_flag_reader reader1{ flag };
+    compact_shared_flag_reader reader2{ std::move(reader1) };
+    ASSERT_THROW(reader1.wait_for(10ms), std::logic_error);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// wait_until()
+
+TEST(compact_shared_flag_reader, waitUntilReturnsFalseIfFlagHasNotBeenSetBeforeTimeout)
+{
+    compact_shared_flag flag;
+    compact_shared_flag_reader reader{ flag };
+    ASSERT_FALSE(reader.wait_until(now() + 10ms));
+    ASSERT_FALSE(reader.wait_until(now() + 10ms, spin_policy{ 100, 10 }));
+}
+
+TEST(compact_shared_flag_reader, waitUntilReturnsTrueIfFlagWasSetWhileWaiting)
+{
+    compact_shared_flag flag;
+    auto function{ [](compact_shared_flag_reader reader) { return reader.wait_until(now() + 2s); } };
+    auto task{ std::async(std::launch::async, function, flag) };
+
+    std::this_thread::sleep_for(150ms);
+    flag.set();
+    ASSERT_TRUE(task.get());
+}
+
+TEST(compact_shared_flag_reader, waitUntilThrowsLogicErrorIfSharedStateWasMovedAway)
+{
+    compact_shared_flag flag;
+    compact_shared_flag_reader reader1{ flag };
+    compact_shared_flag_reader reader2{ std::move(reader1) };
+    ASSERT_THROW(reader1.wait_until(now() + 10ms), std::logic_error);
+}
@@ -0,0 +1,266 @@
+/**
+ * @file composite_flag.test.cpp
+ * @brief Defines unit tests for the composite_flag class.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include "shared_flag/compact_shared_flag.hpp"
+#include "shared_flag/composite_flag.hpp"
+#include "shared_flag/flag_callback.hpp"
+#include "shared_flag/shared_flag.hpp"
+#include <functional>
+#include <future>
+#include <gtest/gtest.h>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace std::literals;
+using namespace prb;
+
+
+//--------------------------------------------------------------------------------------------------
+// type properties
+
+TEST(composite_flag, isReadOnly)
+{
+    ASSERT_TRUE((std::is_convertible_v<composite_flag, shared_flag_reader>));
+    ASSERT_FALSE((std::is_convertible_v<composite_flag, shared_flag>));
+    ASSERT_FALSE((std::is_assignable_v<composite_flag &, const shared_flag_reader &>));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// constructors
+
+TEST(composite_flag, defaultConstructorCreatesAFlagWhichIsNotSet)
+{
+    composite_flag flag;
+    ASSERT_TRUE(flag.valid());
+    ASSERT_FALSE(flag.get());
+}
+
+TEST(composite_flag, sourceConstructorAttachesAllSources)
+{
+    shared_flag source1;
+    shared_flag source2;
+    composite_flag flag{ source1, shared_flag_reader{ source2 } };
+    ASSERT_FALSE(flag.get());
+    source2.set();
+    ASSERT_TRUE(flag.get());
+    ASSERT_FALSE(source1.get());
+}
+
+TEST(composite_flag, sourceConstructorSetsFlagIfASourceWasAlreadySet)
+{
+    shared_flag source1;
+    compact_shared_flag source2;
+    source2.set();
+    composite_flag flag{ source1, source2 };
+    ASSERT_TRUE(flag.get());
+}
+
+TEST(composite_flag, sourceConstructorThrowsLogicErrorIfSourceHasNoSharedState)
+{
+    shared_flag source1;
+    shared_flag source2{ std::move(source1) };
+    ASSERT_THROW(composite_flag{ source1 }, std::logic_error);
+}
+
+TEST(composite_flag, copyConstructorSharesTheGroupOfSources)
+{
+    shared_flag source;
+    composite_flag flag1;
+    composite_flag flag2{ flag1 };
+    flag2.attach(source);
+    source.set();
+    ASSERT_TRUE(flag1.get());
+}
+
+TEST(composite_flag, copiedReaderSeesTheCompositeFlag)
+{
+    shared_flag source;
+    composite_flag flag{ source };
+    const shared_flag_reader reader{ flag };
+    source.set();
+    ASSERT_TRUE(reader.get());
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// attach()
+
+TEST(composite_flag, attachCausesFlagToBeSetWhenSourceIsSet)
+{
+    shared_flag source;
+    composite_flag flag;
+    flag.attach(source);
+    ASSERT_FALSE(flag.get());
+    source.set();
+    ASSERT_TRUE(flag.get());
+}
+
+TEST(composite_flag, attachSupportsCompactHandles)
+{
+    compact_shared_flag source;
+    composite_flag flag;
+    flag.attach(compact_shared_flag_reader{ source });
+    source.set();
+    ASSERT_TRUE(flag.get());
+}
+
+TEST(composite_flag, attachSetsFlagImmediatelyIfSourceWasAlreadySet)
+{
+    shared_flag source;
+    source.set();
+    composite_flag flag;
+    flag.attach(source);
+    ASSERT_TRUE(flag.get());
+}
+
+TEST(composite_flag, attachWakesThreadsWaitingOnTheFlagWhenSourceIsSet)
+{
+    shared_flag source;
+    composite_flag flag;
+    auto waiter{ std::async(std::launch::async, [reader = shared_flag_reader{ flag }] {
+        return reader.wait_for(10s);
+    }) };
+    std::this_thread::sleep_for(150ms);
+    flag.attach(source);
+    source.set();
+    ASSERT_TRUE(waiter.get());
+}
+
+TEST(composite_flag, attachCanBeChained)
+{
+    shared_flag source;
+    composite_flag inner{ source };
+    composite_flag outer{ shared_flag_reader{ inner } };
+    source.set();
+    ASSERT_TRUE(outer.get());
+}
+
+TEST(composite_flag, attachThrowsLogicErrorIfSharedStateHasBeenMovedAway)
+{
+    shared_flag source;
+    composite_flag flag1;
+    composite_flag flag2{ std::move(flag1) };
+    ASSERT_THROW(flag1.attach(source), std::logic_error);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// detach()
+
+TEST(composite_flag, detachPreventsFlagFromBeingSetBySource)
+{
+    shared_flag source1;
+    shared_flag source2;
+    composite_flag flag{ source1, source2 };
+    ASSERT_TRUE(flag.detach(source1));
+    source1.set();
+    ASSERT_FALSE(flag.get());
+    source2.set();
+    ASSERT_TRUE(flag.get());
+}
+
+TEST(composite_flag, detachAcceptsAnyHandleToTheSameSource)
+{
+    shared_flag source;
+    composite_flag flag{ source };
+    ASSERT_TRUE(flag.detach(shared_flag_reader{ source }));
+    source.set();
+    ASSERT_FALSE(flag.get());
+}
+
+TEST(composite_flag, detachReturnsFalseIfSourceWasNotAttached)
+{
+    shared_flag source1;
+    shared_flag source2;
+    composite_flag flag{ source1 };
+    ASSERT_FALSE(flag.detach(source2));
+}
+
+TEST(composite_flag, detachRemovesOneAttachmentAtATime)
+{
+    compact_shared_flag source;
+    composite_flag flag{ source, source };
+    ASSERT_TRUE(flag.detach(source));
+    ASSERT_TRUE(flag.detach(source));
+    ASSERT_FALSE(flag.detach(source));
+    source.set();
+    ASSERT_FALSE(flag.get());
+}
+
+TEST(composite_flag, detachDoesNotClearFlag)
+{
+    shared_flag source;
+    composite_flag flag{ source };
+    source.set();
+    ASSERT_TRUE(flag.detach(source));
+    ASSERT_TRUE(flag.get());
+}
+
+TEST(composite_flag, detachCanBeCalledByACallbackWhileSourceIsBeingSet)
+{
+    shared_flag source;
+    composite_flag flag{ source };
+    bool detached{ false };
+    flag_callback callback{ flag, [&] { detached = flag.detach(source); } };
+    source.set();
+    ASSERT_TRUE(detached);
+}
+
+TEST(composite_flag, sourcesCanBeAttachedAndDetachedWhileBeingSet)
+{
+    for (int i{ 0 }; i < 50; ++i)
+    {
+        std::vector<shared_flag> sources(10);
+        composite_flag flag;
+        for (const auto & source : sources)
+            flag.attach(source);
+
+        auto setter{ std::async(std::launch::async, [&] {
+            for (auto & source : sources)
+                source.set();
+        }) };
+        for (const auto & source : sources)
+        {
+            flag.detach(source);
+            flag.attach(source);
+        }
+        setter.get();
+        ASSERT_TRUE(flag.get());
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// destructor
+
+TEST(composite_flag, destroyingLastHandleDetachesAllSources)
+{
+    shared_flag source;
+    {
+        composite_flag flag{ source, source };
+    }
+    source.set();
+    ASSERT_TRUE(source.get());
+}
+
+TEST(composite_flag, callbackCanDestroyLastHandleWhileFlagIsBeingSet)
+{
+    shared_flag source;
+    std::optional<composite_flag> flag{ std::in_place, source };
+    std::optional<flag_callback<std::function<void()>>> callback;
+    callback.emplace(*flag, [&]
+    {
+        flag.reset();
+        callback.reset();
+    });
+    source.set();
+    ASSERT_FALSE(flag.has_value());
+    ASSERT_FALSE(callback.has_value());
+}
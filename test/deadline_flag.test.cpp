@@ -0,0 +1,152 @@
+/**
+ * @file deadline_flag.test.cpp
+ * @brief Defines unit tests for the deadline flag functions.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include "shared_flag/deadline_flag.hpp"
+#include <future>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+using namespace prb;
+
+namespace
+{
+    // Short-hand alias to get the current steady clock time point.
+    constexpr auto now = std::chrono::steady_clock::now;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// make_deadline_flag() / make_timeout_flag()
+
+TEST(deadline_flag, flagIsNotSetBeforeDeadline)
+{
+    const auto flag{ make_timeout_flag(10s) };
+    ASSERT_FALSE(flag.get());
+    ASSERT_FALSE(flag.wait_for(50ms));
+}
+
+TEST(deadline_flag, flagIsSetWhenDeadlineIsReached)
+{
+    const auto deadline{ now() + 100ms };
+    const auto flag{ make_deadline_flag(deadline) };
+    ASSERT_TRUE(flag.wait_for(10s));
+    ASSERT_GE(now(), deadline);
+}
+
+TEST(deadline_flag, flagIsSetStraightAwayIfDeadlineHasPassed)
+{
+    const auto flag{ make_deadline_flag(now() - 1s) };
+    ASSERT_TRUE(flag.get());
+    ASSERT_TRUE(make_timeout_flag(0ms).get());
+}
+
+TEST(deadline_flag, flagIsNeverSetIfTimeoutIsTooLong)
+{
+    const auto flag{ make_timeout_flag(std::chrono::hours::max()) };
+    ASSERT_FALSE(flag.wait_for(20ms));
+}
+
+TEST(deadline_flag, flagIsSetWithDeadlineReachedReason)
+{
+    const auto flag{ make_timeout_flag(20ms) };
+    ASSERT_FALSE(flag.reason<deadline_reached>());
+    ASSERT_TRUE(flag.wait_for(10s));
+    ASSERT_TRUE(flag.reason<deadline_reached>());
+}
+
+TEST(deadline_flag, flagCanBeSetEarly)
+{
+    auto flag{ make_timeout_flag(100ms) };
+    flag.set(42);
+    std::this_thread::sleep_for(200ms);
+    ASSERT_EQ(flag.reason<int>(), 42);
+    ASSERT_FALSE(flag.reason<deadline_reached>());
+}
+
+TEST(deadline_flag, deadlinesAreNeverReachedEarly)
+{
+    // These span the first two levels of the timing wheel.
+    std::vector<std::future<bool>> tasks;
+    for (const auto timeout : { 1ms, 5ms, 40ms, 255ms, 256ms, 300ms, 700ms })
+    {
+        tasks.push_back(std::async(std::launch::async, [timeout]
+        {
+            const auto deadline{ now() + timeout };
+            const auto flag{ make_deadline_flag(deadline) };
+            return flag.wait_for(10s) && now() >= deadline;
+        }));
+    }
+    for (auto & task : tasks)
+        ASSERT_TRUE(task.get());
+}
+
+TEST(deadline_flag, childFlagIsSetWithParentDeadline)
+{
+    shared_flag session;
+    const shared_flag request{ child_of, session, make_timeout_flag(50ms) };
+    ASSERT_TRUE(request.wait_for(10s));
+    ASSERT_TRUE(request.reason<deadline_reached>());
+    ASSERT_FALSE(session.get());
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// many deadlines
+
+TEST(deadline_flag, manyDeadlinesCanBeArmedAtOnce)
+{
+    constexpr int count{ 100'000 };
+    const auto start{ now() };
+    std::vector<shared_flag> flags;
+    flags.reserve(count);
+    for (int i{ 0 }; i < count; ++i)
+        flags.push_back(make_deadline_flag(start + 50ms + 1ms * (i % 200)));
+
+    for (const auto & flag : flags)
+        ASSERT_TRUE(flag.wait_for(10s));
+    ASSERT_GE(now(), start + 249ms);
+}
+
+TEST(deadline_flag, flagsWhichAreSetEarlyOrReleasedDontFire)
+{
+    // Half of the flags are set early and half are released. Either way, their timers are
+    //  cancelled, so nothing may touch them when the deadline passes.
+    constexpr int count{ 100'000 };
+    const auto deadline{ now() + 1s };
+    std::vector<shared_flag> flags;
+    flags.reserve(count);
+    for (int i{ 0 }; i < count; ++i)
+        flags.push_back(make_deadline_flag(deadline));
+
+    std::vector<shared_flag_reader> set_early;
+    for (int i{ 0 }; i < count; i += 2)
+    {
+        flags[i].set();
+        set_early.push_back(flags[i]);
+    }
+    flags.clear();
+    ASSERT_LT(now(), deadline);
+
+    const auto sentinel{ make_deadline_flag(deadline + 50ms) };
+    ASSERT_TRUE(sentinel.wait_for(10s));
+    for (const auto & flag : set_early)
+        ASSERT_FALSE(flag.reason<deadline_reached>());
+}
+
+TEST(deadline_flag, distantDeadlinesCanBeCancelled)
+{
+    std::vector<shared_flag> flags;
+    for (const auto timeout : { 1min, 60min, 24 * 60min, 365 * 24 * 60min })
+        flags.push_back(make_timeout_flag(timeout));
+    const auto soon{ make_timeout_flag(20ms) };
+    ASSERT_TRUE(soon.wait_for(10s));
+    for (auto & flag : flags)
+        ASSERT_FALSE(flag.get());
+    flags.clear();
+}
@@ -0,0 +1,222 @@
+/**
+ * @file flag_callback.test.cpp
+ * @brief Defines unit tests for the flag_callback class.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include "shared_flag/compact_shared_flag.hpp"
+#include "shared_flag/flag_callback.hpp"
+#include "shared_flag/shared_flag.hpp"
+#include <atomic>
+#include <functional>
+#include <future>
+#include <gtest/gtest.h>
+#include <list>
+#include <optional>
+#include <thread>
+#include <type_traits>
+
+using namespace std::literals;
+using namespace prb;
+
+
+//--------------------------------------------------------------------------------------------------
+// type properties
+
+TEST(flag_callback, isNotCopyableOrMovable)
+{
+    using callback_type = flag_callback<std::function<void()>>;
+    ASSERT_FALSE(std::is_copy_constructible_v<callback_type>);
+    ASSERT_FALSE(std::is_move_constructible_v<callback_type>);
+}
+
+TEST(flag_callback, deducesCallbackTypeFromConstructorArgument)
+{
+    shared_flag flag;
+    auto function{ [] {} };
+    flag_callback callback{ flag, function };
+    ASSERT_TRUE((std::is_same_v<decltype(callback), flag_callback<decltype(function)>>));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// constructor
+
+TEST(flag_callback, constructorCallsCallbackImmediatelyIfFlagWasAlreadySet)
+{
+    shared_flag flag;
+    flag.set();
+    int count{ 0 };
+    flag_callback callback{ flag, [&] { ++count; } };
+    ASSERT_EQ(count, 1);
+}
+
+TEST(flag_callback, constructorDoesNotCallCallbackIfFlagIsNotSet)
+{
+    shared_flag flag;
+    int count{ 0 };
+    flag_callback callback{ flag, [&] { ++count; } };
+    ASSERT_EQ(count, 0);
+}
+
+TEST(flag_callback, constructorSupportsCompactHandles)
+{
+    compact_shared_flag flag;
+    const compact_shared_flag_reader reader{ flag };
+    int count{ 0 };
+    flag_callback callback{ reader, [&] { ++count; } };
+    flag.set();
+    ASSERT_EQ(count, 1);
+}
+
+TEST(flag_callback, constructorThrowsLogicErrorIfFlagHasNoSharedState)
+{
+    shared_flag flag1;
+    shared_flag flag2{ std::move(flag1) };
+    ASSERT_THROW((flag_callback{ flag1, [] {} }), std::logic_error);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// invocation
+
+TEST(flag_callback, callbackIsCalledOnceWhenFlagIsSet)
+{
+    shared_flag flag;
+    int count{ 0 };
+    flag_callback callback{ flag, [&] { ++count; } };
+    flag.set();
+    flag.set();
+    ASSERT_EQ(count, 1);
+}
+
+TEST(flag_callback, callbackIsCalledByTheThreadWhichSetsTheFlag)
+{
+    shared_flag flag;
+    std::thread::id caller;
+    flag_callback callback{ flag, [&] { caller = std::this_thread::get_id(); } };
+
+    std::thread setter{ [&] { flag.set(); } };
+    const auto setter_id{ setter.get_id() };
+    setter.join();
+    ASSERT_EQ(caller, setter_id);
+}
+
+TEST(flag_callback, callbackIsNotCalledIfRegistrationIsDestroyedBeforeFlagIsSet)
+{
+    shared_flag flag;
+    int count{ 0 };
+    {
+        flag_callback callback{ flag, [&] { ++count; } };
+    }
+    flag.set();
+    ASSERT_EQ(count, 0);
+}
+
+TEST(flag_callback, allCallbacksRegisteredOnTheSameFlagAreCalled)
+{
+    shared_flag flag;
+    int count{ 0 };
+    flag_callback callback1{ flag, [&] { ++count; } };
+    flag_callback callback2{ flag, [&] { ++count; } };
+    flag_callback callback3{ shared_flag_reader{ flag }, [&] { ++count; } };
+    flag.set();
+    ASSERT_EQ(count, 3);
+}
+
+TEST(flag_callback, callbackCanBeMoveOnly)
+{
+    shared_flag flag;
+    auto value{ std::make_unique<int>(7) };
+    int result{ 0 };
+    flag_callback callback{ flag, [&result, value = std::move(value)] { result = *value; } };
+    flag.set();
+    ASSERT_EQ(result, 7);
+}
+
+TEST(flag_callback, callbackCanSetAnotherFlag)
+{
+    shared_flag parent;
+    shared_flag child;
+    flag_callback callback{ parent, [child]() mutable { child.set(); } };
+    parent.set();
+    ASSERT_TRUE(child.get());
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// deregistration
+
+TEST(flag_callback, callbackCanDestroyItsOwnRegistration)
+{
+    shared_flag flag;
+    int count{ 0 };
+    std::optional<flag_callback<std::function<void()>>> callback;
+    callback.emplace(flag, [&] { ++count; callback.reset(); });
+    flag.set();
+    ASSERT_EQ(count, 1);
+    ASSERT_FALSE(callback.has_value());
+}
+
+TEST(flag_callback, callbackCanDestroyAnotherRegistration)
+{
+    shared_flag flag;
+    int count{ 0 };
+    std::optional<flag_callback<std::function<void()>>> callback1;
+    std::optional<flag_callback<std::function<void()>>> callback2;
+    callback1.emplace(flag, [&] { ++count; callback2.reset(); });
+    callback2.emplace(flag, [&] { ++count; callback1.reset(); });
+    flag.set();
+
+    // Whichever callback runs first prevents the other from running.
+    ASSERT_EQ(count, 1);
+}
+
+TEST(flag_callback, destructorWaitsForCallbackRunningOnAnotherThread)
+{
+    shared_flag flag;
+    std::atomic<bool> started{ false };
+    std::atomic<bool> finished{ false };
+    std::future<void> setter;
+    {
+        flag_callback callback{ flag, [&]
+        {
+            started = true;
+            std::this_thread::sleep_for(150ms);
+            finished = true;
+        } };
+
+        setter = std::async(std::launch::async, [&] { flag.set(); });
+        while (!started)
+            std::this_thread::yield();
+    }
+    ASSERT_TRUE(finished);
+    setter.get();
+}
+
+TEST(flag_callback, registrationsCanBeAddedAndRemovedWhileFlagIsBeingSet)
+{
+    for (int i{ 0 }; i < 50; ++i)
+    {
+        shared_flag flag;
+        std::atomic<int> count{ 0 };
+        std::list<flag_callback<std::function<void()>>> callbacks;
+        for (int j{ 0 }; j < 10; ++j)
+            callbacks.emplace_back(flag, [&] { ++count; });
+
+        auto setter{ std::async(std::launch::async, [&] { flag.set(); }) };
+        for (int j{ 0 }; j < 10; ++j)
+        {
+            callbacks.pop_front();
+            callbacks.emplace_back(flag, [&] { ++count; });
+        }
+        setter.get();
+
+        // Every remaining registration must have been called, either by set() or by its
+        //  constructor. Destroyed registrations may or may not have been called.
+        const auto remaining_called{ count.load() };
+        ASSERT_GE(remaining_called, 10);
+        ASSERT_LE(remaining_called, 20);
+    }
+}
@@ -0,0 +1,213 @@
+/**
+ * @file flag_thread.test.cpp
+ * @brief Defines unit tests for the flag_thread class.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include "shared_flag/flag_thread.hpp"
+#include "shared_flag/shared_flag.hpp"
+#include <atomic>
+#include <future>
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace std::literals;
+using namespace prb;
+
+namespace
+{
+    // Short-hand alias to get the current steady clock time point.
+    constexpr auto now = std::chrono::steady_clock::now;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// type properties
+
+TEST(flag_thread, canBeMovedButNotCopied)
+{
+    ASSERT_FALSE(std::is_copy_constructible_v<flag_thread>);
+    ASSERT_FALSE(std::is_copy_assignable_v<flag_thread>);
+    ASSERT_TRUE(std::is_nothrow_move_constructible_v<flag_thread>);
+    ASSERT_TRUE(std::is_nothrow_move_assignable_v<flag_thread>);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// constructor
+
+TEST(flag_thread, defaultConstructedInstanceHasNoThreadOrFlag)
+{
+    flag_thread thread;
+    ASSERT_FALSE(thread.joinable());
+    ASSERT_EQ(thread.get_id(), std::thread::id{});
+    ASSERT_FALSE(thread.get_stop_flag().valid());
+    thread.request_stop();
+}
+
+TEST(flag_thread, functionReceivesTheStopFlagFirst)
+{
+    std::promise<bool> result;
+    auto future{ result.get_future() };
+    flag_thread thread{ [](shared_flag_reader stop, std::promise<bool> promise, int value)
+    {
+        promise.set_value(stop.valid() && !stop.get() && value == 42);
+    }, std::move(result), 42 };
+    ASSERT_TRUE(future.get());
+}
+
+TEST(flag_thread, functionWhichDoesntTakeAFlagOnlyReceivesItsArguments)
+{
+    std::promise<int> result;
+    auto future{ result.get_future() };
+    flag_thread thread{ [](std::promise<int> promise, int value) { promise.set_value(value); }, std::move(result), 7 };
+    ASSERT_EQ(future.get(), 7);
+}
+
+TEST(flag_thread, argumentsAreMovedIntoTheThread)
+{
+    auto value{ std::make_unique<int>(3) };
+    std::promise<int> result;
+    auto future{ result.get_future() };
+    flag_thread thread{ [&result](std::unique_ptr<int> p) { result.set_value(*p); }, std::move(value) };
+    ASSERT_EQ(future.get(), 3);
+    ASSERT_FALSE(value);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// destructor
+
+TEST(flag_thread, destructorSetsTheFlagAndJoins)
+{
+    std::atomic<bool> finished{ false };
+    {
+        flag_thread thread{ [&finished](shared_flag_reader stop)
+        {
+            stop.wait();
+            finished = true;
+        } };
+        std::this_thread::sleep_for(50ms);
+        ASSERT_FALSE(finished);
+    }
+    ASSERT_TRUE(finished);
+}
+
+TEST(flag_thread, moveAssignmentStopsAndJoinsThePreviousThread)
+{
+    std::atomic<bool> finished{ false };
+    flag_thread thread{ [&finished](shared_flag_reader stop)
+    {
+        stop.wait();
+        finished = true;
+    } };
+    thread = flag_thread{ [](shared_flag_reader stop) { stop.wait(); } };
+    ASSERT_TRUE(finished);
+    ASSERT_TRUE(thread.joinable());
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// operations
+
+TEST(flag_thread, requestStopSetsTheFlagWithoutJoining)
+{
+    flag_thread thread{ [](shared_flag_reader stop) { stop.wait(); } };
+    const auto flag{ thread.get_stop_flag() };
+    ASSERT_FALSE(flag.get());
+    thread.request_stop();
+    ASSERT_TRUE(flag.get());
+    ASSERT_TRUE(thread.joinable());
+    thread.join();
+    ASSERT_FALSE(thread.joinable());
+}
+
+TEST(flag_thread, stopFlagOutlivesTheThread)
+{
+    shared_flag_reader flag{ flag_thread{ [](shared_flag_reader stop) { stop.wait(); } }.get_stop_flag() };
+    ASSERT_TRUE(flag.get());
+}
+
+TEST(flag_thread, stopFlagCanBeCombinedWithOtherFlags)
+{
+    shared_flag shutdown;
+    std::promise<void> started;
+    auto future{ started.get_future() };
+    flag_thread thread{ [&shutdown, &started](shared_flag_reader stop)
+    {
+        shared_flag either{ child_of, stop, shutdown };
+        started.set_value();
+        either.wait();
+    } };
+    future.get();
+    shutdown.set();
+    thread.join();
+    ASSERT_FALSE(thread.get_stop_flag().get());
+}
+
+TEST(flag_thread, moveConstructorTransfersTheThreadAndFlag)
+{
+    flag_thread thread1{ [](shared_flag_reader stop) { stop.wait(); } };
+    const auto id{ thread1.get_id() };
+    flag_thread thread2{ std::move(thread1) };
+    ASSERT_FALSE(thread1.joinable());
+    ASSERT_FALSE(thread1.get_stop_flag().valid());
+    ASSERT_EQ(thread2.get_id(), id);
+    ASSERT_TRUE(thread2.get_stop_flag().valid());
+}
+
+TEST(flag_thread, detachedThreadCanStillBeStopped)
+{
+    std::promise<void> finished;
+    auto future{ finished.get_future() };
+    flag_thread thread{ [](shared_flag_reader stop, std::promise<void> promise)
+    {
+        stop.wait();
+        promise.set_value();
+    }, std::move(finished) };
+    thread.detach();
+    ASSERT_FALSE(thread.joinable());
+    thread.request_stop();
+    ASSERT_EQ(future.wait_for(10s), std::future_status::ready);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// stop_all()
+
+TEST(flag_thread, stopAllStopsEveryThreadInParallel)
+{
+    // Each thread takes a while to wind down. Stopping them one at a time would take far longer.
+    constexpr std::size_t count{ 8U };
+    std::vector<flag_thread> threads;
+    for (std::size_t i{ 0U }; i < count; ++i)
+    {
+        threads.emplace_back([](shared_flag_reader stop)
+        {
+            stop.wait();
+            std::this_thread::sleep_for(100ms);
+        });
+    }
+
+    const auto start{ now() };
+    stop_all(threads);
+    ASSERT_LT(now() - start, 100ms * count / 2);
+    for (const auto & thread : threads)
+    {
+        ASSERT_FALSE(thread.joinable());
+        ASSERT_TRUE(thread.get_stop_flag().get());
+    }
+}
+
+TEST(flag_thread, stopAllSkipsThreadsWhichArentJoinable)
+{
+    std::vector<flag_thread> threads(2U);
+    threads.emplace_back([](shared_flag_reader stop) { stop.wait(); });
+    threads.back().request_stop();
+    threads.back().join();
+    stop_all(threads);
+}
@@ -0,0 +1,226 @@
+/**
+ * @file interprocess_flag.test.cpp
+ * @brief Defines unit tests for the interprocess_flag class.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#if defined(__linux__)
+
+#include "shared_flag/interprocess_flag.hpp"
+#include <fcntl.h>
+#include <future>
+#include <gtest/gtest.h>
+#include <new>
+#include <string>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <thread>
+#include <type_traits>
+#include <unistd.h>
+
+using namespace std::literals;
+using namespace prb;
+
+namespace
+{
+    // Short-hand alias to get the current steady clock time point.
+    constexpr auto now = std::chrono::steady_clock::now;
+
+    // Map some anonymous memory which will be shared with child processes after fork().
+    void * map_shared_memory()
+    {
+        void * memory{ mmap(nullptr, sizeof(interprocess_flag), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0) };
+        return memory == MAP_FAILED ? nullptr : memory;
+    }
+
+    // Run a function in a child process, and return its exit code.
+    template <class Function>
+    std::future<int> run_in_child_process(Function function)
+    {
+        const pid_t child{ fork() };
+        if (child == 0)
+            _exit(function());
+
+        return std::async(std::launch::async, [child]
+        {
+            int status{ 0 };
+            if (child < 0 || waitpid(child, &status, 0) != child || !WIFEXITED(status))
+                return -1;
+            return WEXITSTATUS(status);
+        });
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// type properties
+
+TEST(interprocess_flag, isAsSmallAsItsFlagWord)
+{
+    ASSERT_EQ(sizeof(interprocess_flag), 4U);
+    ASSERT_TRUE(std::is_standard_layout_v<interprocess_flag>);
+    ASSERT_TRUE(std::is_trivially_destructible_v<interprocess_flag>);
+}
+
+TEST(interprocess_flag, isNotCopyableOrMovable)
+{
+    ASSERT_FALSE(std::is_copy_constructible_v<interprocess_flag>);
+    ASSERT_FALSE(std::is_move_constructible_v<interprocess_flag>);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// set() / get()
+
+TEST(interprocess_flag, defaultConstructedFlagIsNotSet)
+{
+    interprocess_flag flag;
+    ASSERT_FALSE(flag.get());
+    ASSERT_FALSE(flag);
+}
+
+TEST(interprocess_flag, zeroFilledMemoryIsAFlagWhichIsNotSet)
+{
+    void * memory{ map_shared_memory() };
+    ASSERT_NE(memory, nullptr);
+    const auto * flag{ static_cast<interprocess_flag *>(memory) };
+    ASSERT_FALSE(flag->get());
+    munmap(memory, sizeof(interprocess_flag));
+}
+
+TEST(interprocess_flag, setUpdatesFlag)
+{
+    interprocess_flag flag;
+    flag.set();
+    ASSERT_TRUE(flag.get());
+    ASSERT_TRUE(flag);
+}
+
+TEST(interprocess_flag, setHasNoEffectIfFlagWasAlreadySet)
+{
+    interprocess_flag flag;
+    flag.set();
+    flag.set();
+    ASSERT_TRUE(flag.get());
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// wait()
+
+TEST(interprocess_flag, waitReturnsImmediatelyIfFlagWasAlreadySet)
+{
+    interprocess_flag flag;
+    flag.set();
+    flag.wait();
+    SUCCEED();
+}
+
+TEST(interprocess_flag, waitReturnsIfFlagWasSetByAnotherThread)
+{
+    interprocess_flag flag;
+    auto waiter{ std::async(std::launch::async, [&flag] { flag.wait(); }) };
+    std::this_thread::sleep_for(150ms);
+    flag.set();
+    ASSERT_EQ(waiter.wait_for(10s), std::future_status::ready);
+}
+
+TEST(interprocess_flag, waitInParentReturnsIfFlagIsSetByChildProcess)
+{
+    void * memory{ map_shared_memory() };
+    ASSERT_NE(memory, nullptr);
+    auto * flag{ new (memory) interprocess_flag{} };
+
+    auto child{ run_in_child_process([flag]
+    {
+        std::this_thread::sleep_for(150ms);
+        flag->set();
+        return 0;
+    }) };
+
+    ASSERT_TRUE(flag->wait_for(10s));
+    ASSERT_EQ(child.get(), 0);
+    munmap(memory, sizeof(interprocess_flag));
+}
+
+TEST(interprocess_flag, waitInChildProcessReturnsIfFlagIsSetByParent)
+{
+    void * memory{ map_shared_memory() };
+    ASSERT_NE(memory, nullptr);
+    auto * flag{ new (memory) interprocess_flag{} };
+
+    auto child{ run_in_child_process([flag]
+    {
+        return flag->wait_for(10s) ? 0 : 1;
+    }) };
+
+    std::this_thread::sleep_for(150ms);
+    flag->set();
+    ASSERT_EQ(child.get(), 0);
+    munmap(memory, sizeof(interprocess_flag));
+}
+
+TEST(interprocess_flag, waitWorksAcrossSeparateMappingsOfANamedRegion)
+{
+    const std::string name{ "/prb_interprocess_flag_test_" + std::to_string(getpid()) };
+    const int fd{ shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600) };
+    ASSERT_NE(fd, -1);
+    ASSERT_EQ(ftruncate(fd, sizeof(interprocess_flag)), 0);
+    void * memory{ mmap(nullptr, sizeof(interprocess_flag), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) };
+    close(fd);
+    ASSERT_NE(memory, MAP_FAILED);
+    auto * flag{ new (memory) interprocess_flag{} };
+
+    // The child maps the region again, so the flag is at a different address in the child.
+    auto child{ run_in_child_process([&name]
+    {
+        const int child_fd{ shm_open(name.c_str(), O_RDWR, 0) };
+        if (child_fd == -1)
+            return 2;
+        void * child_memory{ mmap(nullptr, sizeof(interprocess_flag), PROT_READ | PROT_WRITE, MAP_SHARED, child_fd, 0) };
+        close(child_fd);
+        if (child_memory == MAP_FAILED)
+            return 3;
+        return static_cast<interprocess_flag *>(child_memory)->wait_for(10s) ? 0 : 1;
+    }) };
+
+    std::this_thread::sleep_for(150ms);
+    flag->set();
+    ASSERT_EQ(child.get(), 0);
+    munmap(memory, sizeof(interprocess_flag));
+    shm_unlink(name.c_str());
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// wait_for() / wait_until()
+
+TEST(interprocess_flag, waitForReturnsFalseIfTimeoutExpires)
+{
+    interprocess_flag flag;
+    const auto start{ now() };
+    ASSERT_FALSE(flag.wait_for(100ms));
+    ASSERT_GE(now() - start, 100ms);
+}
+
+TEST(interprocess_flag, waitForReturnsImmediatelyIfTimeoutIsZero)
+{
+    interprocess_flag flag;
+    const auto start{ now() };
+    ASSERT_FALSE(flag.wait_for(0ms));
+    ASSERT_LT(now() - start, 50ms);
+}
+
+TEST(interprocess_flag, waitUntilReturnsTrueIfFlagIsSetBeforeDeadline)
+{
+    interprocess_flag flag;
+    auto waiter{ std::async(std::launch::async, [&flag] {
+        return flag.wait_until(std::chrono::system_clock::now() + 10s);
+    }) };
+    std::this_thread::sleep_for(150ms);
+    flag.set();
+    ASSERT_TRUE(waiter.get());
+}
+
+#endif
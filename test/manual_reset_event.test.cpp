@@ -0,0 +1,217 @@
+/**
+ * @file manual_reset_event.test.cpp
+ * @brief Defines unit tests for the manual_reset_event and manual_reset_event_reader classes.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include "shared_flag/manual_reset_event.hpp"
+#include <future>
+#include <gtest/gtest.h>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace std::literals;
+using namespace prb;
+
+namespace
+{
+    // Short-hand alias to get the current steady clock time point.
+    constexpr auto now = std::chrono::steady_clock::now;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// type properties
+
+TEST(manual_reset_event, readerCannotBePromotedToAnEvent)
+{
+    ASSERT_FALSE((std::is_constructible_v<manual_reset_event, const manual_reset_event_reader &>));
+    ASSERT_FALSE((std::is_assignable_v<manual_reset_event &, const manual_reset_event_reader &>));
+}
+
+TEST(manual_reset_event, readerCanBeCopiedFromAnEvent)
+{
+    ASSERT_TRUE((std::is_constructible_v<manual_reset_event_reader, const manual_reset_event &>));
+}
+
+TEST(manual_reset_event, isNoBiggerThanAPointer)
+{
+    ASSERT_EQ(sizeof(manual_reset_event), sizeof(void *));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// constructor
+
+TEST(manual_reset_event, defaultConstructedEventIsNotSet)
+{
+    manual_reset_event event;
+    ASSERT_TRUE(event.valid());
+    ASSERT_FALSE(event.get());
+}
+
+TEST(manual_reset_event, eventCanStartOffSet)
+{
+    manual_reset_event event{ true };
+    ASSERT_TRUE(event.get());
+}
+
+TEST(manual_reset_event, copiesReferToTheSameEvent)
+{
+    manual_reset_event event;
+    manual_reset_event_reader reader{ event };
+    event.set();
+    ASSERT_TRUE(reader.get());
+    event.reset();
+    ASSERT_FALSE(reader.get());
+}
+
+TEST(manual_reset_event, moveConstructorRemovesSharedStateReferenceFromSource)
+{
+    manual_reset_event event1;
+    manual_reset_event event2{ std::move(event1) };
+    ASSERT_FALSE(event1.valid());
+    ASSERT_TRUE(event2.valid());
+    ASSERT_THROW(event1.set(), std::logic_error);
+    ASSERT_THROW(event1.reset(), std::logic_error);
+    ASSERT_THROW(event1.get(), std::logic_error);
+    ASSERT_THROW(event1.wait(), std::logic_error);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// set() / reset()
+
+TEST(manual_reset_event, setAndResetCanBeRepeated)
+{
+    manual_reset_event event;
+    for (int i{ 0 }; i < 10; ++i)
+    {
+        event.set();
+        ASSERT_TRUE(event.get());
+        event.set();
+        ASSERT_TRUE(event);
+        event.reset();
+        ASSERT_FALSE(event.get());
+        event.reset();
+        ASSERT_FALSE(event);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// wait()
+
+TEST(manual_reset_event, waitReturnsImmediatelyIfEventIsSet)
+{
+    manual_reset_event event{ true };
+    event.wait();
+    ASSERT_TRUE(event.get());
+}
+
+TEST(manual_reset_event, waitReleasesEveryWaitingThread)
+{
+    manual_reset_event event;
+    std::vector<std::future<void>> tasks;
+    for (int i{ 0 }; i < 4; ++i)
+        tasks.push_back(std::async(std::launch::async, [](manual_reset_event_reader reader) { reader.wait(); }, event));
+
+    std::this_thread::sleep_for(150ms);
+    for (auto & task : tasks)
+        ASSERT_EQ(task.wait_for(0ms), std::future_status::timeout);
+    event.set();
+    for (auto & task : tasks)
+        ASSERT_EQ(task.wait_for(10s), std::future_status::ready);
+}
+
+TEST(manual_reset_event, waitReturnsIfEventIsSetAndResetImmediately)
+{
+    manual_reset_event event;
+    std::vector<std::future<void>> tasks;
+    for (int i{ 0 }; i < 4; ++i)
+        tasks.push_back(std::async(std::launch::async, [](manual_reset_event_reader reader) { reader.wait(); }, event));
+
+    std::this_thread::sleep_for(150ms);
+    event.set();
+    event.reset();
+    for (auto & task : tasks)
+        ASSERT_EQ(task.wait_for(10s), std::future_status::ready);
+    ASSERT_FALSE(event.get());
+}
+
+TEST(manual_reset_event, waitBlocksAgainAfterEventIsReset)
+{
+    manual_reset_event event{ true };
+    event.reset();
+    ASSERT_FALSE(event.wait_for(50ms));
+}
+
+TEST(manual_reset_event, eventsCanBeReusedForManyCycles)
+{
+    // The same three events are used for every hand-over between the two threads.
+    constexpr int cycles{ 1'000 };
+    manual_reset_event pulse;
+    manual_reset_event acknowledged;
+    manual_reset_event rearmed;
+    int count{ 0 };
+    auto worker{ std::async(std::launch::async, [&]
+    {
+        for (int i{ 0 }; i < cycles; ++i)
+        {
+            if (!pulse.wait_for(10s))
+                return;
+            ++count;
+            acknowledged.set();
+            if (!rearmed.wait_for(10s))
+                return;
+            rearmed.reset();
+        }
+    }) };
+
+    for (int i{ 0 }; i < cycles; ++i)
+    {
+        pulse.set();
+        ASSERT_TRUE(acknowledged.wait_for(10s));
+        acknowledged.reset();
+        pulse.reset();
+        rearmed.set();
+    }
+    worker.get();
+    ASSERT_EQ(count, cycles);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// wait_for() / wait_until()
+
+TEST(manual_reset_event, waitForReturnsFalseIfTimeoutExpires)
+{
+    manual_reset_event event;
+    const auto start{ now() };
+    ASSERT_FALSE(event.wait_for(100ms));
+    ASSERT_GE(now() - start, 100ms);
+}
+
+TEST(manual_reset_event, waitForReturnsTrueIfEventIsPulsedBeforeTimeout)
+{
+    manual_reset_event event;
+    auto task{ std::async(std::launch::async, [](manual_reset_event_reader reader)
+    {
+        return reader.wait_for(10s);
+    }, event) };
+
+    std::this_thread::sleep_for(150ms);
+    event.set();
+    event.reset();
+    ASSERT_TRUE(task.get());
+}
+
+TEST(manual_reset_event, waitUntilSupportsOtherClocks)
+{
+    manual_reset_event event;
+    ASSERT_FALSE(event.wait_until(std::chrono::system_clock::now() + 50ms));
+    event.set();
+    ASSERT_TRUE(event.wait_until(std::chrono::system_clock::now() + 50ms));
+}
@@ -0,0 +1,255 @@
+/**
+ * @file parallel.test.cpp
+ * @brief Defines unit tests for the cancellable parallel algorithms.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include "shared_flag/compact_shared_flag.hpp"
+#include "shared_flag/parallel.hpp"
+#include "shared_flag/shared_flag.hpp"
+#include <atomic>
+#include <functional>
+#include <future>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <numeric>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+using namespace prb;
+
+
+//--------------------------------------------------------------------------------------------------
+// parallel_for()
+
+TEST(parallel_for, callsTheFunctionOnceForEachIndex)
+{
+    constexpr std::size_t count{ 10000U };
+    thread_pool pool{ 4U };
+    const shared_flag cancel;
+    std::vector<std::atomic<int>> calls(count);
+    ASSERT_TRUE(parallel_for(pool, cancel, std::size_t{ 0U }, count, [&calls](std::size_t index)
+    {
+        ++calls[index];
+    }));
+    for (const auto & call : calls)
+        ASSERT_EQ(call, 1);
+}
+
+TEST(parallel_for, supportsNegativeSignedIndices)
+{
+    thread_pool pool{ 2U };
+    const shared_flag cancel;
+    std::atomic<int> total{ 0 };
+    std::atomic<int> calls{ 0 };
+    ASSERT_TRUE(parallel_for(pool, cancel, -50, 51, [&](int index)
+    {
+        total += index;
+        ++calls;
+    }));
+    ASSERT_EQ(total, 0);
+    ASSERT_EQ(calls, 101);
+}
+
+TEST(parallel_for, emptyRangeCompletesWithoutCallingTheFunction)
+{
+    thread_pool pool{ 2U };
+    const shared_flag cancel;
+    bool called{ false };
+    ASSERT_TRUE(parallel_for(pool, cancel, 5, 5, [&called](int) { called = true; }));
+    ASSERT_TRUE(parallel_for(pool, cancel, 5, 2, [&called](int) { called = true; }));
+    ASSERT_FALSE(called);
+}
+
+TEST(parallel_for, doesNothingIfTheFlagIsAlreadySet)
+{
+    thread_pool pool{ 2U };
+    shared_flag cancel;
+    cancel.set();
+    std::atomic<bool> called{ false };
+    ASSERT_FALSE(parallel_for(pool, cancel, 0, 1000, [&called](int) { called = true; }));
+    ASSERT_FALSE(called);
+    ASSERT_EQ(pool.discarded_count(), 0U);
+}
+
+TEST(parallel_for, stopsWithinAboutOneChunkOfTheFlagBeingSet)
+{
+    constexpr int count{ 100000 };
+    thread_pool pool{ 2U };
+    shared_flag cancel;
+    std::atomic<int> calls{ 0 };
+    parallel_options options;
+    options.chunk_duration = 1ms;
+
+    // Each call takes about 100us, so the flag is noticed after a handful of calls per thread.
+    const bool finished{ parallel_for(pool, cancel, 0, count, [&](int)
+    {
+        if (++calls == 100)
+            cancel.set();
+        std::this_thread::sleep_for(100us);
+    }, options) };
+
+    ASSERT_FALSE(finished);
+    ASSERT_GE(calls, 100);
+    ASSERT_LT(calls, 1000);
+}
+
+TEST(parallel_for, workIsSharedWithThePool)
+{
+    thread_pool pool{ 2U };
+    const shared_flag cancel;
+    std::mutex mtx;
+    std::set<std::thread::id> threads;
+    ASSERT_TRUE(parallel_for(pool, cancel, 0, 40, [&](int)
+    {
+        std::this_thread::sleep_for(2ms);
+        const std::lock_guard<std::mutex> lock{ mtx };
+        threads.insert(std::this_thread::get_id());
+    }));
+    ASSERT_GT(threads.size(), 1U);
+}
+
+TEST(parallel_for, canBeCalledFromInsideAPoolTask)
+{
+    // The only worker is busy running the outer task, so the calling thread does all the work.
+    thread_pool pool{ 1U };
+    const compact_shared_flag cancel;
+    std::promise<int> result;
+    auto future{ result.get_future() };
+    pool.submit([&]
+    {
+        std::atomic<int> calls{ 0 };
+        parallel_for(pool, cancel, 0, 1000, [&calls](int) { ++calls; });
+        result.set_value(calls);
+    });
+    ASSERT_EQ(future.wait_for(10s), std::future_status::ready);
+    ASSERT_EQ(future.get(), 1000);
+}
+
+TEST(parallel_for, completesIfThePoolHasBeenStopped)
+{
+    thread_pool pool{ 2U };
+    pool.stop();
+    const shared_flag cancel;
+    std::atomic<int> calls{ 0 };
+    ASSERT_TRUE(parallel_for(pool, cancel, 0, 1000, [&calls](int) { ++calls; }));
+    ASSERT_EQ(calls, 1000);
+}
+
+TEST(parallel_for, throwsIfTheFlagHasBeenMovedAway)
+{
+    thread_pool pool{ 1U };
+    shared_flag cancel;
+    shared_flag other{ std::move(cancel) };
+    ASSERT_THROW(parallel_for(pool, cancel, 0, 10, [](int) {}), std::logic_error);
+}
+
+TEST(parallel_for, exceptionFromTheFunctionTerminates)
+{
+    // The pool is created in the child process, as the threadsafe style re-runs the executable.
+    //  The previous style is restored afterwards, so other tests aren't affected.
+    const std::string previous_style{ ::testing::FLAGS_gtest_death_test_style };
+    ::testing::FLAGS_gtest_death_test_style = "threadsafe";
+    EXPECT_DEATH(
+        {
+            thread_pool pool{ 2U };
+            const shared_flag cancel;
+            parallel_for(pool, cancel, 0, 1000000, [](int) { throw std::runtime_error{ "failed" }; });
+        },
+        ""
+    );
+    ::testing::FLAGS_gtest_death_test_style = previous_style;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// parallel_transform_reduce()
+
+TEST(parallel_transform_reduce, combinesEveryElement)
+{
+    thread_pool pool{ 4U };
+    const shared_flag cancel;
+    std::vector<long long> values(100000);
+    std::iota(values.begin(), values.end(), 1LL);
+
+    const auto result{ parallel_transform_reduce(
+        pool,
+        cancel,
+        values.begin(),
+        values.end(),
+        10LL,
+        std::plus<>{},
+        [](long long value) { return value * 2; }
+    ) };
+    ASSERT_TRUE(result.has_value());
+    ASSERT_EQ(*result, 10LL + 100000LL * 100001LL);
+}
+
+TEST(parallel_transform_reduce, emptyRangeReturnsTheInitialValue)
+{
+    thread_pool pool{ 2U };
+    const shared_flag cancel;
+    const std::vector<int> values;
+    const auto result{
+        parallel_transform_reduce(pool, cancel, values.begin(), values.end(), 7, std::plus<>{}, [](int v) { return v; })
+    };
+    ASSERT_EQ(result, 7);
+}
+
+TEST(parallel_transform_reduce, worksWithValuesWhichAreNotDefaultConstructible)
+{
+    struct total
+    {
+        explicit total(int v) : value{ v } {}
+        int value;
+    };
+
+    thread_pool pool{ 2U };
+    const shared_flag cancel;
+    const std::vector<int> values(1000, 3);
+    const auto result{ parallel_transform_reduce(
+        pool,
+        cancel,
+        values.begin(),
+        values.end(),
+        total{ 0 },
+        [](total a, total b) { return total{ a.value + b.value }; },
+        [](int v) { return total{ v }; }
+    ) };
+    ASSERT_TRUE(result.has_value());
+    ASSERT_EQ(result->value, 3000);
+}
+
+TEST(parallel_transform_reduce, returnsNothingIfCancelled)
+{
+    thread_pool pool{ 2U };
+    shared_flag cancel;
+    const std::vector<std::string> values(100000, "x");
+    std::atomic<int> calls{ 0 };
+    parallel_options options;
+    options.chunk_duration = 1ms;
+
+    const auto result{ parallel_transform_reduce(
+        pool,
+        cancel,
+        values.begin(),
+        values.end(),
+        std::size_t{ 0U },
+        std::plus<>{},
+        [&](const std::string & value)
+        {
+            if (++calls == 100)
+                cancel.set();
+            std::this_thread::sleep_for(100us);
+            return value.size();
+        },
+        options
+    ) };
+    ASSERT_FALSE(result.has_value());
+    ASSERT_LT(calls, 1000);
+}
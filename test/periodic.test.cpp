@@ -0,0 +1,235 @@
+/**
+ * @file periodic.test.cpp
+ * @brief Defines unit tests for the periodic range.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include "shared_flag/compact_shared_flag.hpp"
+#include "shared_flag/periodic.hpp"
+#include "shared_flag/shared_flag.hpp"
+#include <future>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+using namespace prb;
+
+namespace
+{
+    // Short-hand alias to get the current steady clock time point.
+    constexpr auto now = std::chrono::steady_clock::now;
+
+    // Collect the first few ticks of a range, sleeping for a while in the loop body of each one.
+    std::vector<periodic_tick> collect_ticks(
+        periodic_range && range,
+        std::size_t count,
+        std::chrono::steady_clock::duration work = 0ms
+    )
+    {
+        std::vector<periodic_tick> result;
+        for (const auto & tick : range)
+        {
+            EXPECT_GE(now(), tick.scheduled);
+            result.push_back(tick);
+            if (result.size() == count)
+                break;
+            std::this_thread::sleep_for(work);
+        }
+        return result;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// periodic()
+
+TEST(periodic, throwsIfPeriodIsNotPositive)
+{
+    shared_flag flag;
+    ASSERT_THROW(periodic(flag, 0ms), std::invalid_argument);
+    ASSERT_THROW(periodic(flag, -1ms), std::invalid_argument);
+}
+
+TEST(periodic, throwsIfSlackIsNegative)
+{
+    shared_flag flag;
+    periodic_options options;
+    options.slack = -1ms;
+    ASSERT_THROW(periodic(flag, 10ms, options), std::invalid_argument);
+}
+
+TEST(periodic, throwsIfFlagHasBeenMovedAway)
+{
+    shared_flag flag1;
+    shared_flag flag2{ std::move(flag1) };
+    ASSERT_THROW(periodic(flag1, 10ms), std::logic_error);
+}
+
+TEST(periodic, acceptsAnyTypeOfHandle)
+{
+    compact_shared_flag flag;
+    compact_shared_flag_reader reader{ flag };
+    const auto ticks{ collect_ticks(periodic(reader, 5ms), 2U) };
+    ASSERT_EQ(ticks.size(), 2U);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// iteration
+
+TEST(periodic, rangeIsEmptyIfFlagIsAlreadySet)
+{
+    shared_flag flag;
+    flag.set();
+    auto range{ periodic(flag, 10ms) };
+    ASSERT_EQ(range.begin(), range.end());
+}
+
+TEST(periodic, ticksAreAlignedToWholePeriods)
+{
+    shared_flag flag;
+    const auto ticks{ collect_ticks(periodic(flag, 7ms), 3U) };
+    ASSERT_EQ(ticks.size(), 3U);
+    for (const auto & tick : ticks)
+        ASSERT_EQ(tick.scheduled.time_since_epoch() % 7ms, 0ms);
+}
+
+TEST(periodic, ticksDontDriftWhenTheBodyTakesTime)
+{
+    shared_flag flag;
+    const auto ticks{ collect_ticks(periodic(flag, 40ms), 4U, 10ms) };
+    ASSERT_EQ(ticks.size(), 4U);
+    for (std::size_t i{ 1U }; i < ticks.size(); ++i)
+    {
+        ASSERT_EQ(ticks[i].scheduled - ticks[i - 1U].scheduled, 40ms);
+        ASSERT_EQ(ticks[i].missed, 0U);
+    }
+}
+
+TEST(periodic, phaseOffsetsTheTicks)
+{
+    shared_flag flag;
+    periodic_options options;
+    options.phase = 3ms;
+    const auto ticks{ collect_ticks(periodic(flag, 10ms, options), 2U) };
+    ASSERT_EQ(ticks.size(), 2U);
+    for (const auto & tick : ticks)
+        ASSERT_EQ(tick.scheduled.time_since_epoch() % 10ms, 3ms);
+}
+
+TEST(periodic, rangesWithTheSamePeriodTickTogether)
+{
+    shared_flag flag;
+    const auto run{ [](shared_flag_reader reader) { return collect_ticks(periodic(reader, 50ms), 3U); } };
+    auto task1{ std::async(std::launch::async, run, flag) };
+    auto task2{ std::async(std::launch::async, run, flag) };
+    const auto ticks1{ task1.get() };
+    const auto ticks2{ task2.get() };
+    ASSERT_EQ(ticks1.size(), 3U);
+    ASSERT_EQ(ticks2.size(), 3U);
+
+    // The threads may start either side of a tick, but they share the ticks after that.
+    std::size_t shared{ 0U };
+    for (const auto & tick1 : ticks1)
+    {
+        for (const auto & tick2 : ticks2)
+            shared += (tick1.scheduled == tick2.scheduled) ? 1U : 0U;
+    }
+    ASSERT_GE(shared, 2U);
+}
+
+TEST(periodic, slackDelaysEachWakeUpToAMultipleOfTheSlack)
+{
+    shared_flag flag;
+    periodic_options options;
+    options.slack = 20ms;
+    for (const auto & tick : periodic(flag, 7ms, options))
+    {
+        const auto since_epoch{ tick.scheduled.time_since_epoch() };
+        const auto rounded{ tick.scheduled + (20ms - since_epoch % 20ms) % 20ms };
+        ASSERT_GE(now(), rounded);
+        break;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// missed ticks
+
+TEST(periodic, skipPolicySkipsTicksWhichWereMissed)
+{
+    shared_flag flag;
+    const auto range_start{ now() };
+    auto range{ periodic(flag, 20ms) };
+    auto it{ range.begin() };
+    const auto first{ it->scheduled };
+    std::this_thread::sleep_for(70ms);
+    const auto body_end{ now() };
+
+    ++it;
+    ASSERT_NE(it, range.end());
+    ASSERT_GE(it->missed, 2U);
+    ASSERT_GT(it->scheduled, body_end);
+    ASSERT_EQ(it->scheduled - first, 20ms * static_cast<int>(it->missed + 1U));
+    ASSERT_GT(first, range_start);
+}
+
+TEST(periodic, catchUpPolicyDeliversTicksWhichWereMissed)
+{
+    shared_flag flag;
+    periodic_options options;
+    options.missed_ticks = missed_tick_policy::catch_up;
+    auto range{ periodic(flag, 20ms, options) };
+    auto it{ range.begin() };
+    const auto first{ it->scheduled };
+    std::this_thread::sleep_for(70ms);
+
+    // At least three ticks are already due, so they're delivered without waiting.
+    for (int i{ 1 }; i <= 3; ++i)
+    {
+        ++it;
+        ASSERT_NE(it, range.end());
+        ASSERT_EQ(it->scheduled, first + 20ms * i);
+        ASSERT_EQ(it->missed, 0U);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// stopping
+
+TEST(periodic, iterationStopsWhenFlagIsSetDuringTheBody)
+{
+    shared_flag flag;
+    int count{ 0 };
+    for (const auto & tick : periodic(flag, 5ms))
+    {
+        static_cast<void>(tick);
+        if (++count == 3)
+            flag.set();
+    }
+    ASSERT_EQ(count, 3);
+}
+
+TEST(periodic, settingFlagInterruptsTheWaitForTheNextTick)
+{
+    shared_flag flag;
+    auto task{ std::async(std::launch::async, [](shared_flag_reader reader)
+    {
+        int count{ 0 };
+        for (const auto & tick : periodic(reader, 24h))
+        {
+            static_cast<void>(tick);
+            ++count;
+        }
+        return count;
+    }, flag) };
+
+    std::this_thread::sleep_for(150ms);
+    ASSERT_EQ(task.wait_for(0ms), std::future_status::timeout);
+    flag.set();
+    ASSERT_EQ(task.wait_for(10s), std::future_status::ready);
+    ASSERT_EQ(task.get(), 0);
+}
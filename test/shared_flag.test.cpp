@@ -5,10 +5,18 @@
  * @copyright MIT License
  */
 
+#include "shared_flag/compact_shared_flag.hpp"
+#include "shared_flag/flag_callback.hpp"
 #include "shared_flag/shared_flag.hpp"
+#include <atomic>
 #include <future>
 #include <gtest/gtest.h>
+#include <list>
+#include <optional>
+#include <system_error>
 #include <thread>
+#include <type_traits>
+#include <vector>
 
 using namespace std::literals;
 using namespace prb;
@@ -17,6 +25,9 @@ namespace
 {
     // Short-hand alias to get the current steady clock time point.
     constexpr auto now = std::chrono::steady_clock::now;
+
+    // An example of a reason which can be passed to set().
+    enum class stop_reason { shutdown, deadline, error };
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -31,6 +42,173 @@ TEST(shared_flag, defaultConstructorCreatesAnIndependentInstance)
 }
 
 
+//--------------------------------------------------------------------------------------------------
+// spin policy constructor
+
+TEST(shared_flag, spinPolicyConstructorCreatesAnIndependentInstance)
+{
+    shared_flag flag1{ spin_policy{ 100, 10 } };
+    shared_flag flag2{ spin_policy{ 100, 10 } };
+    flag1.set();
+    ASSERT_FALSE(flag2.get());
+}
+
+TEST(shared_flag, spinPolicyConstructorAppliesPolicyToWaitsWhichDoNotSpecifyOne)
+{
+    shared_flag flag{ spin_policy{ 1000000, 1000 } };
+    auto function{ [](shared_flag_reader reader) { return reader.wait_for(2s); } };
+    auto task{ std::async(std::launch::async, function, flag) };
+
+    std::this_thread::sleep_for(50ms);
+    flag.set();
+    ASSERT_TRUE(task.get());
+}
+
+TEST(shared_flag, spinPolicyConstructorDoesNotMakeWaitsSpinBeyondTheirTimeout)
+{
+    shared_flag flag{ spin_policy{ 0xFFFFFFFF, 0xFFFFFFFF } };
+    const auto start{ now() };
+    ASSERT_FALSE(flag.wait_for(10ms));
+    ASSERT_LT(now() - start, 1s);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// child constructor
+
+TEST(shared_flag, childConstructorCreatesAFlagWhichIsNotSetInitially)
+{
+    shared_flag parent;
+    shared_flag child{ child_of, parent };
+    ASSERT_FALSE(child.get());
+}
+
+TEST(shared_flag, childConstructorCreatesAnIndependentInstance)
+{
+    shared_flag parent;
+    shared_flag child{ child_of, parent };
+    child.set();
+    ASSERT_FALSE(parent.get());
+}
+
+TEST(shared_flag, childIsSetWhenParentIsSet)
+{
+    shared_flag parent;
+    shared_flag child{ child_of, shared_flag_reader{ parent } };
+    parent.set();
+    ASSERT_TRUE(child.get());
+}
+
+TEST(shared_flag, childIsSetWhenAnyOfItsParentsIsSet)
+{
+    shared_flag parent1;
+    shared_flag parent2;
+    compact_shared_flag parent3;
+    shared_flag child{ child_of, parent1, parent2, parent3 };
+    parent2.set();
+    ASSERT_TRUE(child.get());
+    ASSERT_FALSE(parent1.get());
+    ASSERT_FALSE(parent3.get());
+}
+
+TEST(shared_flag, childIsSetImmediatelyIfAParentWasAlreadySet)
+{
+    shared_flag parent1;
+    shared_flag parent2;
+    parent2.set();
+    shared_flag child{ child_of, parent1, parent2 };
+    ASSERT_TRUE(child.get());
+}
+
+TEST(shared_flag, allDescendantsAreSetWhenAncestorIsSet)
+{
+    shared_flag process;
+    shared_flag subsystem{ child_of, process };
+    shared_flag session1{ child_of, subsystem };
+    shared_flag session2{ child_of, subsystem };
+    shared_flag request{ child_of, session2 };
+    process.set();
+    ASSERT_TRUE(subsystem.get());
+    ASSERT_TRUE(session1.get());
+    ASSERT_TRUE(session2.get());
+    ASSERT_TRUE(request.get());
+}
+
+TEST(shared_flag, descendantsAreSetBeforeParentSetReturns)
+{
+    shared_flag parent;
+    shared_flag child{ child_of, parent };
+    shared_flag grandchild{ child_of, child };
+    bool called{ false };
+    flag_callback callback{ grandchild, [&] { called = true; } };
+    parent.set();
+    ASSERT_TRUE(called);
+}
+
+TEST(shared_flag, childWakesThreadsWaitingOnItWhenParentIsSet)
+{
+    shared_flag parent;
+    shared_flag child{ child_of, parent };
+    auto waiter{ std::async(std::launch::async, [reader = shared_flag_reader{ child }] {
+        return reader.wait_for(10s);
+    }) };
+    std::this_thread::sleep_for(150ms);
+    parent.set();
+    ASSERT_TRUE(waiter.get());
+}
+
+TEST(shared_flag, childCanOutliveAllHandlesToItsParent)
+{
+    std::optional<shared_flag> parent{ std::in_place };
+    shared_flag child{ child_of, *parent };
+    parent.reset();
+    ASSERT_FALSE(child.get());
+    child.set();
+    ASSERT_TRUE(child.get());
+}
+
+TEST(shared_flag, destroyedChildrenAreDeregisteredFromParent)
+{
+    shared_flag parent;
+    for (int i{ 0 }; i < 1000; ++i)
+    {
+        shared_flag child{ child_of, parent };
+    }
+    shared_flag child{ child_of, parent };
+    parent.set();
+    ASSERT_TRUE(child.get());
+}
+
+TEST(shared_flag, childrenCanBeCreatedAndDestroyedWhileParentIsBeingSet)
+{
+    for (int i{ 0 }; i < 50; ++i)
+    {
+        shared_flag parent;
+        std::list<shared_flag> children;
+        for (int j{ 0 }; j < 10; ++j)
+            children.emplace_back(child_of, parent);
+
+        auto setter{ std::async(std::launch::async, [&] { parent.set(); }) };
+        for (int j{ 0 }; j < 10; ++j)
+        {
+            children.pop_front();
+            children.emplace_back(child_of, parent);
+        }
+        setter.get();
+
+        for (const auto & child : children)
+            ASSERT_TRUE(child.get());
+    }
+}
+
+TEST(shared_flag, childConstructorThrowsLogicErrorIfParentHasNoSharedState)
+{
+    shared_flag parent1;
+    shared_flag parent2{ std::move(parent1) };
+    ASSERT_THROW((shared_flag{ child_of, parent2, parent1 }), std::logic_error);
+}
+
+
 //--------------------------------------------------------------------------------------------------
 // copy constructor
 
@@ -91,11 +269,17 @@ TEST(shared_flag, moveConstructorRemovesSharedStateReferenceFromSource)
     ASSERT_FALSE(flag1.valid());
 }
 
-TEST(shared_flag, moveConstructorThrowsLogicErrorIfSourceHasNoSharedState)
+TEST(shared_flag, moveConstructorLeavesDestinationWithoutSharedStateIfSourceHasNone)
 {
     shared_flag flag1;
     shared_flag flag2{ std::move(flag1) };
-    ASSERT_THROW(shared_flag{ std::move(flag1) }, std::logic_error);
+    shared_flag flag3{ std::move(flag1) };
+    ASSERT_FALSE(flag3.valid());
+}
+
+TEST(shared_flag, moveConstructorIsNoexcept)
+{
+    ASSERT_TRUE(std::is_nothrow_move_constructible_v<shared_flag>);
 }
 
 
@@ -119,12 +303,35 @@ TEST(shared_flag, moveAssignmentRemovesSharedStateReferenceFromSource)
     ASSERT_FALSE(flag1.valid());
 }
 
-TEST(shared_flag, moveAssignmentThrowsLogicErrorIfSourceHasNoSharedState)
+TEST(shared_flag, moveAssignmentLeavesDestinationWithoutSharedStateIfSourceHasNone)
 {
     shared_flag flag1;
     shared_flag flag2{ std::move(flag1) };
     shared_flag flag3;
-    ASSERT_THROW(flag3 = std::move(flag1), std::logic_error);
+    flag3 = std::move(flag1);
+    ASSERT_FALSE(flag3.valid());
+}
+
+TEST(shared_flag, moveAssignmentIsNoexcept)
+{
+    ASSERT_TRUE(std::is_nothrow_move_assignable_v<shared_flag>);
+}
+
+TEST(shared_flag, moveAssignmentDoesNotBlockWhileAnotherThreadIsWaitingOnTheDestination)
+{
+    shared_flag flag1;
+    shared_flag original{ flag1 };
+    auto function{ [&]() { flag1.wait(); } };
+    auto task{ std::async(std::launch::async, function) };
+
+    std::this_thread::sleep_for(50ms);
+    flag1 = shared_flag{};
+    ASSERT_EQ(task.wait_for(0ms), std::future_status::timeout);
+
+    // The waiting thread is still waiting on the original flag.
+    original.set();
+    task.wait();
+    ASSERT_FALSE(flag1.get());
 }
 
 
@@ -173,6 +380,148 @@ TEST(shared_flag, setThrowsLogicErrorIfSharedStateHasBeenMovedAway)
 }
 
 
+//--------------------------------------------------------------------------------------------------
+// set(reason) / reason()
+
+TEST(shared_flag, setWithReasonSetsTheFlag)
+{
+    shared_flag flag;
+    shared_flag_reader reader{ flag };
+    flag.set(stop_reason::deadline);
+    ASSERT_TRUE(reader.get());
+    ASSERT_EQ(reader.reason<stop_reason>(), stop_reason::deadline);
+}
+
+TEST(shared_flag, reasonIsEmptyIfFlagHasNotBeenSet)
+{
+    shared_flag flag;
+    ASSERT_EQ(flag.reason<stop_reason>(), std::nullopt);
+}
+
+TEST(shared_flag, reasonIsEmptyIfFlagWasSetWithoutOne)
+{
+    shared_flag flag;
+    flag.set();
+    ASSERT_EQ(flag.reason<stop_reason>(), std::nullopt);
+}
+
+TEST(shared_flag, firstReasonIsKept)
+{
+    shared_flag flag;
+    flag.set(stop_reason::error);
+    flag.set(stop_reason::shutdown);
+    ASSERT_EQ(flag.reason<stop_reason>(), stop_reason::error);
+}
+
+TEST(shared_flag, reasonIsIgnoredIfFlagWasAlreadySetWithoutOne)
+{
+    shared_flag flag;
+    flag.set();
+    flag.set(stop_reason::error);
+    ASSERT_EQ(flag.reason<stop_reason>(), std::nullopt);
+}
+
+TEST(shared_flag, reasonCannotBeReadAsAnotherType)
+{
+    shared_flag flag;
+    flag.set(2);
+    ASSERT_EQ(flag.reason<stop_reason>(), std::nullopt);
+    ASSERT_EQ(flag.reason<unsigned int>(), std::nullopt);
+    ASSERT_EQ(flag.reason<int>(), 2);
+}
+
+TEST(shared_flag, reasonCanBeAnErrorCode)
+{
+    shared_flag flag;
+    const auto error{ std::make_error_code(std::errc::timed_out) };
+    flag.set(error);
+    ASSERT_EQ(flag.reason<std::error_code>(), error);
+}
+
+TEST(shared_flag, reasonCanBeASmallStruct)
+{
+    struct details
+    {
+        std::uint32_t code;
+        std::uint32_t source;
+        std::uint64_t timestamp;
+    };
+    shared_flag flag;
+    flag.set(details{ 3U, 7U, 12345U });
+    const auto result{ flag.reason<details>() };
+    ASSERT_TRUE(result.has_value());
+    ASSERT_EQ(result->code, 3U);
+    ASSERT_EQ(result->source, 7U);
+    ASSERT_EQ(result->timestamp, 12345U);
+}
+
+TEST(shared_flag, reasonIsAvailableToWaitingThreads)
+{
+    shared_flag flag;
+    auto task{ std::async(std::launch::async, [](shared_flag_reader reader)
+    {
+        reader.wait();
+        return reader.reason<stop_reason>();
+    }, flag) };
+
+    std::this_thread::sleep_for(150ms);
+    flag.set(stop_reason::shutdown);
+    ASSERT_EQ(task.get(), stop_reason::shutdown);
+}
+
+TEST(shared_flag, concurrentSettersAgreeOnOneReason)
+{
+    // Every setter must see the flag set when it returns, along with the winning reason.
+    constexpr int setters{ 8 };
+    shared_flag flag;
+    std::vector<std::future<std::optional<int>>> tasks;
+    for (int i{ 0 }; i < setters; ++i)
+    {
+        tasks.push_back(std::async(std::launch::async, [i](shared_flag copy)
+        {
+            copy.set(i);
+            return copy.reason<int>();
+        }, flag));
+    }
+
+    std::vector<std::optional<int>> seen;
+    for (auto & task : tasks)
+        seen.push_back(task.get());
+
+    const auto winner{ flag.reason<int>() };
+    ASSERT_TRUE(winner.has_value());
+    for (const auto & reason : seen)
+        ASSERT_EQ(reason, winner);
+}
+
+TEST(shared_flag, childFlagInheritsReasonFromParent)
+{
+    shared_flag parent;
+    shared_flag child{ child_of, parent };
+    shared_flag grandchild{ child_of, child };
+    parent.set(stop_reason::deadline);
+    ASSERT_EQ(child.reason<stop_reason>(), stop_reason::deadline);
+    ASSERT_EQ(grandchild.reason<stop_reason>(), stop_reason::deadline);
+}
+
+TEST(shared_flag, childFlagKeepsItsOwnReasonIfSetFirst)
+{
+    shared_flag parent;
+    shared_flag child{ child_of, parent };
+    child.set(stop_reason::error);
+    parent.set(stop_reason::shutdown);
+    ASSERT_EQ(child.reason<stop_reason>(), stop_reason::error);
+}
+
+TEST(shared_flag, reasonThrowsLogicErrorIfSharedStateHasBeenMovedAway)
+{
+    shared_flag flag1;
+    shared_flag flag2{ std::move(flag1) };
+    ASSERT_THROW(flag1.set(stop_reason::error), std::logic_error);
+    ASSERT_THROW(flag1.reason<stop_reason>(), std::logic_error);
+}
+
+
 //--------------------------------------------------------------------------------------------------
 // valid()
 
@@ -423,6 +772,17 @@ TEST(shared_flag, waitUntilReturnsTrueIfFlagWasAlreadySet)
     ASSERT_TRUE(flag.wait_until(now() + 10ms));
 }
 
+TEST(shared_flag, waitUntilReturnsWithoutBlockingIfDeadlineHasPassed)
+{
+    // Blocking would cost at least the kernel's timer slack each time, which is about 50us.
+    constexpr int count{ 1000 };
+    const shared_flag flag;
+    const auto start{ now() };
+    for (int i{ 0 }; i < count; ++i)
+        ASSERT_FALSE(flag.wait_until(now() - 1s));
+    ASSERT_LT(now() - start, 25ms);
+}
+
 TEST(shared_flag, waitUntilReturnsTrueIfFlagWasSetViaTheSameInstanceWhileWaiting)
 {
     shared_flag flag;
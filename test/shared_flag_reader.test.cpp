@@ -9,12 +9,29 @@
 #include <future>
 #include <gtest/gtest.h>
 #include <thread>
+#include <type_traits>
+
+#if defined(__linux__)
+#   include <fcntl.h>
+#   include <poll.h>
+#   include <sys/epoll.h>
+#   include <unistd.h>
+#endif
 
 using namespace std::literals;
 using namespace prb;
 
 namespace
 {
+#if defined(__linux__)
+    // Check if a file descriptor becomes readable within a timeout.
+    bool is_readable(int fd, std::chrono::milliseconds timeout)
+    {
+        pollfd entry{ fd, POLLIN, 0 };
+        return poll(&entry, 1, static_cast<int>(timeout.count())) == 1 && (entry.revents & POLLIN) != 0;
+    }
+#endif
+
     // Short-hand alias to get the current steady clock time point.
     constexpr auto now = std::chrono::steady_clock::now;
 }
@@ -70,6 +87,26 @@ TEST(shared_flag_reader, copyAssignmentCopiesReferenceToExistingSharedStateInsha
     ASSERT_TRUE(reader2.get());
 }
 
+TEST(shared_flag_reader, copyAssignmentDoesNotBlockWhileAnotherThreadIsWaitingOnTheDestination)
+{
+    shared_flag flag1;
+    shared_flag flag2;
+    shared_flag_reader reader{ flag1 };
+    auto function{ [&]() { reader.wait(); } };
+    auto task{ std::async(std::launch::async, function) };
+
+    std::this_thread::sleep_for(50ms);
+    reader = flag2;
+    ASSERT_EQ(task.wait_for(0ms), std::future_status::timeout);
+
+    // The waiting thread is still waiting on the flag it started with.
+    flag2.set();
+    ASSERT_EQ(task.wait_for(50ms), std::future_status::timeout);
+    flag1.set();
+    task.wait();
+    SUCCEED();
+}
+
 TEST(shared_flag_reader, copyAssignmentThrowsLogicErrorIfSourceHasNoSharedState)
 {
     shared_flag flag1;
@@ -99,11 +136,17 @@ TEST(shared_flag_reader, moveConstructorRemovesSharedStateReferenceFromSource)
     ASSERT_FALSE(reader1.valid());
 }
 
-TEST(shared_flag_reader, moveConstructorThrowsLogicErrorIfSourceHasNoSharedState)
+TEST(shared_flag_reader, moveConstructorLeavesDestinationWithoutSharedStateIfSourceHasNone)
 {
     shared_flag flag1;
     shared_flag flag2{ std::move(flag1) };
-    ASSERT_THROW(shared_flag_reader{ std::move(flag1) }, std::logic_error);
+    shared_flag_reader reader{ std::move(flag1) };
+    ASSERT_FALSE(reader.valid());
+}
+
+TEST(shared_flag_reader, moveConstructorIsNoexcept)
+{
+    ASSERT_TRUE(std::is_nothrow_move_constructible_v<shared_flag_reader>);
 }
 
 
@@ -129,12 +172,18 @@ TEST(shared_flag_reader, moveAssignmentRemovesSharedStateReferenceFromSource)
     ASSERT_FALSE(reader1.valid());
 }
 
-TEST(shared_flag_reader, moveAssignmentThrowsLogicErrorIfSourceHasNoSharedState)
+TEST(shared_flag_reader, moveAssignmentLeavesDestinationWithoutSharedStateIfSourceHasNone)
 {
     shared_flag flag1;
     shared_flag flag2{ std::move(flag1) };
     shared_flag_reader reader{ shared_flag{} };
-    ASSERT_THROW(reader = std::move(flag1), std::logic_error);
+    reader = std::move(flag1);
+    ASSERT_FALSE(reader.valid());
+}
+
+TEST(shared_flag_reader, moveAssignmentIsNoexcept)
+{
+    ASSERT_TRUE(std::is_nothrow_move_assignable_v<shared_flag_reader>);
 }
 
 
@@ -192,6 +241,19 @@ TEST(shared_flag_reader, getReturnsTrueIfFlagHasBeenSet)
     ASSERT_TRUE(reader.get());
 }
 
+TEST(shared_flag_reader, getObservesFlagSetByAnotherThreadWhilePolling)
+{
+    shared_flag flag;
+    auto function{ [](shared_flag_reader reader) { while (!reader.get()) {} return true; } };
+    auto task1{ std::async(std::launch::async, function, flag) };
+    auto task2{ std::async(std::launch::async, function, flag) };
+
+    std::this_thread::sleep_for(50ms);
+    flag.set();
+    ASSERT_TRUE(task1.get());
+    ASSERT_TRUE(task2.get());
+}
+
 TEST(shared_flag_reader, getThrowsLogicErrorIfSharedStateHasBeenMovedAway)
 {
     shared_flag flag;
@@ -238,6 +300,104 @@ TEST(shared_flag_reader, operatorBoolThrowsLogicErrorIfSharedStateHasBeenMovedAw
 #endif
 
 
+#if defined(__linux__)
+//--------------------------------------------------------------------------------------------------
+// native_handle()
+
+TEST(shared_flag_reader, nativeHandleIsNotReadableIfFlagHasNotBeenSet)
+{
+    shared_flag flag;
+    shared_flag_reader reader{ flag };
+    ASSERT_FALSE(is_readable(reader.native_handle(), 0ms));
+}
+
+TEST(shared_flag_reader, nativeHandleBecomesReadableWhenFlagIsSet)
+{
+    shared_flag flag;
+    shared_flag_reader reader{ flag };
+    const auto fd{ reader.native_handle() };
+    flag.set();
+    ASSERT_TRUE(is_readable(fd, 0ms));
+    ASSERT_TRUE(is_readable(fd, 0ms));
+}
+
+TEST(shared_flag_reader, nativeHandleIsReadableImmediatelyIfFlagWasAlreadySet)
+{
+    shared_flag flag;
+    flag.set();
+    shared_flag_reader reader{ flag };
+    ASSERT_TRUE(is_readable(reader.native_handle(), 0ms));
+}
+
+TEST(shared_flag_reader, nativeHandleWakesPollWhenFlagIsSetByAnotherThread)
+{
+    shared_flag flag;
+    shared_flag_reader reader{ flag };
+    const auto fd{ reader.native_handle() };
+    auto setter{ std::async(std::launch::async, [&flag] {
+        std::this_thread::sleep_for(150ms);
+        flag.set();
+    }) };
+    ASSERT_TRUE(is_readable(fd, 10s));
+    setter.get();
+}
+
+TEST(shared_flag_reader, nativeHandleCanBeWatchedByEpoll)
+{
+    shared_flag flag;
+    shared_flag_reader reader{ flag };
+    const auto epoll{ epoll_create1(EPOLL_CLOEXEC) };
+    ASSERT_NE(epoll, -1);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    ASSERT_EQ(epoll_ctl(epoll, EPOLL_CTL_ADD, reader.native_handle(), &event), 0);
+
+    ASSERT_EQ(epoll_wait(epoll, &event, 1, 0), 0);
+    flag.set();
+    ASSERT_EQ(epoll_wait(epoll, &event, 1, 1000), 1);
+    close(epoll);
+}
+
+TEST(shared_flag_reader, nativeHandleIsSharedByAllInstancesReferringToTheSameSharedState)
+{
+    shared_flag flag;
+    shared_flag_reader reader1{ flag };
+    shared_flag_reader reader2{ flag };
+    ASSERT_EQ(reader1.native_handle(), reader2.native_handle());
+    ASSERT_EQ(reader1.native_handle(), flag.native_handle());
+}
+
+TEST(shared_flag_reader, nativeHandleBecomesReadableWhenParentIsSet)
+{
+    shared_flag parent;
+    shared_flag child{ child_of, parent };
+    const shared_flag_reader reader{ child };
+    const auto fd{ reader.native_handle() };
+    parent.set();
+    ASSERT_TRUE(is_readable(fd, 0ms));
+}
+
+TEST(shared_flag_reader, nativeHandleIsClosedWhenSharedStateIsDestroyed)
+{
+    int fd{ -1 };
+    {
+        shared_flag flag;
+        fd = flag.native_handle();
+        ASSERT_NE(fcntl(fd, F_GETFD), -1);
+    }
+    ASSERT_EQ(fcntl(fd, F_GETFD), -1);
+}
+
+TEST(shared_flag_reader, nativeHandleThrowsLogicErrorIfSharedStateHasBeenMovedAway)
+{
+    shared_flag flag;
+    shared_flag_reader reader1{ flag };
+    shared_flag_reader reader2{ std::move(reader1) };
+    ASSERT_THROW(reader1.native_handle(), std::logic_error);
+}
+#endif
+
+
 //--------------------------------------------------------------------------------------------------
 // wait()
 
@@ -299,6 +459,39 @@ TEST(shared_flag_reader, waitSupportsMultipleThreadsWaitingOnTheSameFlagViaDiffe
     SUCCEED();
 }
 
+TEST(shared_flag_reader, waitWithSpinPolicyReturnsImmediatelyIfFlagWasAlreadySet)
+{
+    shared_flag flag;
+    shared_flag_reader reader{ flag };
+    flag.set();
+    reader.wait(spin_policy{ 100, 10 });
+    SUCCEED();
+}
+
+TEST(shared_flag_reader, waitWithSpinPolicyReturnsIfFlagWasSetWhileSpinning)
+{
+    shared_flag flag;
+    auto function{ [&](shared_flag_reader reader) { reader.wait(spin_policy{ 0xFFFFFFFF, 0 }); } };
+    auto task{ std::async(std::launch::async, function, flag) };
+
+    std::this_thread::sleep_for(50ms);
+    flag.set();
+    task.wait();
+    SUCCEED();
+}
+
+TEST(shared_flag_reader, waitWithSpinPolicyReturnsIfFlagWasSetAfterSpinningAndYielding)
+{
+    shared_flag flag;
+    auto function{ [&](shared_flag_reader reader) { reader.wait(spin_policy{ 10, 10 }); } };
+    auto task{ std::async(std::launch::async, function, flag) };
+
+    std::this_thread::sleep_for(150ms);
+    flag.set();
+    task.wait();
+    SUCCEED();
+}
+
 TEST(shared_flag_reader, waitThrowsLogicErrorIfSharedStateWasMovedAway)
 {
     shared_flag flag;
@@ -373,6 +566,45 @@ TEST(shared_flag_reader, waitForSupportsMultipleThreadsWaitingOnTheSameFlagViaDi
     ASSERT_TRUE(task3.get());
 }
 
+TEST(shared_flag_reader, waitForReturnsFalseImmediatelyIfTimeoutIsNotPositive)
+{
+    shared_flag flag;
+    shared_flag_reader reader{ flag };
+    ASSERT_FALSE(reader.wait_for(0ms));
+    ASSERT_FALSE(reader.wait_for(-1s));
+}
+
+TEST(shared_flag_reader, waitForSupportsTimeoutsTooLongToRepresentAsADeadline)
+{
+    shared_flag flag;
+    auto function{ [](shared_flag_reader reader) { return reader.wait_for(std::chrono::hours::max()); } };
+    auto task{ std::async(std::launch::async, function, flag) };
+
+    std::this_thread::sleep_for(150ms);
+    flag.set();
+    ASSERT_TRUE(task.get());
+}
+
+TEST(shared_flag_reader, waitForWithSpinPolicyReturnsTrueIfFlagWasSetWhileSpinning)
+{
+    shared_flag flag;
+    auto function{ [](shared_flag_reader reader) { return reader.wait_for(2s, spin_policy{ 0xFFFFFFFF, 0 }); } };
+    auto task{ std::async(std::launch::async, function, flag) };
+
+    std::this_thread::sleep_for(50ms);
+    flag.set();
+    ASSERT_TRUE(task.get());
+}
+
+TEST(shared_flag_reader, waitForWithSpinPolicyDoesNotSpinBeyondTheTimeout)
+{
+    shared_flag flag;
+    shared_flag_reader reader{ flag };
+    const auto start{ now() };
+    ASSERT_FALSE(reader.wait_for(10ms, spin_policy{ 0xFFFFFFFF, 0xFFFFFFFF }));
+    ASSERT_LT(now() - start, 1s);
+}
+
 TEST(shared_flag_reader, waitForThrowsLogicErrorIfSharedStateWasMovedAway)
 {
     shared_flag flag;
@@ -446,6 +678,52 @@ TEST(shared_flag_reader, waitUntilSupportsMultipleThreadsWaitingOnTheSameFlagVia
     ASSERT_TRUE(task3.get());
 }
 
+TEST(shared_flag_reader, waitUntilSupportsClocksOtherThanTheSteadyClock)
+{
+    shared_flag flag;
+    shared_flag_reader reader{ flag };
+    ASSERT_FALSE(reader.wait_until(std::chrono::system_clock::now() + 10ms));
+
+    auto function{ [](shared_flag_reader reader) { return reader.wait_until(std::chrono::system_clock::now() + 2s); } };
+    auto task{ std::async(std::launch::async, function, flag) };
+
+    std::this_thread::sleep_for(150ms);
+    flag.set();
+    ASSERT_TRUE(task.get());
+}
+
+TEST(shared_flag_reader, waitUntilSupportsTimePointsTooFarAwayToRepresentAsADeadline)
+{
+    shared_flag flag;
+    const auto timeout_time{ std::chrono::time_point<std::chrono::steady_clock, std::chrono::hours>::max() };
+    auto function{ [timeout_time](shared_flag_reader reader) { return reader.wait_until(timeout_time); } };
+    auto task{ std::async(std::launch::async, function, flag) };
+
+    std::this_thread::sleep_for(150ms);
+    flag.set();
+    ASSERT_TRUE(task.get());
+}
+
+TEST(shared_flag_reader, waitUntilWithSpinPolicyReturnsTrueIfFlagWasSetWhileSpinning)
+{
+    shared_flag flag;
+    auto function{ [](shared_flag_reader reader) { return reader.wait_until(now() + 2s, spin_policy{ 0xFFFFFFFF, 0 }); } };
+    auto task{ std::async(std::launch::async, function, flag) };
+
+    std::this_thread::sleep_for(50ms);
+    flag.set();
+    ASSERT_TRUE(task.get());
+}
+
+TEST(shared_flag_reader, waitUntilWithSpinPolicyDoesNotSpinBeyondTheTimeout)
+{
+    shared_flag flag;
+    shared_flag_reader reader{ flag };
+    const auto start{ now() };
+    ASSERT_FALSE(reader.wait_until(now() + 10ms, spin_policy{ 0xFFFFFFFF, 0xFFFFFFFF }));
+    ASSERT_LT(now() - start, 1s);
+}
+
 TEST(shared_flag_reader, waitUntilThrowsLogicErrorIfSharedStateWasMovedAway)
 {
     shared_flag flag;
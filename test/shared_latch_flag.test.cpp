@@ -0,0 +1,193 @@
+/**
+ * @file shared_latch_flag.test.cpp
+ * @brief Defines unit tests for the shared_latch_flag class.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include "shared_flag/shared_flag.hpp"
+#include "shared_flag/shared_latch_flag.hpp"
+#include "shared_flag/wait_multiple.hpp"
+#include <future>
+#include <gtest/gtest.h>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace std::literals;
+using namespace prb;
+
+
+//--------------------------------------------------------------------------------------------------
+// type properties
+
+TEST(shared_latch_flag, readerCannotBePromotedToALatch)
+{
+    ASSERT_FALSE((std::is_constructible_v<shared_latch_flag, const shared_flag_reader &>));
+    ASSERT_FALSE((std::is_assignable_v<shared_latch_flag &, const shared_flag_reader &>));
+}
+
+TEST(shared_latch_flag, latchCannotBeConvertedToAWritableFlag)
+{
+    ASSERT_FALSE((std::is_constructible_v<shared_flag, const shared_latch_flag &>));
+    ASSERT_TRUE((std::is_constructible_v<shared_flag_reader, const shared_latch_flag &>));
+}
+
+TEST(shared_latch_flag, countIsHeldInTheSharedState)
+{
+    ASSERT_EQ(sizeof(shared_latch_flag), sizeof(shared_flag_reader));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// constructor
+
+TEST(shared_latch_flag, flagIsNotSetIfCountIsPositive)
+{
+    shared_latch_flag latch{ 2 };
+    ASSERT_TRUE(latch.valid());
+    ASSERT_FALSE(latch.get());
+    ASSERT_EQ(latch.remaining(), 2);
+}
+
+TEST(shared_latch_flag, flagIsSetStraightAwayIfCountIsZero)
+{
+    shared_latch_flag latch{ 0 };
+    ASSERT_TRUE(latch.get());
+    ASSERT_EQ(latch.remaining(), 0);
+}
+
+TEST(shared_latch_flag, constructorThrowsIfCountIsNegative)
+{
+    ASSERT_THROW(shared_latch_flag{ -1 }, std::invalid_argument);
+}
+
+TEST(shared_latch_flag, constructorAcceptsASpinPolicy)
+{
+    shared_latch_flag latch{ 1, spin_policy{ 100, 10 } };
+    ASSERT_FALSE(latch.wait_for(10ms));
+    latch.count_down();
+    ASSERT_TRUE(latch.wait_for(10ms));
+}
+
+TEST(shared_latch_flag, copiesShareTheCount)
+{
+    shared_latch_flag latch1{ 2 };
+    shared_latch_flag latch2{ latch1 };
+    latch1.count_down();
+    ASSERT_EQ(latch2.remaining(), 1);
+    latch2.count_down();
+    ASSERT_TRUE(latch1.get());
+}
+
+TEST(shared_latch_flag, assignmentSharesTheOtherLatchsCount)
+{
+    shared_latch_flag latch1{ 1 };
+    shared_latch_flag latch2{ 3 };
+    latch2 = latch1;
+    ASSERT_EQ(latch2.remaining(), 1);
+    latch2.count_down();
+    ASSERT_TRUE(latch1.get());
+}
+
+TEST(shared_latch_flag, moveConstructorRemovesReferencesFromSource)
+{
+    shared_latch_flag latch1{ 1 };
+    shared_latch_flag latch2{ std::move(latch1) };
+    ASSERT_FALSE(latch1.valid());
+    ASSERT_THROW(latch1.count_down(), std::logic_error);
+    ASSERT_THROW(latch1.remaining(), std::logic_error);
+    latch2.count_down();
+    ASSERT_TRUE(latch2.get());
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// count_down()
+
+TEST(shared_latch_flag, flagIsSetWhenCountReachesZero)
+{
+    shared_latch_flag latch{ 3 };
+    latch.count_down();
+    latch.count_down();
+    ASSERT_FALSE(latch.get());
+    ASSERT_EQ(latch.remaining(), 1);
+    latch.count_down();
+    ASSERT_TRUE(latch.get());
+    ASSERT_EQ(latch.remaining(), 0);
+}
+
+TEST(shared_latch_flag, countDownCanDecrementByMoreThanOne)
+{
+    shared_latch_flag latch{ 5 };
+    latch.count_down(4);
+    ASSERT_FALSE(latch.get());
+    latch.count_down(1);
+    ASSERT_TRUE(latch.get());
+}
+
+TEST(shared_latch_flag, countingDownPastZeroHasNoFurtherEffect)
+{
+    shared_latch_flag latch{ 1 };
+    latch.count_down(3);
+    ASSERT_TRUE(latch.get());
+    latch.count_down();
+    ASSERT_TRUE(latch.get());
+    ASSERT_EQ(latch.remaining(), 0);
+}
+
+TEST(shared_latch_flag, countDownByZeroDoesNothing)
+{
+    shared_latch_flag latch{ 1 };
+    latch.count_down(0);
+    ASSERT_FALSE(latch.get());
+}
+
+TEST(shared_latch_flag, countDownThrowsIfUpdateIsNegative)
+{
+    shared_latch_flag latch{ 1 };
+    ASSERT_THROW(latch.count_down(-1), std::invalid_argument);
+    ASSERT_EQ(latch.remaining(), 1);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// readers
+
+TEST(shared_latch_flag, readerCopiedFromLatchIsSetWhenCountReachesZero)
+{
+    shared_latch_flag latch{ 1 };
+    shared_flag_reader reader{ latch };
+    ASSERT_FALSE(reader.get());
+    latch.count_down();
+    ASSERT_TRUE(reader.get());
+}
+
+TEST(shared_latch_flag, waitReturnsWhenEveryPartyHasCountedDown)
+{
+    constexpr int parties{ 8 };
+    shared_latch_flag latch{ parties };
+    auto waiter{ std::async(std::launch::async, [](shared_flag_reader reader) { reader.wait(); }, latch) };
+
+    std::vector<std::future<void>> tasks;
+    for (int i{ 0 }; i < parties - 1; ++i)
+        tasks.push_back(std::async(std::launch::async, [latch]() mutable { latch.count_down(); }));
+    for (auto & task : tasks)
+        task.get();
+
+    std::this_thread::sleep_for(150ms);
+    ASSERT_EQ(waiter.wait_for(0ms), std::future_status::timeout);
+    latch.count_down();
+    ASSERT_EQ(waiter.wait_for(10s), std::future_status::ready);
+}
+
+TEST(shared_latch_flag, latchCanBeUsedWithOtherFlags)
+{
+    shared_latch_flag latch{ 1 };
+    shared_flag timeout;
+    shared_flag child{ child_of, latch };
+    ASSERT_EQ(wait_any_for(10ms, latch, timeout), std::nullopt);
+    latch.count_down();
+    ASSERT_EQ(wait_any(timeout, latch), 1U);
+    ASSERT_TRUE(child.get());
+}
@@ -0,0 +1,157 @@
+/**
+ * @file signal_flag.test.cpp
+ * @brief Defines unit tests for setting flags when the process receives a signal.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#if defined(__linux__)
+
+#include "shared_flag/signal_flag.hpp"
+#include "shared_flag/flag_callback.hpp"
+#include "shared_flag/shared_flag.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <gtest/gtest.h>
+#include <signal.h>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+
+using namespace std::literals;
+using namespace prb;
+
+namespace
+{
+    // There's only one shutdown flag per process, and it can't be cleared. Each test therefore runs
+    //  its body in a fresh copy of the test executable, so that the tests don't depend on running
+    //  order or on the test runner. The "threadsafe" style re-runs the executable rather than just
+    //  forking, which is safe even if other tests have left threads running.
+    //
+    // The body returns null on success, or a description of the first check which failed. The
+    //  previous death test style is restored afterwards, so other tests aren't affected.
+    template <class Function>
+    void run_in_own_process(Function function)
+    {
+        const std::string previous_style{ ::testing::FLAGS_gtest_death_test_style };
+        ::testing::FLAGS_gtest_death_test_style = "threadsafe";
+        EXPECT_EXIT(
+            {
+                const char * failure{ function() };
+                if (failure)
+                    std::fprintf(stderr, "%s", failure);
+                std::_Exit(failure ? 1 : 0);
+            },
+            ::testing::ExitedWithCode(0),
+            ""
+        );
+        ::testing::FLAGS_gtest_death_test_style = previous_style;
+    }
+}
+
+// Note: these tests use SIGUSR1 and SIGUSR2 so that they don't interfere with the test runner's own
+//  handling of SIGINT and SIGTERM.
+
+
+//--------------------------------------------------------------------------------------------------
+// shutdown_on_signals()
+
+TEST(signal_flag, shutdownFlagIsNotSetInitially)
+{
+    run_in_own_process([]() -> const char *
+    {
+        const auto shutdown{ shutdown_on_signals({ SIGUSR1 }) };
+        if (shutdown.get())
+            return "The shutdown flag was set before any signal was received.";
+        return nullptr;
+    });
+}
+
+TEST(signal_flag, shutdownFlagIsSetWhenASignalIsReceived)
+{
+    run_in_own_process([]() -> const char *
+    {
+        const auto shutdown{ shutdown_on_signals({ SIGUSR1, SIGUSR2 }) };
+        raise(SIGUSR2);
+        if (!shutdown.get())
+            return "The shutdown flag was not set by the signal.";
+        return nullptr;
+    });
+}
+
+TEST(signal_flag, shutdownFlagIsTheSameForEveryCall)
+{
+    run_in_own_process([]() -> const char *
+    {
+        const auto shutdown1{ shutdown_on_signals({ SIGUSR1 }) };
+        const auto shutdown2{ shutdown_on_signals({ SIGUSR2 }) };
+        raise(SIGUSR2);
+        if (!shutdown1.get() || !shutdown2.get())
+            return "Both handles should refer to the same flag.";
+        return nullptr;
+    });
+}
+
+TEST(signal_flag, signalWakesThreadsWaitingOnShutdownFlag)
+{
+    run_in_own_process([]() -> const char *
+    {
+        const auto shutdown{ shutdown_on_signals({ SIGUSR1 }) };
+        auto task{ std::async(std::launch::async, [shutdown] { shutdown.wait(); }) };
+        std::this_thread::sleep_for(150ms);
+        raise(SIGUSR1);
+        if (task.wait_for(10s) != std::future_status::ready)
+            return "The waiting thread was not woken by the signal.";
+        return nullptr;
+    });
+}
+
+TEST(signal_flag, signalCanBeSentFromAnotherThread)
+{
+    run_in_own_process([]() -> const char *
+    {
+        const auto shutdown{ shutdown_on_signals({ SIGUSR1 }) };
+        std::thread{ [] { kill(getpid(), SIGUSR1); } }.join();
+        if (!shutdown.wait_for(10s))
+            return "The shutdown flag was not set by a signal sent from another thread.";
+        return nullptr;
+    });
+}
+
+TEST(signal_flag, signalSetsChildrenAndCallsCallbacksOfShutdownFlag)
+{
+    run_in_own_process([]() -> const char *
+    {
+        const auto shutdown{ shutdown_on_signals({ SIGUSR1 }) };
+        shared_flag child{ child_of, shutdown };
+        std::promise<void> called;
+        flag_callback callback{ shutdown, [&] { called.set_value(); } };
+
+        raise(SIGUSR1);
+        if (!child.wait_for(10s))
+            return "The child flag was not set.";
+        if (called.get_future().wait_for(10s) != std::future_status::ready)
+            return "The callback was not called.";
+        return nullptr;
+    });
+}
+
+TEST(signal_flag, shutdownOnSignalsThrowsSystemErrorIfSignalCannotBeHandled)
+{
+    run_in_own_process([]() -> const char *
+    {
+        try
+        {
+            shutdown_on_signals({ SIGKILL });
+        }
+        catch (const std::system_error &)
+        {
+            return nullptr;
+        }
+        return "No std::system_error was thrown for SIGKILL.";
+    });
+}
+
+#endif
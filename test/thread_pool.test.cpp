@@ -0,0 +1,354 @@
+/**
+ * @file thread_pool.test.cpp
+ * @brief Defines unit tests for the thread_pool class.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include "shared_flag/compact_shared_flag.hpp"
+#include "shared_flag/shared_flag.hpp"
+#include "shared_flag/shared_latch_flag.hpp"
+#include "shared_flag/thread_pool.hpp"
+#include <atomic>
+#include <future>
+#include <gtest/gtest.h>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std::literals;
+using namespace prb;
+
+namespace
+{
+    // Counts down a latch when it's destroyed, whether or not the task which owns it has run.
+    class count_down_on_destroy
+    {
+    public:
+        explicit count_down_on_destroy(shared_latch_flag latch) :
+            m_latch{ std::move(latch) }
+        {
+        }
+
+        count_down_on_destroy(count_down_on_destroy && other) noexcept :
+            m_latch{ other.m_latch },
+            m_owner{ std::exchange(other.m_owner, false) }
+        {
+        }
+
+        ~count_down_on_destroy()
+        {
+            if (m_owner)
+                m_latch.count_down();
+        }
+
+    private:
+        shared_latch_flag m_latch;
+        bool m_owner{ true };
+    };
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// constructor
+
+TEST(thread_pool, constructorStartsTheRequestedNumberOfThreads)
+{
+    thread_pool pool{ 3U };
+    ASSERT_EQ(pool.thread_count(), 3U);
+    ASSERT_FALSE(pool.get_stop_flag().get());
+}
+
+TEST(thread_pool, constructorThrowsIfThreadCountIsZero)
+{
+    ASSERT_THROW(thread_pool{ 0U }, std::invalid_argument);
+}
+
+TEST(thread_pool, defaultConstructorUsesTheHardwareConcurrency)
+{
+    thread_pool pool;
+    ASSERT_EQ(pool.thread_count(), thread_pool::default_thread_count());
+    ASSERT_GE(pool.thread_count(), 1U);
+}
+
+TEST(thread_pool, poolIsStoppedWhenAParentIsSet)
+{
+    shared_flag shutdown;
+    compact_shared_flag other;
+    thread_pool pool{ 2U, child_of, shutdown, other };
+    ASSERT_FALSE(pool.get_stop_flag().get());
+    shutdown.set();
+    ASSERT_TRUE(pool.get_stop_flag().get());
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// submit()
+
+TEST(thread_pool, everyTaskIsRun)
+{
+    constexpr int count{ 1000 };
+    thread_pool pool{ 4U };
+    shared_latch_flag done{ count };
+    std::atomic<int> total{ 0 };
+    for (int i{ 0 }; i < count; ++i)
+    {
+        ASSERT_TRUE(pool.submit([&total, done, i]() mutable
+        {
+            total += i;
+            done.count_down();
+        }));
+    }
+    ASSERT_TRUE(done.wait_for(10s));
+    ASSERT_EQ(total, count * (count - 1) / 2);
+    ASSERT_EQ(pool.discarded_count(), 0U);
+}
+
+TEST(thread_pool, tasksRunOnTheWorkerThreads)
+{
+    thread_pool pool{ 2U };
+    std::promise<std::thread::id> id;
+    auto future{ id.get_future() };
+    pool.submit([&id] { id.set_value(std::this_thread::get_id()); });
+    ASSERT_NE(future.get(), std::this_thread::get_id());
+}
+
+TEST(thread_pool, taskWithoutItsOwnFlagReceivesThePoolFlag)
+{
+    thread_pool pool{ 1U };
+    std::promise<bool> result;
+    auto future{ result.get_future() };
+    pool.submit([&result](const shared_flag_reader & flag)
+    {
+        result.set_value(flag.valid() && !flag.get());
+    });
+    ASSERT_TRUE(future.get());
+}
+
+TEST(thread_pool, taskWithItsOwnFlagReceivesIt)
+{
+    thread_pool pool{ 1U };
+    shared_flag cancel;
+    std::promise<void> started;
+    auto started_future{ started.get_future() };
+    std::promise<bool> result;
+    auto future{ result.get_future() };
+    pool.submit(cancel, [&started, &result](const shared_flag_reader & flag)
+    {
+        started.set_value();
+        result.set_value(flag.wait_for(10s));
+    });
+    started_future.get();
+    cancel.set();
+    ASSERT_TRUE(future.get());
+    ASSERT_FALSE(pool.get_stop_flag().get());
+}
+
+TEST(thread_pool, taskWhichIsAlreadyCancelledIsNotQueued)
+{
+    thread_pool pool{ 1U };
+    shared_flag cancel;
+    cancel.set();
+    bool ran{ false };
+    ASSERT_FALSE(pool.submit(cancel, [&ran] { ran = true; }));
+    ASSERT_EQ(pool.discarded_count(), 1U);
+    ASSERT_FALSE(ran);
+}
+
+TEST(thread_pool, cancelledTasksAreDiscardedWithoutRunning)
+{
+    constexpr int count{ 100 };
+    thread_pool pool{ 2U };
+
+    // Block both workers, so that the other tasks stay in the queues.
+    shared_flag release;
+    shared_latch_flag blocked{ 2 };
+    for (int i{ 0 }; i < 2; ++i)
+    {
+        pool.submit([release, blocked]() mutable
+        {
+            blocked.count_down();
+            release.wait();
+        });
+    }
+    ASSERT_TRUE(blocked.wait_for(10s));
+
+    shared_flag cancel;
+    shared_latch_flag done{ count };
+    std::atomic<int> ran{ 0 };
+    for (int i{ 0 }; i < count; ++i)
+    {
+        const bool cancelled{ i % 2 == 0 };
+        shared_flag flag{ cancelled ? cancel : shared_flag{} };
+        ASSERT_TRUE(pool.submit(flag, [&ran, guard = count_down_on_destroy{ done }] { ++ran; }));
+    }
+
+    cancel.set();
+    release.set();
+    ASSERT_TRUE(done.wait_for(10s));
+    ASSERT_EQ(ran, count / 2);
+    ASSERT_EQ(pool.discarded_count(), static_cast<std::size_t>(count / 2));
+}
+
+TEST(thread_pool, tasksCanSubmitMoreTasks)
+{
+    constexpr int depth{ 100 };
+    thread_pool pool{ 2U };
+    shared_latch_flag done{ depth };
+
+    struct chain
+    {
+        thread_pool * pool;
+        shared_latch_flag done;
+        int remaining;
+
+        void operator()()
+        {
+            done.count_down();
+            if (remaining > 1)
+                pool->submit(chain{ pool, done, remaining - 1 });
+        }
+    };
+
+    pool.submit(chain{ &pool, done, depth });
+    ASSERT_TRUE(done.wait_for(10s));
+}
+
+TEST(thread_pool, idleWorkersStealQueuedTasks)
+{
+    // One task submits lots of slow tasks to its own worker's queue. The other workers have to
+    //  steal them for them all to run on more than one thread.
+    constexpr int count{ 40 };
+    thread_pool pool{ 4U };
+    shared_latch_flag done{ count };
+    std::mutex mtx;
+    std::set<std::thread::id> threads;
+
+    pool.submit([&]
+    {
+        for (int i{ 0 }; i < count; ++i)
+        {
+            pool.submit([&]
+            {
+                std::this_thread::sleep_for(5ms);
+                {
+                    const std::lock_guard<std::mutex> lock{ mtx };
+                    threads.insert(std::this_thread::get_id());
+                }
+                done.count_down();
+            });
+        }
+    });
+
+    ASSERT_TRUE(done.wait_for(10s));
+    ASSERT_GT(threads.size(), 1U);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// stop()
+
+TEST(thread_pool, submitFailsAfterThePoolIsStopped)
+{
+    thread_pool pool{ 1U };
+    pool.stop();
+    bool ran{ false };
+    ASSERT_FALSE(pool.submit([&ran] { ran = true; }));
+    ASSERT_TRUE(pool.get_stop_flag().get());
+}
+
+TEST(thread_pool, stoppingThePoolInterruptsTasksWhichUseItsFlag)
+{
+    auto pool{ std::make_unique<thread_pool>(2U) };
+    std::promise<void> started;
+    auto future{ started.get_future() };
+    pool->submit([&started](const shared_flag_reader & stop)
+    {
+        started.set_value();
+        stop.wait();
+    });
+    future.get();
+
+    auto destroyed{ std::async(std::launch::async, [&pool] { pool.reset(); }) };
+    ASSERT_EQ(destroyed.wait_for(10s), std::future_status::ready);
+}
+
+TEST(thread_pool, stoppingThePoolInterruptsTasksWithTheirOwnFlag)
+{
+    auto pool{ std::make_unique<thread_pool>(1U) };
+    const shared_flag cancel;
+    std::promise<void> started;
+    auto future{ started.get_future() };
+    pool->submit(cancel, [&started](const shared_flag_reader & stop)
+    {
+        started.set_value();
+        stop.wait();
+    });
+    future.get();
+
+    auto destroyed{ std::async(std::launch::async, [&pool] { pool.reset(); }) };
+    ASSERT_EQ(destroyed.wait_for(10s), std::future_status::ready);
+    ASSERT_FALSE(cancel.get());
+}
+
+TEST(thread_pool, destructorDiscardsQueuedTasks)
+{
+    constexpr int count{ 10 };
+    shared_latch_flag done{ count };
+    std::atomic<int> ran{ 0 };
+    {
+        thread_pool pool{ 1U };
+        shared_flag release;
+        std::promise<void> started;
+        auto future{ started.get_future() };
+        pool.submit([&started, release]
+        {
+            started.set_value();
+            release.wait();
+        });
+        future.get();
+
+        for (int i{ 0 }; i < count; ++i)
+            pool.submit([&ran, guard = count_down_on_destroy{ done }] { ++ran; });
+        pool.stop();
+        release.set();
+    }
+    ASSERT_TRUE(done.get());
+    ASSERT_EQ(ran, 0);
+}
+
+TEST(thread_pool, destructorDiscardsQueuedTasksWithTheirOwnFlag)
+{
+    constexpr int count{ 10 };
+    shared_latch_flag done{ count };
+    std::atomic<int> ran{ 0 };
+    const shared_flag cancel;
+    {
+        thread_pool pool{ 1U };
+        shared_flag release;
+        std::promise<void> started;
+        auto future{ started.get_future() };
+        pool.submit([&started, release]
+        {
+            started.set_value();
+            release.wait();
+        });
+        future.get();
+
+        for (int i{ 0 }; i < count; ++i)
+        {
+            pool.submit(cancel, [&ran, guard = count_down_on_destroy{ done }](const shared_flag_reader &)
+            {
+                ++ran;
+            });
+        }
+        pool.stop();
+        release.set();
+    }
+    ASSERT_TRUE(done.get());
+    ASSERT_EQ(ran, 0);
+    ASSERT_FALSE(cancel.get());
+}
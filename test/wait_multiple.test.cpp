@@ -0,0 +1,366 @@
+/**
+ * @file wait_multiple.test.cpp
+ * @brief Defines unit tests for the functions which wait on multiple shared flags.
+ * @author Peter Bloomfield (https://peter.bloomfield.online)
+ * @copyright MIT License
+ */
+
+#include "shared_flag/compact_shared_flag.hpp"
+#include "shared_flag/shared_flag.hpp"
+#include "shared_flag/wait_multiple.hpp"
+#include <array>
+#include <future>
+#include <gtest/gtest.h>
+#include <list>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace std::literals;
+using namespace prb;
+
+namespace
+{
+    constexpr auto now = std::chrono::steady_clock::now;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// wait_any()
+
+TEST(wait_multiple, waitAnyReturnsImmediatelyIfAFlagWasAlreadySet)
+{
+    shared_flag flag1;
+    shared_flag flag2;
+    flag2.set();
+    ASSERT_EQ(wait_any(flag1, flag2), 1U);
+}
+
+TEST(wait_multiple, waitAnyReturnsLowestIndexIfSeveralFlagsWereAlreadySet)
+{
+    shared_flag flag1;
+    shared_flag flag2;
+    shared_flag flag3;
+    flag2.set();
+    flag3.set();
+    ASSERT_EQ(wait_any(flag1, flag2, flag3), 1U);
+}
+
+TEST(wait_multiple, waitAnyReturnsIndexOfFlagWhichWasSetWhileWaiting)
+{
+    shared_flag flag1;
+    shared_flag flag2;
+    shared_flag flag3;
+    auto task{ std::async(std::launch::async, [&] { return wait_any(flag1, flag2, flag3); }) };
+
+    std::this_thread::sleep_for(150ms);
+    flag3.set();
+    ASSERT_EQ(task.get(), 2U);
+}
+
+TEST(wait_multiple, waitAnySupportsAMixtureOfHandleTypes)
+{
+    shared_flag flag1;
+    compact_shared_flag flag2;
+    const shared_flag_reader reader1{ flag1 };
+    const compact_shared_flag_reader reader2{ flag2 };
+    auto task{ std::async(std::launch::async, [&] { return wait_any(reader1, reader2); }) };
+
+    std::this_thread::sleep_for(150ms);
+    flag2.set();
+    ASSERT_EQ(task.get(), 1U);
+}
+
+TEST(wait_multiple, waitAnySupportsASingleFlag)
+{
+    shared_flag flag;
+    auto task{ std::async(std::launch::async, [&] { return wait_any(flag); }) };
+
+    std::this_thread::sleep_for(150ms);
+    flag.set();
+    ASSERT_EQ(task.get(), 0U);
+}
+
+TEST(wait_multiple, waitAnySupportsMultipleThreadsWaitingOnTheSameFlags)
+{
+    shared_flag flag1;
+    shared_flag flag2;
+    auto function{ [&] { return wait_any(flag1, flag2); } };
+    auto task1{ std::async(std::launch::async, function) };
+    auto task2{ std::async(std::launch::async, function) };
+    auto task3{ std::async(std::launch::async, function) };
+
+    std::this_thread::sleep_for(150ms);
+    flag1.set();
+    ASSERT_EQ(task1.get(), 0U);
+    ASSERT_EQ(task2.get(), 0U);
+    ASSERT_EQ(task3.get(), 0U);
+}
+
+TEST(wait_multiple, waitAnyThrowsLogicErrorIfAHandleHasNoSharedState)
+{
+    shared_flag flag1;
+    shared_flag flag2;
+    shared_flag flag3{ std::move(flag2) };
+    ASSERT_THROW(wait_any(flag1, flag2), std::logic_error);
+}
+
+TEST(wait_multiple, waitAnyWithRangeReturnsIndexOfFlagWhichWasSetWhileWaiting)
+{
+    std::vector<shared_flag> flags(5U);
+    auto task{ std::async(std::launch::async, [&] { return wait_any(flags); }) };
+
+    std::this_thread::sleep_for(150ms);
+    flags[3].set();
+    ASSERT_EQ(task.get(), 3U);
+}
+
+TEST(wait_multiple, waitAnyWithRangeSupportsNonContiguousRanges)
+{
+    std::list<compact_shared_flag> flags(3U);
+    std::next(flags.begin())->set();
+    ASSERT_EQ(wait_any(flags), 1U);
+}
+
+TEST(wait_multiple, waitAnyWithRangeThrowsInvalidArgumentIfRangeIsEmpty)
+{
+    const std::vector<shared_flag_reader> flags;
+    ASSERT_THROW(wait_any(flags), std::invalid_argument);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// wait_any_for()
+
+TEST(wait_multiple, waitAnyForReturnsIndexIfAFlagWasAlreadySet)
+{
+    shared_flag flag1;
+    shared_flag flag2;
+    flag1.set();
+    ASSERT_EQ(wait_any_for(10ms, flag1, flag2), 0U);
+}
+
+TEST(wait_multiple, waitAnyForReturnsIndexOfFlagWhichWasSetWhileWaiting)
+{
+    shared_flag flag1;
+    shared_flag flag2;
+    auto task{ std::async(std::launch::async, [&] { return wait_any_for(2s, flag1, flag2); }) };
+
+    std::this_thread::sleep_for(150ms);
+    flag2.set();
+    ASSERT_EQ(task.get(), 1U);
+}
+
+TEST(wait_multiple, waitAnyForReturnsEmptyIfNoFlagWasSetBeforeTimeout)
+{
+    shared_flag flag1;
+    compact_shared_flag flag2;
+    const auto start{ now() };
+    ASSERT_FALSE(wait_any_for(150ms, flag1, flag2));
+    ASSERT_GE(now() - start, 150ms);
+}
+
+TEST(wait_multiple, waitAnyForReturnsImmediatelyIfTimeoutIsZero)
+{
+    shared_flag flag1;
+    shared_flag flag2;
+    const auto start{ now() };
+    ASSERT_FALSE(wait_any_for(0ms, flag1, flag2));
+    ASSERT_LT(now() - start, 100ms);
+}
+
+TEST(wait_multiple, waitAnyForDoesNotLeaveListenersRegisteredAfterTimeout)
+{
+    shared_flag flag1;
+    shared_flag flag2;
+    for (int i{ 0 }; i < 10; ++i)
+        ASSERT_FALSE(wait_any_for(1ms, flag1, flag2));
+
+    // If a listener had been left behind, setting the flags would access a dead stack frame.
+    flag1.set();
+    flag2.set();
+    ASSERT_EQ(wait_any_for(0ms, flag1, flag2), 0U);
+}
+
+TEST(wait_multiple, waitAnyForWithRangeReturnsEmptyIfNoFlagWasSetBeforeTimeout)
+{
+    const std::vector<shared_flag> flags(3U);
+    ASSERT_FALSE(wait_any_for(50ms, flags));
+}
+
+TEST(wait_multiple, waitAnyForWithRangeThrowsInvalidArgumentIfRangeIsEmpty)
+{
+    const std::vector<compact_shared_flag_reader> flags;
+    ASSERT_THROW(wait_any_for(10ms, flags), std::invalid_argument);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// wait_any_until()
+
+TEST(wait_multiple, waitAnyUntilReturnsIndexOfFlagWhichWasSetWhileWaiting)
+{
+    shared_flag flag1;
+    shared_flag flag2;
+    auto task{ std::async(std::launch::async, [&] { return wait_any_until(now() + 2s, flag1, flag2); }) };
+
+    std::this_thread::sleep_for(150ms);
+    flag1.set();
+    ASSERT_EQ(task.get(), 0U);
+}
+
+TEST(wait_multiple, waitAnyUntilReturnsEmptyIfNoFlagWasSetBeforeTimeout)
+{
+    shared_flag flag1;
+    shared_flag flag2;
+    const auto deadline{ now() + 150ms };
+    ASSERT_FALSE(wait_any_until(deadline, flag1, flag2));
+    ASSERT_GE(now(), deadline);
+}
+
+TEST(wait_multiple, waitAnyUntilSupportsSystemClock)
+{
+    shared_flag flag1;
+    shared_flag flag2;
+    ASSERT_FALSE(wait_any_until(std::chrono::system_clock::now() + 50ms, flag1, flag2));
+    flag2.set();
+    ASSERT_EQ(wait_any_until(std::chrono::system_clock::now() + 50ms, flag1, flag2), 1U);
+}
+
+TEST(wait_multiple, waitAnyUntilWithRangeReturnsIndexOfFlagWhichWasAlreadySet)
+{
+    std::array<shared_flag, 3U> flags;
+    flags[2].set();
+    ASSERT_EQ(wait_any_until(now() + 10ms, flags), 2U);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// wait_all()
+
+TEST(wait_multiple, waitAllReturnsImmediatelyIfAllFlagsWereAlreadySet)
+{
+    shared_flag flag1;
+    compact_shared_flag flag2;
+    flag1.set();
+    flag2.set();
+    wait_all(flag1, flag2);
+    SUCCEED();
+}
+
+TEST(wait_multiple, waitAllReturnsOnlyWhenAllFlagsHaveBeenSet)
+{
+    shared_flag flag1;
+    shared_flag flag2;
+    shared_flag flag3;
+    auto task{ std::async(std::launch::async, [&] { wait_all(flag1, flag2, flag3); }) };
+
+    flag2.set();
+    std::this_thread::sleep_for(50ms);
+    flag1.set();
+    ASSERT_EQ(task.wait_for(100ms), std::future_status::timeout);
+
+    flag3.set();
+    task.get();
+    SUCCEED();
+}
+
+TEST(wait_multiple, waitAllWithRangeReturnsImmediatelyIfRangeIsEmpty)
+{
+    const std::vector<shared_flag> flags;
+    wait_all(flags);
+    SUCCEED();
+}
+
+TEST(wait_multiple, waitAllWithRangeReturnsOnlyWhenAllFlagsHaveBeenSet)
+{
+    std::vector<compact_shared_flag> flags(4U);
+    auto task{ std::async(std::launch::async, [&] { wait_all(flags); }) };
+
+    std::this_thread::sleep_for(50ms);
+    for (auto & flag : flags)
+        flag.set();
+    task.get();
+    SUCCEED();
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// wait_all_for() / wait_all_until()
+
+TEST(wait_multiple, waitAllForReturnsTrueIfAllFlagsWereSetWhileWaiting)
+{
+    shared_flag flag1;
+    shared_flag flag2;
+    auto task{ std::async(std::launch::async, [&] { return wait_all_for(2s, flag1, flag2); }) };
+
+    std::this_thread::sleep_for(50ms);
+    flag1.set();
+    std::this_thread::sleep_for(50ms);
+    flag2.set();
+    ASSERT_TRUE(task.get());
+}
+
+TEST(wait_multiple, waitAllForReturnsFalseIfAnyFlagWasNotSetBeforeTimeout)
+{
+    shared_flag flag1;
+    shared_flag flag2;
+    flag1.set();
+    const auto start{ now() };
+    ASSERT_FALSE(wait_all_for(150ms, flag1, flag2));
+    ASSERT_GE(now() - start, 150ms);
+}
+
+TEST(wait_multiple, waitAllForWithRangeReturnsTrueIfRangeIsEmpty)
+{
+    const std::vector<shared_flag_reader> flags;
+    ASSERT_TRUE(wait_all_for(0ms, flags));
+}
+
+TEST(wait_multiple, waitAllUntilReturnsFalseIfAnyFlagWasNotSetBeforeTimeout)
+{
+    shared_flag flag1;
+    shared_flag flag2;
+    flag2.set();
+    ASSERT_FALSE(wait_all_until(now() + 50ms, flag1, flag2));
+}
+
+TEST(wait_multiple, waitAllUntilWithRangeReturnsTrueIfAllFlagsWereAlreadySet)
+{
+    std::vector<shared_flag> flags(3U);
+    for (auto & flag : flags)
+        flag.set();
+    ASSERT_TRUE(wait_all_until(std::chrono::system_clock::now() + 10ms, flags));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// overload resolution
+
+TEST(wait_multiple, rangeOverloadsAreNotViableForNonHandleRanges)
+{
+    auto is_callable{ [](auto && arg) -> decltype(wait_any(arg), std::true_type{}) { return {}; } };
+    ASSERT_TRUE((std::is_invocable_v<decltype(is_callable), std::vector<shared_flag> &>));
+    ASSERT_FALSE((std::is_invocable_v<decltype(is_callable), std::vector<int> &>));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// concurrency
+
+TEST(wait_multiple, waitAnyIsSafeWhenFlagsAreSetConcurrentlyWithReturning)
+{
+    // Repeatedly race the waiting thread returning against other threads setting the flags, so
+    //  that listeners are removed while they're being called.
+    for (int i{ 0 }; i < 200; ++i)
+    {
+        shared_flag flag1;
+        shared_flag flag2;
+        auto setter1{ std::async(std::launch::async, [&] { flag1.set(); }) };
+        auto setter2{ std::async(std::launch::async, [&] { flag2.set(); }) };
+        const auto index{ wait_any(flag1, flag2) };
+        ASSERT_LT(index, 2U);
+        setter1.get();
+        setter2.get();
+    }
+}